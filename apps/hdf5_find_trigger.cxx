@@ -0,0 +1,60 @@
+/**
+ * @file hdf5_find_trigger.cxx
+ *
+ * Locates records in the raw data files of a run with the trigger manifest written
+ * by the HDF5DataStore: the file, sequence number and offset of the record header
+ * of every sequence of each requested trigger are printed.
+ *
+ * Usage: hdf5_find_trigger <manifest> <trigger number> [trigger number ...]
+ * The exit status is 0 if all the triggers were found, 1 if some weren't, and 2 if
+ * the manifest could not be read.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/TriggerManifest.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace dunedaq::dfmodules;
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <manifest> <trigger number> [trigger number ...]" << std::endl;
+    return 2;
+  }
+
+  try {
+    TriggerManifest manifest(argv[1]);
+    std::cout << argv[1] << ": " << manifest.get_entry_count() << " records in " << manifest.get_file_names().size()
+              << " files" << std::endl;
+
+    bool all_found = true;
+    for (int i = 2; i < argc; ++i) {
+      uint64_t trigger_number = std::strtoull(argv[i], nullptr, 10); // NOLINT(build/unsigned)
+      auto locations = manifest.find(trigger_number);
+      if (locations.empty()) {
+        std::cout << "Trigger " << trigger_number << ": not found" << std::endl;
+        all_found = false;
+      }
+      for (const auto& location : locations) {
+        std::cout << "Trigger " << trigger_number << " sequence " << location.sequence_number << ": "
+                  << location.file_name;
+        if (location.offset != TriggerManifestWriter::s_unknown_offset) {
+          std::cout << " at offset " << location.offset;
+        }
+        std::cout << std::endl;
+      }
+    }
+    return all_found ? 0 : 1;
+  } catch (TriggerManifestProblem const& excpt) {
+    std::cerr << excpt.what() << std::endl;
+    return 2;
+  }
+}
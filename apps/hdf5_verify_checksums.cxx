@@ -0,0 +1,199 @@
+/**
+ * @file hdf5_verify_checksums.cxx
+ *
+ * Verifies the Fragment checksums stored by the HDF5DataStore in a raw data file:
+ * every Fragment dataset of every record that has checksums is read, its CRC32C is
+ * computed on a pool of threads, and compared with the stored value.
+ *
+ * Usage: hdf5_verify_checksums <file> [threads]
+ * The exit status is 0 if all the checksums match, 1 if some don't, and 2 if the
+ * file could not be read.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/CRC32C.hpp"
+#include "dfmodules/FragmentChecksums.hpp"
+#include "dfmodules/WorkerPool.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+
+#include "hdf5.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+using source_key_t = std::pair<uint32_t, uint32_t>; // NOLINT(build/unsigned)
+
+struct Counters
+{
+  std::atomic<size_t> records_checked{ 0 };
+  std::atomic<size_t> records_without_checksums{ 0 };
+  std::atomic<size_t> fragments_verified{ 0 };
+  std::atomic<size_t> fragments_corrupted{ 0 };
+  std::atomic<size_t> fragments_without_checksum{ 0 };
+  std::atomic<size_t> fragments_missing{ 0 };
+};
+
+std::mutex g_output_mutex;
+
+herr_t
+collect_names(hid_t /*group*/, const char* name, const H5L_info_t* /*info*/, void* data)
+{
+  static_cast<std::vector<std::string>*>(data)->push_back(name);
+  return 0;
+}
+
+std::shared_ptr<std::vector<char>>
+read_dataset(hid_t group_id, const std::string& path)
+{
+  hid_t object_id = H5Oopen(group_id, path.c_str(), H5P_DEFAULT);
+  if (object_id < 0) {
+    return nullptr;
+  }
+  if (H5Iget_type(object_id) != H5I_DATASET) {
+    H5Oclose(object_id);
+    return nullptr;
+  }
+  hid_t dataset_id = object_id;
+  hid_t space_id = H5Dget_space(dataset_id);
+  hid_t type_id = H5Dget_type(dataset_id);
+  hssize_t size = H5Sget_simple_extent_npoints(space_id) * H5Tget_size(type_id);
+  std::shared_ptr<std::vector<char>> buffer;
+  if (size >= 0) {
+    buffer = std::make_shared<std::vector<char>>(size);
+    if (H5Dread(dataset_id, type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buffer->data()) < 0) {
+      buffer.reset();
+    }
+  }
+  H5Tclose(type_id);
+  H5Sclose(space_id);
+  H5Dclose(dataset_id);
+  return buffer;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <file> [threads]" << std::endl;
+    return 2;
+  }
+  std::string file_name = argv[1];
+  size_t thread_count = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+
+  hid_t file_id = H5Fopen(file_name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file_id < 0) {
+    std::cerr << "Unable to open " << file_name << std::endl;
+    return 2;
+  }
+
+  // The HDF5 library is only used from this thread; the datasets are read here and
+  // their checksums are computed and compared by the pool, which bounds the number
+  // of datasets in memory
+  Counters counters;
+  WorkerPool pool(thread_count, "verify");
+  std::deque<std::future<void>> in_flight;
+  size_t max_in_flight = 4 * pool.get_thread_count();
+
+  std::vector<std::string> record_names;
+  H5Literate(file_id, H5_INDEX_NAME, H5_ITER_INC, nullptr, collect_names, &record_names);
+  for (const auto& record_name : record_names) {
+    hid_t group_id = H5Gopen2(file_id, record_name.c_str(), H5P_DEFAULT);
+    if (group_id < 0) {
+      continue;
+    }
+    std::vector<FragmentChecksum> checksums;
+    if (!FragmentChecksums::read_attribute(group_id, checksums)) {
+      ++counters.records_without_checksums;
+      H5Gclose(group_id);
+      continue;
+    }
+    ++counters.records_checked;
+
+    auto expected = std::make_shared<std::map<source_key_t, uint32_t>>(); // NOLINT(build/unsigned)
+    for (const auto& checksum : checksums) {
+      (*expected)[{ checksum.subsystem, checksum.source_id }] = checksum.crc32c;
+    }
+    auto found = std::make_shared<std::atomic<size_t>>(0);
+
+    std::vector<std::string> object_paths;
+    H5Lvisit(group_id, H5_INDEX_NAME, H5_ITER_INC, collect_names, &object_paths);
+    for (const auto& dataset_path : object_paths) {
+      auto buffer = read_dataset(group_id, dataset_path);
+      if (!buffer || buffer->size() < sizeof(daqdataformats::FragmentHeader)) {
+        continue;
+      }
+      daqdataformats::FragmentHeader header;
+      memcpy(&header, buffer->data(), sizeof(header));
+      if (header.fragment_header_marker != daqdataformats::FragmentHeader::s_fragment_header_marker) {
+        // e.g. the record header
+        continue;
+      }
+
+      while (in_flight.size() >= max_in_flight) {
+        in_flight.front().get();
+        in_flight.pop_front();
+      }
+      std::string path = record_name + "/" + dataset_path;
+      source_key_t key{ static_cast<uint32_t>(header.element_id.subsystem), header.element_id.id };
+      in_flight.push_back(pool.submit([&counters, expected, found, key, path, data = buffer]() {
+        auto entry = expected->find(key);
+        if (entry == expected->end()) {
+          ++counters.fragments_without_checksum;
+          return;
+        }
+        ++(*found);
+        uint32_t crc = CRC32C::compute(data->data(), data->size()); // NOLINT(build/unsigned)
+        if (crc == entry->second) {
+          ++counters.fragments_verified;
+        } else {
+          ++counters.fragments_corrupted;
+          std::lock_guard<std::mutex> lk(g_output_mutex);
+          std::cout << "Checksum mismatch for " << path << ": stored 0x" << std::hex << entry->second << ", computed 0x"
+                    << crc << std::dec << std::endl;
+        }
+      }));
+    }
+    H5Gclose(group_id);
+
+    // Fragments that have a checksum but no dataset are counted once the record is done
+    while (!in_flight.empty()) {
+      in_flight.front().get();
+      in_flight.pop_front();
+    }
+    if (found->load() < expected->size()) {
+      counters.fragments_missing += expected->size() - found->load();
+      std::cout << "Record " << record_name << ": " << expected->size() - found->load()
+                << " Fragments with a checksum have no dataset" << std::endl;
+    }
+  }
+  H5Fclose(file_id);
+
+  std::cout << file_name << ": " << counters.records_checked << " records checked, "
+            << counters.records_without_checksums << " without checksums; " << counters.fragments_verified
+            << " Fragments verified, " << counters.fragments_corrupted << " corrupted, " << counters.fragments_missing
+            << " missing, " << counters.fragments_without_checksum << " without checksum" << std::endl;
+
+  return (counters.fragments_corrupted > 0 || counters.fragments_missing > 0) ? 1 : 0;
+}
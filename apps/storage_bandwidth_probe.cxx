@@ -0,0 +1,90 @@
+/**
+ * @file storage_bandwidth_probe.cxx
+ *
+ * Measures the sustained sequential write bandwidth, and the write latency, of a
+ * directory with the StorageBandwidthProbe that the HDF5DataStore can run when a
+ * run is prepared, so that a candidate output directory can be checked by hand.
+ *
+ * Usage: storage_bandwidth_probe [-b bytes_per_block_size] [-s sync_interval_bytes]
+ *                                [-t max_duration_ms] [-r expected_rate_bytes_per_s]
+ *                                <directory> [block_size_bytes ...]
+ * The exit status is 0 if all the block sizes sustain the expected rate, 1 if some
+ * don't, and 2 if the measurement failed.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/StorageBandwidthProbe.hpp"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::dfmodules;
+
+int
+main(int argc, char* argv[])
+{
+  storageprobe::BandwidthProbe conf;
+  conf.enabled = true;
+
+  int option;
+  while ((option = getopt(argc, argv, "b:s:t:r:")) != -1) {
+    switch (option) {
+      case 'b':
+        conf.bytes_per_block_size = std::strtoull(optarg, nullptr, 0);
+        break;
+      case 's':
+        conf.sync_interval_bytes = std::strtoull(optarg, nullptr, 0);
+        break;
+      case 't':
+        conf.max_duration_ms = std::strtoull(optarg, nullptr, 0);
+        break;
+      case 'r':
+        conf.expected_rate_bytes_per_s = std::strtoull(optarg, nullptr, 0);
+        break;
+      default:
+        optind = argc + 1;
+    }
+  }
+  if (optind >= argc) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-b bytes_per_block_size] [-s sync_interval_bytes] [-t max_duration_ms]"
+                 " [-r expected_rate_bytes_per_s] <directory> [block_size_bytes ...]"
+              << std::endl;
+    return 2;
+  }
+  std::string directory = argv[optind];
+  for (int i = optind + 1; i < argc; ++i) {
+    conf.block_sizes_bytes.push_back(std::strtoull(argv[i], nullptr, 0));
+  }
+
+  StorageBandwidthProbe probe(conf);
+  std::vector<StorageBandwidthProbe::Result> results;
+  try {
+    results = probe.run(directory);
+  } catch (const StorageBandwidthProbeFailed& excpt) {
+    std::cerr << excpt.what() << std::endl;
+    return 2;
+  }
+
+  bool slow = false;
+  std::cout << std::setw(12) << "block_size" << std::setw(14) << "bytes" << std::setw(12) << "MB/s" << std::setw(12)
+            << "p50_us" << std::setw(12) << "p99_us" << std::setw(12) << "max_us" << std::endl;
+  for (const auto& result : results) {
+    bool below = probe.is_below_expected_rate(result);
+    slow = slow || below;
+    std::cout << std::setw(12) << result.block_size << std::setw(14) << result.bytes_written << std::setw(12)
+              << std::fixed << std::setprecision(1) << result.bandwidth_bytes_per_s / 1e6 << std::setw(12)
+              << result.latency_p50.count() << std::setw(12) << result.latency_p99.count() << std::setw(12)
+              << result.latency_max.count() << (below ? "  below the expected rate" : "") << std::endl;
+  }
+  return slow ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file DataRequestBatch.hpp DataRequestBatch message
+ *
+ * A DataRequestBatch carries several DataRequests bound for the same
+ * connection in a single message, so that the per-message transport cost
+ * is paid once for the whole batch.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_INCLUDE_DFMODULES_DATAREQUESTBATCH_HPP_
+#define DFMODULES_INCLUDE_DFMODULES_DATAREQUESTBATCH_HPP_
+
+#include "dfmessages/DataRequest.hpp"
+#include "serialization/Serialization.hpp"
+
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief DataRequests sent together to the same destination, in the order in which they were generated
+ */
+struct DataRequestBatch
+{
+  std::vector<dfmessages::DataRequest> requests;
+
+  DUNE_DAQ_SERIALIZE(DataRequestBatch, requests);
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+DUNE_DAQ_SERIALIZABLE(dunedaq::dfmodules::DataRequestBatch, "DataRequestBatch");
+
+#endif // DFMODULES_INCLUDE_DFMODULES_DATAREQUESTBATCH_HPP_
@@ -22,6 +22,7 @@
 #include "daqdataformats/TriggerRecord.hpp"
 #include "daqdataformats/Types.hpp"
 #include "logging/Logging.hpp"
+#include "opmonlib/InfoCollector.hpp"
 
 #include "nlohmann/json.hpp"
 
@@ -127,9 +128,19 @@ public:
    * with the specified run number have finished, for now.
    * This allows DataStore instances to do any cleanup or shutdown operations
    * that are useful once the writes or reads for a given run number have finished.
+   * These operations may complete after this method has returned, so that the next
+   * run can be prepared without waiting for them; the DataStore destructor then waits
+   * for them.
    */
   virtual void finish_with_run(daqdataformats::run_number_t run_number) = 0;
 
+  /**
+   * @brief Adds the operational monitoring information of the DataStore, if it has any.
+   * This is called from the monitoring thread of the module that owns the DataStore,
+   * concurrently with the other methods.
+   */
+  virtual void get_info(opmonlib::InfoCollector& /*ci*/, int /*level*/) {}
+
 private:
   DataStore(const DataStore&) = delete;
   DataStore& operator=(const DataStore&) = delete;
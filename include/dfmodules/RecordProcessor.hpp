@@ -0,0 +1,141 @@
+/**
+ * @file RecordProcessor.hpp
+ *
+ * This is the interface for the processing stages that the DataWriter runs
+ * on the TriggerRecords before they are written, e.g. to remove Fragments
+ * or filter out records.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_INCLUDE_DFMODULES_RECORDPROCESSOR_HPP_
+#define DFMODULES_INCLUDE_DFMODULES_RECORDPROCESSOR_HPP_
+
+#include "utilities/NamedObject.hpp"
+#include "cetlib/BasicPluginFactory.h"
+#include "cetlib/compiler_macros.h"
+#include "daqdataformats/TriggerRecord.hpp"
+#include "daqdataformats/Types.hpp"
+#include "ers/Issue.hpp"
+#include "opmonlib/InfoCollector.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <memory>
+#include <string>
+
+#ifndef EXTERN_C_FUNC_DECLARE_START
+// NOLINTNEXTLINE(build/define_used)
+#define EXTERN_C_FUNC_DECLARE_START                                                                                    \
+  extern "C"                                                                                                           \
+  {
+#endif
+/**
+ * @brief Declare the function that will be called by the plugin loader
+ * @param klass Class to be defined as a DUNE RecordProcessor
+ */
+// NOLINTNEXTLINE(build/define_used)
+#define DEFINE_DUNE_RECORD_PROCESSOR(klass)                                                                            \
+  EXTERN_C_FUNC_DECLARE_START                                                                                          \
+  std::unique_ptr<dunedaq::dfmodules::RecordProcessor> make(const nlohmann::json& conf)                                \
+  {                                                                                                                    \
+    return std::unique_ptr<dunedaq::dfmodules::RecordProcessor>(new klass(conf));                                      \
+  }                                                                                                                    \
+  }
+
+namespace dunedaq {
+
+/**
+ * @brief An ERS Issue for RecordProcessor creation failure
+ * @cond Doxygen doesn't like ERS macros LCOV_EXCL_START
+ */
+ERS_DECLARE_ISSUE(dfmodules,                     ///< Namespace
+                  RecordProcessorCreationFailed, ///< Type of the Issue
+                  "Failed to create RecordProcessor " << plugin_name << " with configuration "
+                                                      << conf,     ///< Log Message from the issue
+                  ((std::string)plugin_name)((nlohmann::json)conf) ///< Message parameters
+)
+/// @endcond LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief A RecordProcessor transforms or filters the TriggerRecords before they are written.
+ *
+ * The DataWriter calls process() on several threads at once, each time with a different
+ * TriggerRecord, so the implementations must not modify shared state without protecting it.
+ */
+class RecordProcessor : public utilities::NamedObject
+{
+public:
+  /**
+   * @brief RecordProcessor Constructor
+   * @param name Name of the RecordProcessor instance
+   */
+  explicit RecordProcessor(const std::string& name)
+    : utilities::NamedObject(name)
+  {}
+
+  /**
+   * @brief Processes the TriggerRecord in place, e.g. removes or replaces some of its Fragments.
+   * @param tr TriggerRecord to process.
+   * @return false if the TriggerRecord should not be written at all
+   */
+  virtual bool process(daqdataformats::TriggerRecord& tr) = 0;
+
+  /**
+   * @brief Informs the RecordProcessor that the records of the specified run will soon be processed.
+   */
+  virtual void prepare_for_run(daqdataformats::run_number_t /*run_number*/) {}
+
+  /**
+   * @brief Adds the operational monitoring information of the RecordProcessor, if it has any.
+   * This is called from the monitoring thread of the DataWriter, concurrently with process().
+   */
+  virtual void get_info(opmonlib::InfoCollector& /*ci*/, int /*level*/) {}
+
+private:
+  RecordProcessor(const RecordProcessor&) = delete;
+  RecordProcessor& operator=(const RecordProcessor&) = delete;
+  RecordProcessor(RecordProcessor&&) = default;
+  RecordProcessor& operator=(RecordProcessor&&) = default;
+};
+
+/**
+ * @brief Load a RecordProcessor plugin and return a unique_ptr to the contained class
+ * @param type Name of the plugin, e.g. EmptyFragmentFilter
+ * @param conf configuration for the RecordProcessor
+ * @return unique_ptr to created RecordProcessor instance
+ */
+inline std::unique_ptr<RecordProcessor>
+make_record_processor(const std::string& type, const nlohmann::json& conf)
+{
+  static cet::BasicPluginFactory bpf("duneRecordProcessor", "make"); // NOLINT
+
+  std::unique_ptr<RecordProcessor> rp;
+  try {
+    rp = bpf.makePlugin<std::unique_ptr<RecordProcessor>>(type, conf);
+  } catch (const cet::exception& cexpt) {
+    throw RecordProcessorCreationFailed(ERS_HERE, type, conf, cexpt);
+  }
+
+  return rp;
+}
+
+/**
+ * @brief Load a RecordProcessor plugin and return a unique_ptr to the contained class
+ * @param conf configuration for the RecordProcessor. The json needs to contain the type
+ * @return unique_ptr to created RecordProcessor instance
+ */
+inline std::unique_ptr<RecordProcessor>
+make_record_processor(const nlohmann::json& conf)
+{
+  return make_record_processor(conf["type"].get<std::string>(), conf);
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_INCLUDE_DFMODULES_RECORDPROCESSOR_HPP_
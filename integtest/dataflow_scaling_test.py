@@ -0,0 +1,129 @@
+import pytest
+import os
+import re
+
+import integrationtest.data_file_checks as data_file_checks
+import integrationtest.log_file_checks as log_file_checks
+import integrationtest.config_file_gen as config_file_gen
+import integrationtest.dro_map_gen as dro_map_gen
+import dfmodules.scaling_sweep as scaling_sweep
+
+# This test runs a matrix of dataflow configurations on the local host, for scaling
+# studies.  It is steered with environment variables, so that run_dataflow_scaling_sweep.sh
+# can run it for several numbers of sources:
+#   DFMODULES_SCALING_SOURCES        number of FakeDataProd sources per readout app (default 2)
+#   DFMODULES_SCALING_READOUT_APPS   number of readout apps (default 1)
+#   DFMODULES_SCALING_DATAFLOW_APPS  comma-separated numbers of dataflow apps (default "1,2")
+#   DFMODULES_SCALING_SWEEP          swept fddaqconf_gen parameters, as path=value1,value2,...
+#                                    separated by ";" (default "dataflow.token_count=10,40")
+#   DFMODULES_SCALING_RUN_SECONDS    duration of the run of each configuration (default 30)
+#   DFMODULES_SCALING_RESULTS        file to which the opmon totals of each configuration
+#                                    are appended, for "scaling_sweep.py table"
+# See python/dfmodules/scaling_sweep.py for the syntax of the swept parameters.
+
+# Values that help determine the running conditions
+number_of_data_producers=int(os.environ.get("DFMODULES_SCALING_SOURCES", "2"))
+number_of_readout_apps=int(os.environ.get("DFMODULES_SCALING_READOUT_APPS", "1"))
+dataflow_app_counts=[int(count) for count in os.environ.get("DFMODULES_SCALING_DATAFLOW_APPS", "1,2").split(",")]
+sweep_specs=[spec for spec in os.environ.get("DFMODULES_SCALING_SWEEP", "dataflow.token_count=10,40").split(";") if spec]
+run_duration=int(os.environ.get("DFMODULES_SCALING_RUN_SECONDS", "30"))
+results_file=os.environ.get("DFMODULES_SCALING_RESULTS",
+                            f"/tmp/pytest-of-{os.environ.get('USER')}/dfmodules_scaling_results.jsonl")
+trigger_rate=1 # Hz
+data_rate_slowdown_factor=1
+
+# Default values for validation parameters
+check_for_logfile_errors=True
+fake_frag_params={"fragment_type_description": "WIBEth",
+                  "fragment_type": "WIBEth",
+                  "hdf5_source_subsystem": "Detector_Readout",
+                  "expected_fragment_count": (number_of_data_producers*number_of_readout_apps),
+                  "min_size_bytes": 72, "max_size_bytes": 194472}
+triggercandidate_frag_params={"fragment_type_description": "Trigger Candidate",
+                              "fragment_type": "Trigger_Candidate",
+                              "hdf5_source_subsystem": "Trigger",
+                              "expected_fragment_count": 1,
+                              "min_size_bytes": 72, "max_size_bytes": 280}
+hsi_frag_params ={"fragment_type_description": "HSI",
+                             "fragment_type": "Hardware_Signal",
+                             "hdf5_source_subsystem": "HW_Signals_Interface",
+                             "expected_fragment_count": 1,
+                             "min_size_bytes": 72, "max_size_bytes": 100}
+ignored_logfile_problems={}
+
+# The next three variable declarations *must* be present as globals in the test
+# file. They're read by the "fixtures" in conftest.py to determine how
+# to run the config generation and nanorc
+
+# The name of the python module for the config generation
+confgen_name="fddaqconf_gen"
+# The arguments to pass to the config generator, excluding the json
+# output directory (the test framework handles that)
+dro_map_contents = dro_map_gen.generate_dromap_contents(number_of_data_producers, number_of_readout_apps)
+
+conf_dict = config_file_gen.get_default_config_dict()
+conf_dict["daq_common"]["data_rate_slowdown_factor"] = data_rate_slowdown_factor
+conf_dict["readout"]["use_fake_data_producers"] = True
+conf_dict["readout"]["use_fake_cards"] = True
+conf_dict["detector"]["clock_speed_hz"] = 62500000 # DuneWIB/WIBEth
+conf_dict["detector"]["op_env"] = "integtest"
+conf_dict["hsi"]["random_trigger_rate_hz"] = trigger_rate
+
+scaling_matrix = scaling_sweep.generate_matrix(conf_dict, scaling_sweep.parse_sweep(sweep_specs), dataflow_app_counts)
+confgen_arguments={name: conf for name, (conf, parameters) in scaling_matrix.items()}
+
+# The commands to run in nanorc, as a list
+nanorc_command_list="integtest-partition boot conf".split()
+nanorc_command_list+="start_run 101 wait ".split() + [str(run_duration)] + "stop_run --wait 2 wait 2".split()
+nanorc_command_list+="scrap terminate".split()
+
+def current_configuration():
+    current_test=os.environ.get('PYTEST_CURRENT_TEST')
+    match_obj = re.search(r".*\[(.+)\].*", current_test)
+    return match_obj.group(1) if match_obj else current_test
+
+# The tests themselves
+
+def test_nanorc_success(run_nanorc):
+    current_test=current_configuration()
+    banner_line = re.sub(".", "=", current_test)
+    print(banner_line)
+    print(current_test)
+    print(banner_line)
+    # Check that nanorc completed correctly
+    assert run_nanorc.completed_process.returncode==0
+
+def test_log_files(run_nanorc):
+    if check_for_logfile_errors:
+        # Check that there are no warnings or errors in the log files
+        assert log_file_checks.logs_are_error_free(run_nanorc.log_files, True, True, ignored_logfile_problems)
+
+def test_data_files(run_nanorc):
+    fragment_check_list=[triggercandidate_frag_params, hsi_frag_params, fake_frag_params]
+
+    # Every dataflow app writes its share of the trigger records
+    assert len(run_nanorc.data_files) >= 1
+
+    for idx in range(len(run_nanorc.data_files)):
+        data_file=data_file_checks.DataFile(run_nanorc.data_files[idx])
+        assert data_file_checks.sanity_check(data_file)
+        assert data_file_checks.check_file_attributes(data_file)
+        for jdx in range(len(fragment_check_list)):
+            assert data_file_checks.check_fragment_count(data_file, fragment_check_list[jdx])
+            assert data_file_checks.check_fragment_sizes(data_file, fragment_check_list[jdx])
+
+def test_collect_results(run_nanorc):
+    name=current_configuration()
+    parameters={"sources": number_of_data_producers*number_of_readout_apps}
+    if name in scaling_matrix:
+        parameters.update(scaling_matrix[name][1])
+    metrics=scaling_sweep.collect_opmon(str(run_nanorc.run_dir))
+    metrics["data_files"]=len(run_nanorc.data_files)
+    metrics["data_bytes"]=sum(os.path.getsize(data_file) for data_file in run_nanorc.data_files)
+    os.makedirs(os.path.dirname(results_file), exist_ok=True)
+    scaling_sweep.append_result(results_file, name, parameters, metrics)
+    print(f"Results of {name} appended to {results_file}: {metrics}")
+
+def test_cleanup(run_nanorc):
+    for data_file in run_nanorc.data_files:
+        data_file.unlink()
@@ -0,0 +1,107 @@
+#!/bin/bash
+# Runs dataflow_scaling_test.py for each of the given numbers of sources, and prints the
+# table of the opmon totals of all the configurations at the end.
+
+usage() {
+    declare -r script_name=$(basename "$0")
+    echo """
+Usage:
+"${script_name}" [option(s)]
+
+Options:
+    -h, --help
+    -s <DAQ session number (formerly known as partition number), default=1)>
+    -n <comma-separated numbers of sources per readout app, default=2>
+    -r <number of readout apps, default=1>
+    -m <comma-separated numbers of dataflow apps, default=1,2>
+    -p <swept parameter, as path=value1,value2,...; can be repeated, default=dataflow.token_count=10,40>
+    -d <duration of each run in seconds, default=30>
+    -o <results file, default=/tmp/pytest-of-\${USER}/dfmodules_scaling_<timestamp>.jsonl>
+"""
+}
+
+TEMP=`getopt -o hs:n:r:m:p:d:o: --long help -- "$@"`
+eval set -- "$TEMP"
+
+TIMESTAMP=`date '+%Y%m%d%H%M%S'`
+let session_number=1
+source_counts="2"
+readout_apps="1"
+dataflow_apps="1,2"
+sweep=""
+run_seconds="30"
+results_file="/tmp/pytest-of-${USER}/dfmodules_scaling_${TIMESTAMP}.jsonl"
+
+while true; do
+    case "$1" in
+        -h|--help)
+            usage
+            exit 0
+            ;;
+        -s)
+            let session_number=$2
+            shift 2
+            ;;
+        -n)
+            source_counts=$2
+            shift 2
+            ;;
+        -r)
+            readout_apps=$2
+            shift 2
+            ;;
+        -m)
+            dataflow_apps=$2
+            shift 2
+            ;;
+        -p)
+            sweep="${sweep:+${sweep};}$2"
+            shift 2
+            ;;
+        -d)
+            run_seconds=$2
+            shift 2
+            ;;
+        -o)
+            results_file=$2
+            shift 2
+            ;;
+        --)
+            shift
+            break
+            ;;
+    esac
+done
+
+mkdir -p /tmp/pytest-of-${USER}
+ITGRUNNER_LOG_FILE="/tmp/pytest-of-${USER}/dfmodules_scaling_${TIMESTAMP}.log"
+
+export DFMODULES_SCALING_READOUT_APPS=${readout_apps}
+export DFMODULES_SCALING_DATAFLOW_APPS=${dataflow_apps}
+export DFMODULES_SCALING_RUN_SECONDS=${run_seconds}
+export DFMODULES_SCALING_RESULTS=${results_file}
+if [[ -n "${sweep}" ]]; then
+    export DFMODULES_SCALING_SWEEP="${sweep}"
+fi
+
+for source_count in ${source_counts//,/ }; do
+    echo "===== Running dataflow_scaling_test.py with ${source_count} sources per readout app" >> ${ITGRUNNER_LOG_FILE}
+    DFMODULES_SCALING_SOURCES=${source_count} pytest -s dataflow_scaling_test.py --nanorc-option partition-number ${session_number} | tee -a ${ITGRUNNER_LOG_FILE}
+done
+
+# print out summary information
+echo ""
+echo ""
+echo "+++++++++++++++++++++++++++++++++++++++++++++++++"
+echo "++++++++++++++++++++ SUMMARY ++++++++++++++++++++"
+echo "+++++++++++++++++++++++++++++++++++++++++++++++++"
+echo ""
+date
+echo "Log file is: ${ITGRUNNER_LOG_FILE}"
+echo "Results file is: ${results_file}"
+echo ""
+grep '=====' ${ITGRUNNER_LOG_FILE} | egrep ' in |Running'
+echo ""
+if [[ -f ${results_file} ]]; then
+    python3 -m dfmodules.scaling_sweep table ${results_file}
+fi
@@ -8,6 +8,7 @@
 
 #include "DataFlowOrchestrator.hpp"
 #include "dfmodules/CommonIssues.hpp"
+#include "dfmodules/InstrumentedMutex.hpp"
 
 #include "dfmodules/datafloworchestrator/Nljs.hpp"
 #include "dfmodules/datafloworchestratorinfo/InfoNljs.hpp"
@@ -40,7 +41,8 @@ enum
   TLVL_WORK_STEPS = 10,
   TLVL_TRIGDEC_RECEIVED = 21,
   TLVL_NOTIFY_TRIGGER = 22,
-  TLVL_DISPATCH_TO_TRB = 23
+  TLVL_DISPATCH_TO_TRB = 23,
+  TLVL_TOKEN_RECEIVED = 24
 };
 
 namespace dunedaq::dfmodules {
@@ -49,7 +51,15 @@ DataFlowOrchestrator::DataFlowOrchestrator(const std::string& name)
   : dunedaq::appfwk::DAQModule(name)
   , m_queue_timeout(100)
   , m_run_number(0)
+  , m_flight_recorder(name)
+  , m_run_report(name, "DataFlowOrchestrator")
 {
+  m_flight_recorder.add_gauge("outstanding_decisions", [this]() { return m_used_slots_gauge.load(); });
+  m_flight_recorder.add_gauge("busy", [this]() { return m_last_notified_busy.load() ? 1 : 0; });
+  m_flight_recorder.add_gauge("decisions_received", [this]() { return m_received_decisions_tot.load(); });
+  m_flight_recorder.add_gauge("tokens_received", [this]() { return m_received_tokens_tot.load(); });
+  m_flight_recorder.add_gauge("last_decision_latency_us", [this]() { return m_last_decision_latency_us.load(); });
+
   register_command("conf", &DataFlowOrchestrator::do_conf);
   register_command("start", &DataFlowOrchestrator::do_start);
   register_command("drain_dataflow", &DataFlowOrchestrator::do_stop);
@@ -90,6 +100,9 @@ DataFlowOrchestrator::do_conf(const data_t& payload)
   m_free_threshold = parsed_conf.thresholds.free;
 
   m_td_send_retries = parsed_conf.td_send_retries;
+  m_flight_recorder.configure(parsed_conf.flight_recorder);
+  m_find_slot_perf.set_enabled(parsed_conf.perf_counters);
+  m_run_report.configure(parsed_conf.run_report);
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_conf() method, there are "
                                       << m_dataflow_availability.size() << " TRB apps defined";
@@ -109,6 +122,14 @@ DataFlowOrchestrator::do_start(const data_t& payload)
 
   m_last_token_received = m_last_td_received = std::chrono::steady_clock::now();
 
+  m_used_slots_gauge = 0;
+  m_received_decisions_tot = 0;
+  m_received_tokens_tot = 0;
+  m_last_decision_latency_us = 0;
+  m_flight_recorder.start(m_run_number);
+  m_run_report.start(m_run_number);
+  m_run_busy.set(false);
+
   auto iom = iomanager::IOManager::get();
   iom->add_callback<dfmessages::TriggerDecisionToken>(
     m_token_connection, std::bind(&DataFlowOrchestrator::receive_trigger_complete_token, this, std::placeholders::_1));
@@ -152,6 +173,9 @@ DataFlowOrchestrator::do_stop(const data_t& /*args*/)
     ers::error(IncompleteTriggerDecision(ERS_HERE, r->decision.trigger_number, m_run_number));
   }
 
+  m_flight_recorder.stop();
+  m_run_report.stop();
+
   TLOG() << get_name() << " successfully stopped";
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
 }
@@ -162,13 +186,14 @@ DataFlowOrchestrator::do_scrap(const data_t& /*args*/)
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
 
   m_dataflow_availability.clear();
+  m_td_senders.clear();
 
   TLOG() << get_name() << " successfully scrapped";
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
 }
 
 void
-DataFlowOrchestrator::receive_trigger_decision(const dfmessages::TriggerDecision& decision)
+DataFlowOrchestrator::receive_trigger_decision(dfmessages::TriggerDecision& decision)
 {
   TLOG_DEBUG(TLVL_TRIGDEC_RECEIVED) << get_name() << " Received TriggerDecision for trigger_number "
                                     << decision.trigger_number << " and run " << decision.run_number
@@ -180,6 +205,8 @@ DataFlowOrchestrator::receive_trigger_decision(const dfmessages::TriggerDecision
   }
 
   ++m_received_decisions;
+  ++m_received_decisions_tot;
+  m_run_decisions_received.add();
   auto decision_received = std::chrono::steady_clock::now();
 
   std::chrono::steady_clock::time_point decision_assigned;
@@ -193,7 +220,8 @@ DataFlowOrchestrator::receive_trigger_decision(const dfmessages::TriggerDecision
       continue;
     }
 
-    TLOG_DEBUG(TLVL_TRIGDEC_RECEIVED) << get_name() << " Slot found for trigger_number " << decision.trigger_number
+    TLOG_DEBUG(TLVL_TRIGDEC_RECEIVED) << get_name() << " Slot found for trigger_number "
+                                      << assignment->decision.trigger_number
                                       << " on connection " << assignment->connection_name
                                       << ", number of used slots is " << used_slots();
     decision_assigned = std::chrono::steady_clock::now();
@@ -201,22 +229,31 @@ DataFlowOrchestrator::receive_trigger_decision(const dfmessages::TriggerDecision
 
     if (dispatch_successful) {
       assign_trigger_decision(assignment);
-      TLOG_DEBUG(TLVL_TRIGDEC_RECEIVED) << get_name() << " Assigned trigger_number " << decision.trigger_number
+      TLOG_DEBUG(TLVL_TRIGDEC_RECEIVED) << get_name() << " Assigned trigger_number "
+                                        << assignment->decision.trigger_number
                                         << " to connection " << assignment->connection_name;
       break;
     } else {
       ers::error(
         TriggerRecordBuilderAppUpdate(ERS_HERE, assignment->connection_name, "Could not send Trigger Decision"));
       m_dataflow_availability[assignment->connection_name].set_in_error(true);
+      m_run_send_failures.add();
+      // a failed send leaves the decision untouched, take it back for the next attempt
+      decision = std::move(assignment->decision);
     }
 
   } while (m_running_status.load());
 
   notify_trigger(is_busy());
+  m_used_slots_gauge = used_slots();
+  m_run_outstanding_decisions.observe(m_used_slots_gauge.load());
 
   m_waiting_for_decision +=
     std::chrono::duration_cast<std::chrono::microseconds>(decision_received - m_last_td_received).count();
   m_last_td_received = std::chrono::steady_clock::now();
+  m_last_decision_latency_us =
+    std::chrono::duration_cast<std::chrono::microseconds>(m_last_td_received - decision_received).count();
+  m_run_decision_latency.record(std::chrono::microseconds(m_last_decision_latency_us.load()));
   m_deciding_destination +=
     std::chrono::duration_cast<std::chrono::microseconds>(decision_assigned - decision_received).count();
   m_forwarding_decision +=
@@ -224,9 +261,11 @@ DataFlowOrchestrator::receive_trigger_decision(const dfmessages::TriggerDecision
 }
 
 std::shared_ptr<AssignedTriggerDecision>
-DataFlowOrchestrator::find_slot(const dfmessages::TriggerDecision& decision)
+DataFlowOrchestrator::find_slot(dfmessages::TriggerDecision& decision)
 {
 
+  PerfScope perf_scope(m_find_slot_perf);
+
   // this find_slot assings the decision with a round-robin logic
   // across all the available applications.
   // Applications in error are skipped.
@@ -267,7 +306,7 @@ DataFlowOrchestrator::find_slot(const dfmessages::TriggerDecision& decision)
     if (candidate_it->second.is_busy())
       continue;
 
-    output = candidate_it->second.make_assignment(decision);
+    output = candidate_it->second.make_assignment(std::move(decision));
     m_last_assignement_it = candidate_it;
   }
 
@@ -276,14 +315,16 @@ DataFlowOrchestrator::find_slot(const dfmessages::TriggerDecision& decision)
     // so we assign the decision to that with the lowest
     // number of assignments
     if (minimum_occupied != m_dataflow_availability.end()) {
-      output = minimum_occupied->second.make_assignment(decision);
+      output = minimum_occupied->second.make_assignment(std::move(decision));
       m_last_assignement_it = minimum_occupied;
-      ers::warning(AssignedToBusyApp(ERS_HERE, decision.trigger_number, minimum_occupied->first, minimum));
+      ers::warning(AssignedToBusyApp(ERS_HERE, output->decision.trigger_number, minimum_occupied->first, minimum));
+      m_flight_recorder.request_dump("AssignedToBusyApp");
+      m_run_busy_assignments.add();
     }
   }
 
   if (output != nullptr) {
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Assigned TriggerDecision with trigger number " << decision.trigger_number
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Assigned TriggerDecision with trigger number " << output->decision.trigger_number
                                 << " to TRB at connection " << output->connection_name;
   }
   return output;
@@ -309,6 +350,8 @@ DataFlowOrchestrator::get_info(opmonlib::InfoCollector& ci, int level)
   info.waiting_for_token = m_waiting_for_token.exchange(0);
   info.processing_token = m_processing_token.exchange(0);
   ci.add(info);
+  m_find_slot_perf.get_info(ci);
+  LockProfiler::get_info(ci, get_name());
 }
 
 void
@@ -318,7 +361,7 @@ DataFlowOrchestrator::receive_trigger_complete_token(const dfmessages::TriggerDe
     if (m_dataflow_availability.count(token.decision_destination) == 0) {
       TLOG_DEBUG(TLVL_CONFIG) << "Creating dataflow availability struct for uid " << token.decision_destination;
       m_dataflow_availability[token.decision_destination] =
-        TriggerRecordBuilderData(token.decision_destination, m_busy_threshold, m_free_threshold);
+        TriggerRecordBuilderData(token.decision_destination, m_busy_threshold, m_free_threshold, get_name());
     } else {
       TLOG() << TriggerRecordBuilderAppUpdate(ERS_HERE, token.decision_destination, "Has reconnected");
       auto app_it = m_dataflow_availability.find(token.decision_destination);
@@ -327,8 +370,9 @@ DataFlowOrchestrator::receive_trigger_complete_token(const dfmessages::TriggerDe
     return;
   }
 
-  TLOG() << get_name() << " Received TriggerDecisionToken for trigger_number " << token.trigger_number << " and run "
-         << token.run_number << " (current run is " << m_run_number << ")";
+  TLOG_DEBUG(TLVL_TOKEN_RECEIVED) << get_name() << " Received TriggerDecisionToken for trigger_number "
+                                  << token.trigger_number << " and run " << token.run_number << " (current run is "
+                                  << m_run_number << ")";
   // add a check to see if the application data found
   if (token.run_number != m_run_number) {
     std::ostringstream oss_source;
@@ -346,10 +390,14 @@ DataFlowOrchestrator::receive_trigger_complete_token(const dfmessages::TriggerDe
   }
 
   ++m_received_tokens;
+  ++m_received_tokens_tot;
+  m_run_tokens_received.add();
   auto callback_start = std::chrono::steady_clock::now();
 
   try {
     auto dec_ptr = app_it->second.complete_assignment(token.trigger_number, m_metadata_function);
+    m_run_completion_latency.record(
+      std::chrono::duration_cast<std::chrono::microseconds>(callback_start - dec_ptr->assigned_time));
   } catch (AssignedTriggerDecisionNotFound const& err) {
     ers::error(err);
   }
@@ -362,6 +410,7 @@ DataFlowOrchestrator::receive_trigger_complete_token(const dfmessages::TriggerDe
   if (!app_it->second.is_busy()) {
     notify_trigger(false);
   }
+  m_used_slots_gauge = used_slots();
 
   m_waiting_for_token +=
     std::chrono::duration_cast<std::chrono::microseconds>(callback_start - m_last_token_received).count();
@@ -425,6 +474,7 @@ DataFlowOrchestrator::notify_trigger(bool busy) const
   } while (!wasSentSuccessfully && m_running_status.load());
 
   m_last_notified_busy.store(busy);
+  m_run_busy.set(busy);
 }
 
 bool
@@ -436,18 +486,22 @@ DataFlowOrchestrator::dispatch(const std::shared_ptr<AssignedTriggerDecision>& a
 
   bool wasSentSuccessfully = false;
   int retries = m_td_send_retries;
-  auto iom = iomanager::IOManager::get();
   do {
 
     try {
-      auto decision_copy = dfmessages::TriggerDecision(assignment->decision);
-      iom->get_sender<dfmessages::TriggerDecision>(assignment->connection_name)
-        ->send(std::move(decision_copy), m_queue_timeout);
+      auto& sender = m_td_senders[assignment->connection_name];
+      if (sender == nullptr) {
+        sender = iomanager::IOManager::get()->get_sender<dfmessages::TriggerDecision>(assignment->connection_name);
+      }
+      // the decision is handed over rather than copied: only its scalar fields are used afterwards
+      sender->send(std::move(assignment->decision), m_queue_timeout);
       wasSentSuccessfully = true;
       ++m_sent_decisions;
+      m_run_decisions_sent.add();
       TLOG_DEBUG(TLVL_DISPATCH_TO_TRB) << get_name() << " Sent TriggerDecision for trigger_number "
-                                       << decision_copy.trigger_number << " to TRB at connection "
-                                       << assignment->connection_name << " for run number " << decision_copy.run_number;
+                                       << assignment->decision.trigger_number << " to TRB at connection "
+                                       << assignment->connection_name << " for run number "
+                                       << assignment->decision.run_number;
     } catch (const ers::Issue& excpt) {
       std::ostringstream oss_warn;
       oss_warn << "Send to connection \"" << assignment->connection_name << "\" failed";
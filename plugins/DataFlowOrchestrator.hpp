@@ -11,6 +11,9 @@
 
 #include "dfmodules/datafloworchestrator/Structs.hpp"
 
+#include "dfmodules/FlightRecorder.hpp"
+#include "dfmodules/PerfCounters.hpp"
+#include "dfmodules/RunReport.hpp"
 #include "dfmodules/TriggerRecordBuilderData.hpp"
 
 #include "daqdataformats/TriggerRecord.hpp"
@@ -87,13 +90,13 @@ public:
   void init(const data_t&) override;
 
 protected:
-  virtual std::shared_ptr<AssignedTriggerDecision> find_slot(const dfmessages::TriggerDecision& decision);
-  // find_slot operates on a round-robin logic
+  virtual std::shared_ptr<AssignedTriggerDecision> find_slot(dfmessages::TriggerDecision& decision);
+  // find_slot operates on a round-robin logic, and moves the decision into the assignment it returns
 
   using data_structure_t = std::map<std::string, TriggerRecordBuilderData>;
   data_structure_t m_dataflow_availability;
   data_structure_t::iterator m_last_assignement_it;
-  std::function<void(nlohmann::json&)> m_metadata_function;
+  metadata_function_t m_metadata_function = nullptr;
 
 private:
   // Commands
@@ -105,7 +108,7 @@ private:
   void get_info(opmonlib::InfoCollector& ci, int level) override;
 
   virtual void receive_trigger_complete_token(const dfmessages::TriggerDecisionToken&);
-  void receive_trigger_decision(const dfmessages::TriggerDecision&);
+  void receive_trigger_decision(dfmessages::TriggerDecision&);
   virtual bool is_busy() const;
   bool is_empty() const;
   size_t used_slots() const;
@@ -120,6 +123,8 @@ private:
 
   // Connections
   std::shared_ptr<iomanager::SenderConcept<dfmessages::TriggerInhibit>> m_busy_sender;
+  std::map<std::string, std::shared_ptr<iomanager::SenderConcept<dfmessages::TriggerDecision>>>
+    m_td_senders; ///< By connection name, resolved on first use
   std::string m_token_connection;
   std::string m_td_connection;
   size_t m_td_send_retries;
@@ -141,6 +146,29 @@ private:
   std::atomic<uint64_t> m_forwarding_decision{ 0 };  // NOLINT (build/unsigned)
   std::atomic<uint64_t> m_waiting_for_token{ 0 };    // NOLINT (build/unsigned)
   std::atomic<uint64_t> m_processing_token{ 0 };     // NOLINT (build/unsigned)
+
+  std::atomic<uint64_t> m_used_slots_gauge{ 0 };       // NOLINT (build/unsigned)
+  std::atomic<uint64_t> m_received_decisions_tot{ 0 }; // NOLINT (build/unsigned)
+  std::atomic<uint64_t> m_received_tokens_tot{ 0 };    // NOLINT (build/unsigned)
+  std::atomic<int64_t> m_last_decision_latency_us{ 0 };
+
+  // recent history of the assignments, dumped when a decision is assigned to a busy app
+  FlightRecorder m_flight_recorder;
+
+  // optional hardware performance counters of the choice of the destination of each decision
+  PerfSection m_find_slot_perf{ "find_slot" };
+
+  // end-of-run report, whose figures are not reset by get_info()
+  RunReport m_run_report;
+  RunReport::Counter& m_run_decisions_received = m_run_report.add_counter("decisions_received");
+  RunReport::Counter& m_run_decisions_sent = m_run_report.add_counter("decisions_sent");
+  RunReport::Counter& m_run_send_failures = m_run_report.add_counter("decision_send_failures");
+  RunReport::Counter& m_run_tokens_received = m_run_report.add_counter("tokens_received");
+  RunReport::Counter& m_run_busy_assignments = m_run_report.add_counter("assignments_to_busy_apps");
+  RunReport::Latency& m_run_decision_latency = m_run_report.add_latency("decision_forwarding");
+  RunReport::Latency& m_run_completion_latency = m_run_report.add_latency("trigger_decision_completion");
+  RunReport::Peak& m_run_outstanding_decisions = m_run_report.add_peak("outstanding_decisions");
+  RunReport::StateTimer& m_run_busy = m_run_report.add_state("busy");
 };
 } // namespace dfmodules
 } // namespace dunedaq
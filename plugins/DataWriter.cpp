@@ -48,7 +48,15 @@ DataWriter::DataWriter(const std::string& name)
   , m_queue_timeout(100)
   , m_data_storage_is_enabled(true)
   , m_thread(std::bind(&DataWriter::do_work, this, std::placeholders::_1))
+  , m_flight_recorder(name)
+  , m_run_report(name, "DataWriter")
 {
+  m_flight_recorder.add_gauge("records_received", [this]() { return m_records_received_tot.load(); });
+  m_flight_recorder.add_gauge("records_written", [this]() { return m_records_written_tot.load(); });
+  m_flight_recorder.add_gauge("bytes_output", [this]() { return m_bytes_output_tot.load(); });
+  m_flight_recorder.add_gauge("write_retries", [this]() { return m_write_retries_tot.load(); });
+  m_flight_recorder.add_gauge("last_write_latency_us", [this]() { return m_last_write_latency_us.load(); });
+
   register_command("conf", &DataWriter::do_conf);
   register_command("start", &DataWriter::do_start);
   register_command("stop", &DataWriter::do_stop);
@@ -71,7 +79,7 @@ DataWriter::init(const data_t& init_data)
 }
 
 void
-DataWriter::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+DataWriter::get_info(opmonlib::InfoCollector& ci, int level)
 {
   datawriterinfo::Info dwi;
 
@@ -82,8 +90,21 @@ DataWriter::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   dwi.bytes_output = m_bytes_output_tot.load();
   dwi.new_bytes_output = m_bytes_output.exchange(0);
   dwi.writing_time = m_writing_ms.exchange(0);
+  dwi.reorder_held_records = m_reorder_buffer.get_held_records();
+  dwi.reorder_held_bytes = m_reorder_buffer.get_held_bytes();
+  dwi.reorder_late_records = m_reorder_buffer.get_late_records();
+
+  m_write_problem_limiter.check_summary();
 
   ci.add(dwi);
+
+  std::lock_guard<std::mutex> lk(m_data_writer_mutex);
+  if (m_data_writer) {
+    m_data_writer->get_info(ci, level);
+  }
+  if (m_processing_chain) {
+    m_processing_chain->get_info(ci, level);
+  }
 }
 void
 DataWriter::do_conf(const data_t& payload)
@@ -101,10 +122,24 @@ DataWriter::do_conf(const data_t& payload)
   m_max_write_retry_time_usec = conf_params.max_write_retry_time_usec;
   m_write_retry_time_increase_factor = conf_params.write_retry_time_increase_factor;
   m_trigger_decision_connection = conf_params.decision_connection;
+  m_thread_placement = ThreadPlacement(conf_params.thread_placement);
+  m_flight_recorder.configure(conf_params.flight_recorder);
+  m_run_report.configure(conf_params.run_report);
+  m_write_problem_limiter.configure(conf_params.max_reported_write_problems,
+                                    std::chrono::milliseconds(conf_params.write_problem_summary_interval_ms));
+  m_reorder_buffer.configure(std::max(conf_params.reorder_window_records, 0),
+                             conf_params.reorder_window_bytes,
+                             std::chrono::milliseconds(conf_params.reorder_max_hold_ms));
+  m_stop_drain_timeout = std::chrono::milliseconds(conf_params.stop_drain_timeout_ms);
+  TLOG_DEBUG(TLVL_CONFIG) << get_name() << ": reorder window is " << conf_params.reorder_window_records
+                          << " records, " << conf_params.reorder_window_bytes << " bytes, "
+                          << conf_params.reorder_max_hold_ms << " ms";
 
   // create the DataStore instance here
   try {
-    m_data_writer = make_data_store(payload["data_store_parameters"]);
+    auto data_store = make_data_store(payload["data_store_parameters"]);
+    std::lock_guard<std::mutex> lk(m_data_writer_mutex);
+    m_data_writer = std::move(data_store);
   } catch (const ers::Issue& excpt) {
     throw UnableToConfigure(ERS_HERE, get_name(), excpt);
   }
@@ -114,6 +149,26 @@ DataWriter::do_conf(const data_t& payload)
     throw InvalidDataWriter(ERS_HERE, get_name());
   }
 
+  // create the RecordProcessors, in the order in which they are applied
+  try {
+    std::unique_ptr<RecordProcessingChain> processing_chain;
+    if (!conf_params.record_processors.empty()) {
+      std::vector<std::unique_ptr<RecordProcessor>> processors;
+      for (const auto& processor_conf : conf_params.record_processors) {
+        processors.push_back(make_record_processor(processor_conf));
+      }
+      processing_chain = std::make_unique<RecordProcessingChain>(std::move(processors),
+                                                                 std::max(conf_params.record_processing_threads, 1),
+                                                                 std::max(conf_params.max_records_in_processing, 1));
+    }
+    TLOG_DEBUG(TLVL_CONFIG) << get_name() << ": " << conf_params.record_processors.size()
+                            << " record processors, on " << conf_params.record_processing_threads << " threads";
+    std::lock_guard<std::mutex> lk(m_data_writer_mutex);
+    m_processing_chain = std::move(processing_chain);
+  } catch (const ers::Issue& excpt) {
+    throw UnableToConfigure(ERS_HERE, get_name(), excpt);
+  }
+
   TLOG_DEBUG(TLVL_WORK_STEPS) << get_name() << ": Sending initial TriggerDecisionToken to DFO to announce my presence";
   dfmessages::TriggerDecisionToken token;
   token.run_number = 0;
@@ -160,12 +215,16 @@ DataWriter::do_start(const data_t& payload)
     
     try {
       m_data_writer->prepare_for_run(m_run_number);
+      if (m_processing_chain) {
+        m_processing_chain->prepare_for_run(m_run_number);
+      }
     } catch (const ers::Issue& excpt) {
       throw UnableToStart(ERS_HERE, get_name(), m_run_number, excpt);
     }
   }
 
   m_seqno_counts.clear();
+  m_reorder_buffer.reset();
   
   m_records_received = 0;
   m_records_received_tot = 0;
@@ -173,7 +232,12 @@ DataWriter::do_start(const data_t& payload)
   m_records_written_tot = 0;
   m_bytes_output = 0;
   m_bytes_output_tot = 0;
+  m_write_retries_tot = 0;
+  m_last_write_latency_us = 0;
 
+  m_flight_recorder.start(m_run_number);
+  m_run_report.start(m_run_number);
+  m_drain_deadline = std::chrono::steady_clock::time_point::min();
   m_running.store(true);
 
   m_thread.start_working_thread(get_name());
@@ -191,6 +255,8 @@ DataWriter::do_stop(const data_t& /*args*/)
 
   m_running.store(false);
   m_thread.stop_working_thread(); 
+  m_write_problem_limiter.flush();
+  m_flight_recorder.stop();
   //iomanager::IOManager::get()->remove_callback<std::unique_ptr<daqdataformats::TriggerRecord>>( m_trigger_record_connection );
 
   // 04-Feb-2021, KAB: added this call to allow DataStore to finish up with this run.
@@ -203,6 +269,7 @@ DataWriter::do_stop(const data_t& /*args*/)
       ers::error(ProblemDuringStop(ERS_HERE, get_name(), m_run_number, excpt));
     }
   }
+  m_run_report.stop();
 
   TLOG() << get_name() << " successfully stopped for run number " << m_run_number;
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
@@ -214,6 +281,8 @@ DataWriter::do_scrap(const data_t& /*payload*/)
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
 
   // clear/reset the DataStore instance here
+  std::lock_guard<std::mutex> lk(m_data_writer_mutex);
+  m_processing_chain.reset();
   m_data_writer.reset();
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
@@ -226,6 +295,7 @@ DataWriter::receive_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord
 
   ++m_records_received;
   ++m_records_received_tot;
+  m_run_records_received.add();
   TLOG_DEBUG(TLVL_WORK_STEPS) << get_name() << ": Obtained the TriggerRecord for trigger number "
 			      << trigger_record_ptr->get_header_ref().get_trigger_number() << "."
 			      << trigger_record_ptr->get_header_ref().get_sequence_number()
@@ -247,50 +317,123 @@ DataWriter::receive_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord
     
     if (m_data_storage_is_enabled) {
 
-      std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
-      
-      bool should_retry = true;
-      size_t retry_wait_usec = m_min_write_retry_time_usec;
-      do {
+      // the records to be written are first given to the RecordProcessors, if there are any
+      if (m_processing_chain) {
+        m_processing_chain->submit(std::move(trigger_record_ptr), m_processed_records);
+        m_run_records_in_processing.observe(m_processing_chain->get_records_in_processing());
+        store_processed_records();
+      } else {
+        store_trigger_record(std::move(trigger_record_ptr));
+      }
+      TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": operations completed for TR";
+      return;
+    } //  if m_data_storage_is_enabled
+  }
+  
+  send_token_if_complete(*trigger_record_ptr);
+  
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": operations completed for TR";
+}
+
+void
+DataWriter::store_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord> trigger_record_ptr)
+{
+  // the records to be written go through the reorder buffer, which releases them in order
+  if (m_reorder_buffer.is_enabled()) {
+    m_reorder_buffer.push(std::move(trigger_record_ptr), std::chrono::steady_clock::now(), m_released_records);
+    m_run_reorder_held_records.observe(m_reorder_buffer.get_held_records());
+    write_released_records();
+    return;
+  }
+
+  write_trigger_record(*trigger_record_ptr);
+  send_token_if_complete(*trigger_record_ptr);
+}
+
+void
+DataWriter::store_processed_records()
+{
+  for (auto& processed : m_processed_records) {
+    if (processed.keep) {
+      store_trigger_record(std::move(processed.record));
+    } else {
+      // a record dropped by a processor is complete as far as the DFO is concerned
+      m_run_records_dropped.add();
+      send_token_if_complete(*processed.record);
+    }
+  }
+  m_processed_records.clear();
+}
+
+void
+DataWriter::write_released_records()
+{
+  for (auto& record : m_released_records) {
+    write_trigger_record(*record);
+    send_token_if_complete(*record);
+  }
+  m_released_records.clear();
+}
+
+void
+DataWriter::write_trigger_record(daqdataformats::TriggerRecord& trigger_record)
+{
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  
+  bool should_retry = true;
+  size_t retry_wait_usec = m_min_write_retry_time_usec;
+  do {
 	should_retry = false;
 	try {
-	  m_data_writer->write(*trigger_record_ptr);
+	  m_data_writer->write(trigger_record);
 	  ++m_records_written;
 	  ++m_records_written_tot;
-	  m_bytes_output += trigger_record_ptr->get_total_size_bytes();
-	  m_bytes_output_tot += trigger_record_ptr->get_total_size_bytes();
+	  m_bytes_output += trigger_record.get_total_size_bytes();
+	  m_bytes_output_tot += trigger_record.get_total_size_bytes();
+	  m_run_records_written.add();
+	  m_run_bytes_output.add(trigger_record.get_total_size_bytes());
 	} catch (const RetryableDataStoreProblem& excpt) {
 	  should_retry = true;
-	  ers::error(DataWritingProblem(ERS_HERE,
-					get_name(),
-					trigger_record_ptr->get_header_ref().get_trigger_number(),
-					trigger_record_ptr->get_header_ref().get_sequence_number(),
-					trigger_record_ptr->get_header_ref().get_run_number(),
-					excpt));
+	  ++m_write_retries_tot;
+	  m_run_write_retries.add();
+	  m_flight_recorder.request_dump("DataWritingProblem (retry)");
+	  if (m_write_problem_limiter.should_report(trigger_record.get_header_ref().get_trigger_number())) {
+	    ers::error(DataWritingProblem(ERS_HERE,
+					  get_name(),
+					  trigger_record.get_header_ref().get_trigger_number(),
+					  trigger_record.get_header_ref().get_sequence_number(),
+					  trigger_record.get_header_ref().get_run_number(),
+					  excpt));
+	  }
 	  if (retry_wait_usec > m_max_write_retry_time_usec) {
 	    retry_wait_usec = m_max_write_retry_time_usec;
 	  }
 	  usleep(retry_wait_usec);
 	  retry_wait_usec *= m_write_retry_time_increase_factor;
 	} catch (const std::exception& excpt) {
+	  m_run_write_failures.add();
 	  ers::error(DataWritingProblem(ERS_HERE,
 					get_name(),
-					trigger_record_ptr->get_header_ref().get_trigger_number(),
-					trigger_record_ptr->get_header_ref().get_sequence_number(),
-					trigger_record_ptr->get_header_ref().get_run_number(),
+					trigger_record.get_header_ref().get_trigger_number(),
+					trigger_record.get_header_ref().get_sequence_number(),
+					trigger_record.get_header_ref().get_run_number(),
 					excpt));
 	}
-      } while (should_retry && m_running.load());
+  } while (should_retry && is_running_or_draining());
 
-      std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
-      std::chrono::milliseconds writing_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-      m_writing_ms += writing_time.count();
-    } //  if m_data_storage_is_enabled
-  }
-  
-  bool send_trigger_complete_message = m_running.load();
-  if (trigger_record_ptr->get_header_ref().get_max_sequence_number() > 0) {
-    daqdataformats::trigger_number_t trigno = trigger_record_ptr->get_header_ref().get_trigger_number();
+  std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+  std::chrono::milliseconds writing_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+  m_writing_ms += writing_time.count();
+  m_last_write_latency_us = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+  m_run_write_latency.record(std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time));
+}
+
+void
+DataWriter::send_token_if_complete(daqdataformats::TriggerRecord& trigger_record)
+{
+  bool send_trigger_complete_message = is_running_or_draining();
+  if (trigger_record.get_header_ref().get_max_sequence_number() > 0) {
+    daqdataformats::trigger_number_t trigno = trigger_record.get_header_ref().get_trigger_number();
     if (m_seqno_counts.count(trigno) > 0) {
       ++m_seqno_counts[trigno];
     } else {
@@ -298,7 +441,7 @@ DataWriter::receive_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord
     }
     // in the following comparison GT (>) is used since the counts are one-based and the
     // max sequence number is zero-based.
-    if (m_seqno_counts[trigno] > trigger_record_ptr->get_header_ref().get_max_sequence_number()) {
+    if (m_seqno_counts[trigno] > trigger_record.get_header_ref().get_max_sequence_number()) {
       m_seqno_counts.erase(trigno);
     } else {
       // Using const .count and .at to avoid reintroducing element to map
@@ -310,11 +453,11 @@ DataWriter::receive_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord
   }
   if (send_trigger_complete_message) {
     TLOG_DEBUG(TLVL_WORK_STEPS) << get_name() << ": Pushing the TriggerDecisionToken for trigger number "
-				<< trigger_record_ptr->get_header_ref().get_trigger_number()
+				<< trigger_record.get_header_ref().get_trigger_number()
 				<< " onto the relevant output queue";
     dfmessages::TriggerDecisionToken token;
     token.run_number = m_run_number;
-    token.trigger_number = trigger_record_ptr->get_header_ref().get_trigger_number();
+    token.trigger_number = trigger_record.get_header_ref().get_trigger_number();
     token.decision_destination = m_trigger_decision_connection;
 
     bool wasSentSuccessfully = false;
@@ -327,15 +470,21 @@ DataWriter::receive_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord
 	oss_warn << "Send with sender \"" << m_token_output -> get_name() << "\" failed";
 	ers::warning(iomanager::OperationFailed(ERS_HERE, oss_warn.str(), excpt));
       }
-    } while (!wasSentSuccessfully && m_running.load());
+    } while (!wasSentSuccessfully && is_running_or_draining());
 
   }
-  
-  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": operations completed for TR";
 } // NOLINT(readability/fn_size)
 
+bool
+DataWriter::is_running_or_draining() const
+{
+  return m_running.load() || std::chrono::steady_clock::now() < m_drain_deadline;
+}
+
 void
 DataWriter::do_work(std::atomic<bool>& running_flag) {
+  m_thread_placement.apply_to_current_thread(get_name());
+
   while (running_flag.load()) {
 	  try {
 		std::unique_ptr<daqdataformats::TriggerRecord> tr = m_tr_receiver-> receive(std::chrono::milliseconds(10));   
@@ -346,6 +495,26 @@ DataWriter::do_work(std::atomic<bool>& running_flag) {
 	  catch(const ers::Issue & excpt) {
 		ers::warning(excpt);
 	  }
+	  if (m_processing_chain) {
+	    m_processing_chain->collect(m_processed_records);
+	    store_processed_records();
+	  }
+	  if (m_reorder_buffer.is_enabled()) {
+	    m_reorder_buffer.release_expired(std::chrono::steady_clock::now(), m_released_records);
+	    write_released_records();
+	  }
+  }
+
+  // the records still being processed or held are written before the DataStore finishes the run;
+  // they were received during the run, so their writes and tokens are retried, for a while
+  m_drain_deadline = std::chrono::steady_clock::now() + m_stop_drain_timeout;
+  if (m_processing_chain) {
+    m_processing_chain->drain(m_processed_records);
+    store_processed_records();
+  }
+  if (m_reorder_buffer.is_enabled()) {
+    m_reorder_buffer.flush(m_released_records);
+    write_released_records();
   }
 }
 
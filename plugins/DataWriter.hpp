@@ -10,6 +10,12 @@
 #define DFMODULES_PLUGINS_DATAWRITER_HPP_
 
 #include "dfmodules/DataStore.hpp"
+#include "dfmodules/FlightRecorder.hpp"
+#include "dfmodules/IssueRateLimiter.hpp"
+#include "dfmodules/RecordProcessingChain.hpp"
+#include "dfmodules/RecordReorderBuffer.hpp"
+#include "dfmodules/RunReport.hpp"
+#include "dfmodules/ThreadPlacement.hpp"
 
 #include "appfwk/DAQModule.hpp"
 #include "daqdataformats/TriggerRecord.hpp"
@@ -21,6 +27,7 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -56,7 +63,15 @@ private:
 
   // Callback
   void receive_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord>&);
+  void store_trigger_record(std::unique_ptr<daqdataformats::TriggerRecord>);
+  void store_processed_records();
+  void write_trigger_record(daqdataformats::TriggerRecord&);
+  void send_token_if_complete(daqdataformats::TriggerRecord&);
+  void write_released_records();
+  bool is_running_or_draining() const;
   std::atomic<bool> m_running = false;
+  // end of the retries of the writes and token sends of the records drained at stop; used by the worker thread only
+  std::chrono::steady_clock::time_point m_drain_deadline;
 
   // Configuration
   // size_t m_sleep_msec_while_running;
@@ -67,6 +82,7 @@ private:
   size_t m_min_write_retry_time_usec;
   size_t m_max_write_retry_time_usec;
   int m_write_retry_time_increase_factor;
+  std::chrono::milliseconds m_stop_drain_timeout;
 
   // Connections
   std::string m_trigger_record_connection;
@@ -80,8 +96,12 @@ private:
   // Worker(s)
   dunedaq::utilities::WorkerThread m_thread;
   void do_work(std::atomic<bool>&);
+  ThreadPlacement m_thread_placement;
 
   std::unique_ptr<DataStore> m_data_writer;
+  std::unique_ptr<RecordProcessingChain> m_processing_chain; // null when no RecordProcessor is configured
+  // guards the creation and reset of m_data_writer and m_processing_chain against get_info()
+  std::mutex m_data_writer_mutex;
 
   // Metrics
   std::atomic<uint64_t> m_records_received = { 0 };     // NOLINT(build/unsigned)
@@ -91,6 +111,32 @@ private:
   std::atomic<uint64_t> m_bytes_output = { 0 };         // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_bytes_output_tot = { 0 };     // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_writing_ms = { 0 };           // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_write_retries_tot = { 0 };    // NOLINT(build/unsigned)
+  std::atomic<int64_t> m_last_write_latency_us = { 0 };
+
+  IssueRateLimiter m_write_problem_limiter{ "DataWritingProblem" };
+
+  // records whose processing is complete, used by the worker thread only
+  std::vector<RecordProcessingChain::ProcessedRecord> m_processed_records;
+
+  // optional reordering of the records before they are written, used by the worker thread only
+  RecordReorderBuffer m_reorder_buffer;
+  std::vector<RecordReorderBuffer::record_ptr_t> m_released_records;
+
+  // recent history of the writing, dumped when a write is retried
+  FlightRecorder m_flight_recorder;
+
+  // end-of-run report, whose figures are not reset by get_info()
+  RunReport m_run_report;
+  RunReport::Counter& m_run_records_received = m_run_report.add_counter("records_received");
+  RunReport::Counter& m_run_records_written = m_run_report.add_counter("records_written");
+  RunReport::Counter& m_run_records_dropped = m_run_report.add_counter("records_dropped");
+  RunReport::Counter& m_run_bytes_output = m_run_report.add_counter("bytes_output");
+  RunReport::Counter& m_run_write_retries = m_run_report.add_counter("write_retries");
+  RunReport::Counter& m_run_write_failures = m_run_report.add_counter("write_failures");
+  RunReport::Latency& m_run_write_latency = m_run_report.add_latency("write");
+  RunReport::Peak& m_run_reorder_held_records = m_run_report.add_peak("reorder_held_records");
+  RunReport::Peak& m_run_records_in_processing = m_run_report.add_peak("records_in_processing");
 
   
   // Other
@@ -0,0 +1,95 @@
+/**
+ * @file EmptyFragmentFilter.hpp
+ *
+ * An implementation of the RecordProcessor interface that removes the
+ * Fragments without payload from the TriggerRecords, so that they don't
+ * take space in the output files.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_PLUGINS_EMPTYFRAGMENTFILTER_HPP_
+#define DFMODULES_PLUGINS_EMPTYFRAGMENTFILTER_HPP_
+
+#include "dfmodules/RecordProcessor.hpp"
+#include "dfmodules/emptyfragmentfilter/Nljs.hpp"
+#include "dfmodules/emptyfragmentfilter/Structs.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+#include "logging/Logging.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief EmptyFragmentFilter removes the Fragments that only have a header.
+ *
+ * The Fragments of a TriggerRecord can only be replaced as a whole, so the records
+ * that have empty Fragments are rebuilt with a copy of the others; the records
+ * without empty Fragments are left untouched. The header of the record still lists
+ * all the requested components.
+ */
+class EmptyFragmentFilter : public RecordProcessor
+{
+public:
+  enum
+  {
+    TLVL_BASIC = 2
+  };
+
+  explicit EmptyFragmentFilter(const nlohmann::json& conf)
+    : RecordProcessor(conf.value("name", "empty_fragment_filter"))
+  {
+    TLOG_DEBUG(TLVL_BASIC) << get_name() << ": Configuration: " << conf;
+
+    auto config_params = conf.get<emptyfragmentfilter::ConfParams>();
+    m_drop_empty_records = config_params.drop_empty_records;
+  }
+
+  virtual bool process(daqdataformats::TriggerRecord& tr)
+  {
+    const auto& fragments = tr.get_fragments_ref();
+    size_t empty_count = 0;
+    for (const auto& fragment : fragments) {
+      if (is_empty(*fragment)) {
+        ++empty_count;
+      }
+    }
+    if (empty_count == 0) {
+      return true;
+    }
+    if (empty_count == fragments.size() && m_drop_empty_records) {
+      return false;
+    }
+
+    std::vector<std::unique_ptr<daqdataformats::Fragment>> kept;
+    kept.reserve(fragments.size() - empty_count);
+    for (const auto& fragment : fragments) {
+      if (!is_empty(*fragment)) {
+        kept.push_back(std::make_unique<daqdataformats::Fragment>(
+          fragment->get_storage_location(), daqdataformats::Fragment::BufferAdoptionMode::kCopyFromBuffer));
+      }
+    }
+    tr.set_fragments(std::move(kept));
+    return true;
+  }
+
+private:
+  static bool is_empty(const daqdataformats::Fragment& fragment)
+  {
+    return fragment.get_size() <= sizeof(daqdataformats::FragmentHeader);
+  }
+
+  bool m_drop_empty_records;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_PLUGINS_EMPTYFRAGMENTFILTER_HPP_
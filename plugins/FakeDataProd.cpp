@@ -77,6 +77,7 @@ FakeDataProd::do_conf(const data_t& payload)
   m_frame_size = tmpConfig.frame_size;
   m_response_delay = tmpConfig.response_delay;
   m_fragment_type = daqdataformats::string_to_fragment_type(tmpConfig.fragment_type);
+  m_timesync_thread_placement = ThreadPlacement(tmpConfig.timesync_thread_placement);
 
   TLOG_DEBUG(TLVL_CONFIG) << get_name() << ": configured for link number " << m_sourceid.id;
 
@@ -122,6 +123,7 @@ FakeDataProd::get_info(opmonlib::InfoCollector& ci, int /*level*/)
 void
 FakeDataProd::do_timesync(std::atomic<bool>& running_flag)
 {
+  m_timesync_thread_placement.apply_to_current_thread(get_name() + "::timesync");
 
   auto iom = iomanager::IOManager::get();
   auto sender_ptr = iom->get_sender<dfmessages::TimeSync>(m_timesync_id);
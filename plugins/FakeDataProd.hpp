@@ -11,6 +11,7 @@
 
 #include "daqdataformats/Fragment.hpp"
 #include "dfmessages/DataRequest.hpp"
+#include "dfmodules/ThreadPlacement.hpp"
 
 #include "appfwk/DAQModule.hpp"
 #include "utilities/WorkerThread.hpp"
@@ -73,6 +74,7 @@ private:
   dunedaq::utilities::WorkerThread m_timesync_thread;
   void process_data_request(dfmessages::DataRequest&);
   void do_timesync(std::atomic<bool>&);
+  ThreadPlacement m_timesync_thread_placement;
 
   // Configuration
   // size_t m_sleep_msec_while_running;
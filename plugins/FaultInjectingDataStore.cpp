@@ -0,0 +1,9 @@
+/**
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FaultInjectingDataStore.hpp"
+
+DEFINE_DUNE_DATA_STORE(dunedaq::dfmodules::FaultInjectingDataStore)
@@ -0,0 +1,129 @@
+/**
+ * @file FaultInjectingDataStore.hpp
+ *
+ * An implementation of the DataStore interface that degrades the writes
+ * of another DataStore on purpose, to study the behaviour of the dataflow
+ * when the storage is slow, stalls or is full.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_PLUGINS_FAULTINJECTINGDATASTORE_HPP_
+#define DFMODULES_PLUGINS_FAULTINJECTINGDATASTORE_HPP_
+
+#include "dfmodules/DataStore.hpp"
+#include "dfmodules/StorageFaultInjector.hpp"
+#include "dfmodules/faultinjectingdatastore/Nljs.hpp"
+#include "dfmodules/faultinjectingdatastore/Structs.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "logging/Logging.hpp"
+
+#include <memory>
+#include <string>
+
+namespace dunedaq {
+
+// Disable coverage checking LCOV_EXCL_START
+ERS_DECLARE_ISSUE_BASE(dfmodules,
+                       SimulatedStorageFull,
+                       appfwk::GeneralDAQModuleIssue,
+                       "The storage is full (simulated ENOSPC, injected failure number " << failure_count << ")",
+                       ((std::string)name),
+                       ((size_t)failure_count))
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief FaultInjectingDataStore passes the data blocks on to a wrapped DataStore,
+ * after the delays and failures of its StorageFaultInjector.
+ *
+ * The failures are thrown as RetryableDataStoreProblem, like those of a real store
+ * running out of disk space, and the wrapped store is then not called. Without a
+ * wrapped store, the data blocks are discarded once the faults have been applied,
+ * which emulates a storage of the configured performance without touching any disk.
+ */
+class FaultInjectingDataStore : public DataStore
+{
+public:
+  enum
+  {
+    TLVL_BASIC = 2
+  };
+
+  explicit FaultInjectingDataStore(const nlohmann::json& conf)
+    : DataStore(conf.value("name", "fault_injector"))
+  {
+    TLOG_DEBUG(TLVL_BASIC) << get_name() << ": Configuration: " << conf;
+
+    auto config_params = conf.get<faultinjectingdatastore::ConfParams>();
+    m_faults = std::make_unique<StorageFaultInjector>(config_params.faults);
+
+    const auto& wrapped_conf = config_params.wrapped_data_store_parameters;
+    if (wrapped_conf.is_object() && !wrapped_conf.empty()) {
+      m_wrapped = make_data_store(wrapped_conf);
+    }
+  }
+
+  virtual void write(const daqdataformats::TriggerRecord& tr)
+  {
+    inject_faults(tr.get_total_size_bytes(), "writing a trigger record");
+    if (m_wrapped) {
+      m_wrapped->write(tr);
+    }
+  }
+
+  virtual void write(const daqdataformats::TimeSlice& ts)
+  {
+    inject_faults(ts.get_total_size_bytes(), "writing a time slice");
+    if (m_wrapped) {
+      m_wrapped->write(ts);
+    }
+  }
+
+  virtual void prepare_for_run(daqdataformats::run_number_t run_number)
+  {
+    if (m_wrapped) {
+      m_wrapped->prepare_for_run(run_number);
+    }
+    m_faults->start();
+  }
+
+  virtual void finish_with_run(daqdataformats::run_number_t run_number)
+  {
+    TLOG() << get_name() << ": run " << run_number << ": " << m_faults->get_write_count() << " writes, "
+           << m_faults->get_failed_write_count() << " injected failures, " << m_faults->get_stalled_write_count()
+           << " stalled writes, " << m_faults->get_injected_delay().count() << " us of injected delay";
+    if (m_wrapped) {
+      m_wrapped->finish_with_run(run_number);
+    }
+  }
+
+  virtual void get_info(opmonlib::InfoCollector& ci, int level)
+  {
+    if (m_wrapped) {
+      m_wrapped->get_info(ci, level);
+    }
+  }
+
+private:
+  void inject_faults(size_t bytes, const std::string& description)
+  {
+    if (m_faults->is_full()) {
+      SimulatedStorageFull issue(ERS_HERE, get_name(), m_faults->get_failed_write_count());
+      throw RetryableDataStoreProblem(ERS_HERE, get_name(), description, issue);
+    }
+    m_faults->delay_write(bytes);
+  }
+
+  std::unique_ptr<StorageFaultInjector> m_faults;
+  std::unique_ptr<DataStore> m_wrapped;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_PLUGINS_FAULTINJECTINGDATASTORE_HPP_
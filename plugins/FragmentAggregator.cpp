@@ -36,6 +36,7 @@ FragmentAggregator::init(const data_t& init_data)
 
   m_data_req_input = ci["data_req_input"];
   m_fragment_input = ci["fragment_input"];
+  m_data_req_batch_input = ci.count("data_req_batch_input") > 0 ? ci["data_req_batch_input"] : "";
 
   m_producer_conn_ref_map.clear();
   auto ini = init_data.get<appfwk::app::ModInit>();
@@ -47,8 +48,11 @@ FragmentAggregator::init(const data_t& init_data)
 }
 
 void
-FragmentAggregator::get_info(opmonlib::InfoCollector& /*ci*/, int /* level */)
+FragmentAggregator::get_info(opmonlib::InfoCollector& ci, int /* level */)
 {
+  m_unknown_destination_limiter.check_summary();
+  LockProfiler::get_info(ci, get_name());
+
   // dummyconsumerinfo::Info info;
   // info.packets_processed = m_packets_processed;
 
@@ -59,9 +63,25 @@ void
 FragmentAggregator::do_start(const data_t& /* args */)
 {
   m_packets_processed = 0;
+
+  // Resolve the DataRequest senders before the first request arrives
+  m_data_req_senders.clear();
+  for (const auto& [conn_name, uid] : m_producer_conn_ref_map) {
+    try {
+      m_data_req_senders[conn_name] = get_iom_sender<dfmessages::DataRequest>(uid);
+    } catch (const ers::Issue& excpt) {
+      ers::warning(ConnectionWarmUpFailed(ERS_HERE, conn_name, uid, excpt));
+    }
+  }
+  m_fragment_senders.clear();
+
   auto iom = iomanager::IOManager::get();
   iom->add_callback<dfmessages::DataRequest>(
     m_data_req_input, std::bind(&FragmentAggregator::process_data_request, this, std::placeholders::_1));
+  if (!m_data_req_batch_input.empty()) {
+    iom->add_callback<DataRequestBatch>(
+      m_data_req_batch_input, std::bind(&FragmentAggregator::process_data_request_batch, this, std::placeholders::_1));
+  }
   iom->add_callback<std::unique_ptr<daqdataformats::Fragment>>(
     m_fragment_input, std::bind(&FragmentAggregator::process_fragment, this, std::placeholders::_1));
 }
@@ -71,8 +91,12 @@ FragmentAggregator::do_stop(const data_t& /* args */)
 {
   auto iom = iomanager::IOManager::get();
   iom->remove_callback<dfmessages::DataRequest>(m_data_req_input);
+  if (!m_data_req_batch_input.empty()) {
+    iom->remove_callback<DataRequestBatch>(m_data_req_batch_input);
+  }
   iom->remove_callback<std::unique_ptr<daqdataformats::Fragment>>(m_fragment_input);
   m_data_req_map.clear();
+  m_unknown_destination_limiter.flush();
 }
 
 void
@@ -89,16 +113,25 @@ FragmentAggregator::process_data_request(dfmessages::DataRequest& data_request)
   // Forward Data Request to the right DLH
   try {
     std::string map_key = "request_output_" + data_request.request_information.component.to_string();
-    auto map_element = m_producer_conn_ref_map.find(map_key);
-    if (map_element == m_producer_conn_ref_map.end()) {
+    std::scoped_lock senders_lock(m_data_req_senders_mutex);
+    auto sender_element = m_data_req_senders.find(map_key);
+    std::shared_ptr<data_req_sender_t> sender = nullptr;
+    if (sender_element != m_data_req_senders.end()) {
+      sender = sender_element->second;
+    } else {
+      auto map_element = m_producer_conn_ref_map.find(map_key);
+      if (map_element != m_producer_conn_ref_map.end()) {
+        sender = get_iom_sender<dfmessages::DataRequest>(map_element->second);
+        m_data_req_senders[map_key] = sender;
+      }
+    }
+    if (sender == nullptr) {
       ers::error(dunedaq::dfmodules::DRSenderLookupFailed(ERS_HERE,
                                                           data_request.request_information.component,
                                                           data_request.run_number,
                                                           data_request.trigger_number,
                                                           data_request.sequence_number));
     } else {
-      std::string uid = map_element->second;
-      auto sender = get_iom_sender<dfmessages::DataRequest>(uid);
       data_request.data_destination = "fragment_queue";
       sender->send(std::move(data_request), iomanager::Sender::s_no_block);
     }
@@ -107,6 +140,15 @@ FragmentAggregator::process_data_request(dfmessages::DataRequest& data_request)
   }
 }
 
+void
+FragmentAggregator::process_data_request_batch(DataRequestBatch& batch)
+{
+  // the readout units only understand individual DataRequests
+  for (auto& data_request : batch.requests) {
+    process_data_request(data_request);
+  }
+}
+
 void
 FragmentAggregator::process_fragment(std::unique_ptr<daqdataformats::Fragment>& fragment)
 {
@@ -120,14 +162,20 @@ FragmentAggregator::process_fragment(std::unique_ptr<daqdataformats::Fragment>&
     if (dr_iter != m_data_req_map.end()) {
       trb_identifier = dr_iter->second;
       m_data_req_map.erase(dr_iter);
-    } else {
+    }
+  }
+  if (trb_identifier.empty()) {
+    if (m_unknown_destination_limiter.should_report(fragment->get_trigger_number())) {
       ers::error(UnknownFragmentDestination(
         ERS_HERE, fragment->get_trigger_number(), fragment->get_sequence_number(), fragment->get_element_id()));
-      return;
     }
+    return;
   }
   try {
-    auto sender = get_iom_sender<std::unique_ptr<daqdataformats::Fragment>>(trb_identifier);
+    auto& sender = m_fragment_senders[trb_identifier];
+    if (sender == nullptr) {
+      sender = get_iom_sender<std::unique_ptr<daqdataformats::Fragment>>(trb_identifier);
+    }
     sender->send(std::move(fragment), iomanager::Sender::s_no_block);
   } catch (const ers::Issue& excpt) {
     ers::warning(excpt);
@@ -13,6 +13,9 @@
 #include "daqdataformats/Fragment.hpp"
 #include "daqdataformats/SourceID.hpp"
 #include "dfmessages/DataRequest.hpp"
+#include "dfmodules/DataRequestBatch.hpp"
+#include "dfmodules/InstrumentedMutex.hpp"
+#include "dfmodules/IssueRateLimiter.hpp"
 
 #include "appfwk/DAQModule.hpp"
 
@@ -21,6 +24,7 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <tuple>
@@ -59,21 +63,33 @@ private:
   void do_stop(const nlohmann::json& obj);
 
   void process_data_request(dfmessages::DataRequest&);
+  void process_data_request_batch(DataRequestBatch&);
   void process_fragment(std::unique_ptr<daqdataformats::Fragment>&);
 
+  using data_req_sender_t = iomanager::SenderConcept<dfmessages::DataRequest>;
+  using fragment_sender_t = iomanager::SenderConcept<std::unique_ptr<daqdataformats::Fragment>>;
+
   // Input Connection namess
   std::string m_data_req_input;
+  std::string m_data_req_batch_input; // optional
   std::string m_fragment_input;
   std::map<std::string, std::string> m_producer_conn_ref_map;
 
+  // Output senders, resolved at start or on first use; the DataRequest senders are shared by
+  // the callbacks of the individual and batched DataRequest inputs
+  std::map<std::string, std::shared_ptr<data_req_sender_t>> m_data_req_senders; // resolved at start
+  std::mutex m_data_req_senders_mutex;
+  std::map<std::string, std::shared_ptr<fragment_sender_t>> m_fragment_senders; // resolved on first use
+
   // Stats
   std::atomic<int> m_packets_processed{ 0 };
+  IssueRateLimiter m_unknown_destination_limiter{ "UnknownFragmentDestination" };
 
   // TRB tracking
   std::map<std::tuple<dfmessages::trigger_number_t, dfmessages::sequence_number_t, daqdataformats::SourceID>,
            std::string>
     m_data_req_map;
-  std::mutex m_mutex;
+  InstrumentedMutex m_mutex{ get_name(), "FragmentAggregator.data_req_map" };
 };
 } // namespace dfmodules
 } // namespace dunedaq
@@ -12,11 +12,20 @@
 #ifndef DFMODULES_PLUGINS_HDF5DATASTORE_HPP_
 #define DFMODULES_PLUGINS_HDF5DATASTORE_HPP_
 
+#include "HDF5FileProperties.hpp"
 #include "HDF5FileUtils.hpp"
 #include "dfmodules/DataStore.hpp"
+#include "dfmodules/FileCacheController.hpp"
+#include "dfmodules/FragmentChecksums.hpp"
+#include "dfmodules/PerfCounters.hpp"
+#include "dfmodules/StorageBandwidthProbe.hpp"
+#include "dfmodules/TriggerManifest.hpp"
+#include "dfmodules/WorkerPool.hpp"
 #include "dfmodules/hdf5datastore/Nljs.hpp"
 #include "dfmodules/hdf5datastore/Structs.hpp"
+#include "dfmodules/hdf5datastoreinfo/InfoNljs.hpp"
 
+#include "hdf5libs/HDF5FileLayout.hpp"
 #include "hdf5libs/HDF5RawDataFile.hpp"
 #include "hdf5libs/hdf5filelayout/Nljs.hpp"
 #include "hdf5libs/hdf5filelayout/Structs.hpp"
@@ -28,9 +37,15 @@
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/lexical_cast.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <filesystem>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <sys/statvfs.h>
 #include <utility>
@@ -90,6 +105,23 @@ ERS_DECLARE_ISSUE_BASE(dfmodules,
                        ((std::string)name),
                        ERS_EMPTY)
 
+ERS_DECLARE_ISSUE_BASE(dfmodules,
+                       FragmentChecksumsNotStored,
+                       appfwk::GeneralDAQModuleIssue,
+                       "The Fragment checksums of record " << record_name << " could not be stored in file " << filename
+                                                           << ": " << reason,
+                       ((std::string)name),
+                       ((std::string)record_name)((std::string)filename)((std::string)reason))
+
+ERS_DECLARE_ISSUE_BASE(dfmodules,
+                       InsufficientStorageBandwidth,
+                       appfwk::GeneralDAQModuleIssue,
+                       "The output path \"" << path << "\" sustained " << measured_rate << " bytes/s with writes of "
+                                             << block_size << " bytes, which is below the expected rate of "
+                                             << expected_rate << " bytes/s",
+                       ((std::string)name),
+                       ((std::string)path)((size_t)block_size)((size_t)measured_rate)((size_t)expected_rate))
+
 // Re-enable coverage checking LCOV_EXCL_STOP
 namespace dfmodules {
 
@@ -136,6 +168,20 @@ public:
     m_file_index = 0;
     m_recorded_size = 0;
 
+    m_file_properties = std::make_unique<HDF5FileProperties>(m_config_params.file_properties);
+    m_file_cache = std::make_unique<FileCacheController>(m_config_params.file_cache);
+    m_bandwidth_probe = std::make_unique<StorageBandwidthProbe>(m_config_params.bandwidth_probe);
+    if (m_config_params.fragment_checksum_threads > 0) {
+      m_fragment_checksums = std::make_unique<FragmentChecksums>(m_config_params.fragment_checksum_threads);
+    }
+    if (m_fragment_checksums || m_config_params.trigger_manifest) {
+      m_file_layout = std::make_unique<hdf5libs::HDF5FileLayout>(m_file_layout_params);
+    }
+    if (m_config_params.background_finalization) {
+      m_file_finalizer = std::make_unique<WorkerPool>(1, get_name().substr(0, 10) + "-fin");
+    }
+    m_write_perf.set_enabled(m_config_params.perf_counters);
+
     if (m_operation_mode != "one-event-per-file"
         //&& m_operation_mode != "one-fragment-per-file"
         && m_operation_mode != "all-per-file") {
@@ -152,6 +198,22 @@ public:
     }
   }
 
+  /**
+   * @brief Waits for the files that are being finalized, and closes the open one, if any
+   */
+  ~HDF5DataStore()
+  {
+    m_file_finalizer.reset();
+    if (m_file_handle.get() != nullptr) {
+      auto hdf5_lock = lock_hdf5();
+      try {
+        close_file();
+      } catch (ers::Issue const& excpt) {
+        ers::error(excpt);
+      }
+    }
+  }
+
   /**
    * @brief HDF5DataStore write()
    * Method used to write constant data
@@ -161,6 +223,7 @@ public:
    */
   virtual void write(const daqdataformats::TriggerRecord& tr)
   {
+    PerfScope perf_scope(m_write_perf);
 
     // check if there is sufficient space for this data block
     size_t current_free_space = get_free_space(m_path);
@@ -185,6 +248,7 @@ public:
     std::string full_filename =
       get_file_name(tr.get_header_ref().get_trigger_number(), tr.get_header_ref().get_run_number());
 
+    auto hdf5_lock = lock_hdf5();
     try {
       open_file_if_needed(full_filename, HighFive::File::OpenOrCreate);
     } catch (std::exception const& excpt) {
@@ -194,9 +258,27 @@ public:
       throw FileOperationProblem(ERS_HERE, get_name(), full_filename);
     }
 
-    // write the data block
-    m_file_handle->write(tr);
+    // write the data block, while the checksums of its Fragments are computed
+    if (m_fragment_checksums) {
+      m_fragment_checksums->start(tr.get_fragments_ref());
+    }
+    try {
+      m_file_handle->write(tr);
+    } catch (...) { // NOLINT(runtime/exceptions)
+      // NOLINT here because we *ARE* re-throwing the exception!
+      if (m_fragment_checksums) {
+        m_fragment_checksums->finish();
+      }
+      throw;
+    }
     m_recorded_size = m_file_handle->get_recorded_size();
+    if (m_fragment_checksums) {
+      store_fragment_checksums(tr.get_header_ref().get_trigger_number(), tr.get_header_ref().get_sequence_number());
+    }
+    if (m_manifest_writer) {
+      add_manifest_entry(tr.get_header_ref().get_trigger_number(), tr.get_header_ref().get_sequence_number());
+    }
+    m_file_cache->update();
   }
 
   /**
@@ -208,6 +290,7 @@ public:
    */
   virtual void write(const daqdataformats::TimeSlice& ts)
   {
+    PerfScope perf_scope(m_write_perf);
 
     // check if there is sufficient space for this data block
     size_t current_free_space = get_free_space(m_path);
@@ -231,6 +314,7 @@ public:
     // determine the filename from Storage Key + configuration parameters
     std::string full_filename = get_file_name(ts.get_header().timeslice_number, ts.get_header().run_number);
 
+    auto hdf5_lock = lock_hdf5();
     try {
       open_file_if_needed(full_filename, HighFive::File::OpenOrCreate);
     } catch (std::exception const& excpt) {
@@ -240,9 +324,27 @@ public:
       throw FileOperationProblem(ERS_HERE, get_name(), full_filename);
     }
 
-    // write the data block
-    m_file_handle->write(ts);
+    // write the data block, while the checksums of its Fragments are computed
+    if (m_fragment_checksums) {
+      m_fragment_checksums->start(ts.get_fragments_ref());
+    }
+    try {
+      m_file_handle->write(ts);
+    } catch (...) { // NOLINT(runtime/exceptions)
+      // NOLINT here because we *ARE* re-throwing the exception!
+      if (m_fragment_checksums) {
+        m_fragment_checksums->finish();
+      }
+      throw;
+    }
     m_recorded_size = m_file_handle->get_recorded_size();
+    if (m_fragment_checksums) {
+      store_fragment_checksums(ts.get_header().timeslice_number, 0);
+    }
+    if (m_manifest_writer) {
+      add_manifest_entry(ts.get_header().timeslice_number, 0);
+    }
+    m_file_cache->update();
   }
 
   /**
@@ -276,8 +378,30 @@ public:
         ERS_HERE, get_name(), m_path, free_space, m_max_file_size, "the configured maximum size of a single file");
     }
 
+    // measured before the first file is opened, so that the probe has the device to itself
+    if (m_bandwidth_probe->is_enabled()) {
+      probe_bandwidth();
+    }
+
     m_file_index = 0;
     m_recorded_size = 0;
+
+    if (m_config_params.trigger_manifest) {
+      try {
+        m_manifest_writer = std::make_unique<TriggerManifestWriter>(get_manifest_journal_name(m_run_number),
+                                                                    m_config_params.trigger_manifest_flush_records);
+      } catch (TriggerManifestProblem const& excpt) {
+        ers::warning(excpt);
+      }
+    }
+
+    // In "all-per-file" mode the name of the first file is known at this point, so it
+    // is created here rather than in the first write(). This keeps the file creation out
+    // of the latency of the first record, and reports problems with it at start.
+    if (m_operation_mode == "all-per-file" && m_config_params.open_file_at_start) {
+      auto hdf5_lock = lock_hdf5();
+      open_file_if_needed(get_file_name(0, m_run_number), HighFive::File::OpenOrCreate);
+    }
   }
 
   /**
@@ -286,23 +410,42 @@ public:
    * This allows the DataStore to close open files and do any other
    * cleanup or shutdown operations that are useful once the writes or
    * reads for a given run number have finished.
+   *
+   * With background_finalization, the last file is flushed, closed and
+   * renamed after this method has returned; the HDF5DataStore destructor
+   * waits for it.
    */
   void finish_with_run(daqdataformats::run_number_t /*run_number*/)
   {
+    auto run_number = m_run_number;
+    m_run_number = 0;
     if (m_file_handle.get() != nullptr) {
-      std::string open_filename = m_file_handle->get_file_name();
-      try {
-        m_file_handle.reset();
-        m_run_number = 0;
-      } catch (std::exception const& excpt) {
-        m_run_number = 0;
-        throw FileOperationProblem(ERS_HERE, get_name(), open_filename, excpt);
-      } catch (...) { // NOLINT(runtime/exceptions)
-        m_run_number = 0;
-        // NOLINT here because we *ARE* re-throwing the exception!
-        throw FileOperationProblem(ERS_HERE, get_name(), open_filename);
-      }
+      auto hdf5_lock = lock_hdf5();
+      close_file();
+    }
+    if (m_manifest_writer) {
+      merge_trigger_manifest(run_number);
+    }
+  }
+
+  /**
+   * @brief Reports the hardware performance counters of the writes and the result of the
+   * last bandwidth measurement, if they are enabled
+   */
+  void get_info(opmonlib::InfoCollector& ci, int /*level*/)
+  {
+    m_write_perf.get_info(ci);
+    if (!m_bandwidth_probe->is_enabled()) {
+      return;
     }
+    hdf5datastoreinfo::Info info;
+    info.probe_bandwidth = m_probe_bandwidth.load();
+    info.probe_expected_rate = m_bandwidth_probe->get_expected_rate();
+    info.probe_latency_p50 = m_probe_latency_p50_us.load();
+    info.probe_latency_p99 = m_probe_latency_p99_us.load();
+    info.probe_latency_max = m_probe_latency_max_us.load();
+    info.probe_slow_block_sizes = m_probe_slow_block_sizes.load();
+    ci.add(info);
   }
 
 private:
@@ -311,13 +454,33 @@ private:
   HDF5DataStore(HDF5DataStore&&) = delete;
   HDF5DataStore& operator=(HDF5DataStore&&) = delete;
 
+  // declared before the file handle, so that the hold is released, and the cache
+  // controller is closed, after the file has been closed
+  std::unique_ptr<FileCacheController> m_file_cache;
+  std::unique_ptr<HDF5FileProperties> m_file_properties;
+  HDF5FileProperties::FileHold m_file_hold;
+
   std::unique_ptr<hdf5libs::HDF5RawDataFile> m_file_handle;
   hdf5libs::hdf5filelayout::FileLayoutParams m_file_layout_params;
+  std::unique_ptr<hdf5libs::HDF5FileLayout> m_file_layout;
+  std::unique_ptr<FragmentChecksums> m_fragment_checksums;
+  std::unique_ptr<TriggerManifestWriter> m_manifest_writer;
   std::string m_basic_name_of_open_file;
   unsigned m_open_flags_of_open_file;
   daqdataformats::run_number_t m_run_number;
   hdf5libs::hdf5rawdatafile::SrcIDGeoIDMap m_hardware_map;
 
+  /**
+   * @brief A file that is being finalized: closing the HDF5RawDataFile flushes the
+   * file and renames it from .writing, after which the hold and cache controller are released
+   */
+  struct ClosingFile
+  {
+    std::unique_ptr<hdf5libs::HDF5RawDataFile> file_handle;
+    HDF5FileProperties::FileHold file_hold;
+    std::unique_ptr<FileCacheController> file_cache;
+  };
+
   // Total number of generated files
   size_t m_file_index;
 
@@ -334,6 +497,135 @@ private:
 
   // std::unique_ptr<HDF5KeyTranslator> m_key_translator_ptr;
 
+  // optional hardware performance counters of the writes
+  PerfSection m_write_perf{ "hdf5_write" };
+
+  // Bandwidth measurement of the output directory, and its last result for opmon
+  std::unique_ptr<StorageBandwidthProbe> m_bandwidth_probe;
+  std::atomic<uint64_t> m_probe_bandwidth{ 0 };        // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_probe_latency_p50_us{ 0 };   // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_probe_latency_p99_us{ 0 };   // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_probe_latency_max_us{ 0 };   // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_probe_slow_block_sizes{ 0 }; // NOLINT(build/unsigned)
+
+  // Background finalization of the files; declared last so that it is destroyed first,
+  // which runs the finalizations that are still queued
+  std::unique_ptr<WorkerPool> m_file_finalizer;
+
+  /**
+   * @brief The HDF5 library is only safe to call from one thread at a time, and the
+   * files may be finalized in the background while the next ones are written, by any
+   * instance of the process. The background finalizations close their HDF5 file under an
+   * exclusive lock, and all the HDF5DataStore instances take a shared lock around their
+   * HDF5 calls: they only wait while a finalization is closing a file, and do not wait for
+   * each other, as without background finalization.
+   */
+  static std::shared_mutex& hdf5_mutex()
+  {
+    static std::shared_mutex s_hdf5_mutex;
+    return s_hdf5_mutex;
+  }
+
+  std::shared_lock<std::shared_mutex> lock_hdf5() { return std::shared_lock<std::shared_mutex>(hdf5_mutex()); }
+
+  /**
+   * @brief Flush, close and rename the open file, in the background if so configured
+   * @throws FileOperationProblem if the file is finalized in the calling thread and that fails
+   * The caller holds the HDF5 lock; a background finalization takes it exclusively when it runs
+   */
+  void close_file()
+  {
+    auto closing = std::make_shared<ClosingFile>();
+    std::string file_name = m_file_handle->get_file_name();
+    closing->file_handle = std::move(m_file_handle);
+    closing->file_hold = std::move(m_file_hold);
+    closing->file_cache = std::move(m_file_cache);
+    m_file_cache = std::make_unique<FileCacheController>(m_config_params.file_cache);
+
+    if (m_file_finalizer == nullptr) {
+      finalize_file(*closing, get_name(), file_name);
+      return;
+    }
+    TLOG_DEBUG(TLVL_BASIC) << get_name() << ": finalizing file " << file_name << " in the background";
+    m_file_finalizer->submit([closing, name = get_name(), file_name]() {
+      try {
+        finalize_file(*closing, name, file_name, &hdf5_mutex());
+      } catch (ers::Issue const& excpt) {
+        ers::error(excpt);
+      }
+    });
+  }
+
+  /**
+   * @brief Measure the bandwidth of the output directory, and warn about the block sizes
+   * that are below the expected rate. A failed measurement is reported, but does not
+   * prevent the run from starting.
+   */
+  void probe_bandwidth()
+  {
+    std::vector<StorageBandwidthProbe::Result> results;
+    try {
+      results = m_bandwidth_probe->run(m_path);
+    } catch (StorageBandwidthProbeFailed const& excpt) {
+      ers::warning(excpt);
+      return;
+    }
+
+    uint64_t bandwidth = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+    uint64_t latency_p50 = 0, latency_p99 = 0, latency_max = 0; // NOLINT(build/unsigned)
+    uint64_t slow_block_sizes = 0;                              // NOLINT(build/unsigned)
+    for (const auto& result : results) {
+      TLOG() << get_name() << ": the output path \"" << m_path << "\" sustained " << result.bandwidth_bytes_per_s
+             << " bytes/s with writes of " << result.block_size << " bytes (latency p50 " << result.latency_p50.count()
+             << " us, p99 " << result.latency_p99.count() << " us, max " << result.latency_max.count() << " us)";
+      if (m_bandwidth_probe->is_below_expected_rate(result)) {
+        ers::warning(InsufficientStorageBandwidth(ERS_HERE,
+                                                  get_name(),
+                                                  m_path,
+                                                  result.block_size,
+                                                  result.bandwidth_bytes_per_s,
+                                                  m_bandwidth_probe->get_expected_rate()));
+        ++slow_block_sizes;
+      }
+      bandwidth = std::min<uint64_t>(bandwidth, result.bandwidth_bytes_per_s);
+      latency_p50 = std::max<uint64_t>(latency_p50, result.latency_p50.count());
+      latency_p99 = std::max<uint64_t>(latency_p99, result.latency_p99.count());
+      latency_max = std::max<uint64_t>(latency_max, result.latency_max.count());
+    }
+    m_probe_bandwidth.store(results.empty() ? 0 : bandwidth);
+    m_probe_latency_p50_us.store(latency_p50);
+    m_probe_latency_p99_us.store(latency_p99);
+    m_probe_latency_max_us.store(latency_max);
+    m_probe_slow_block_sizes.store(slow_block_sizes);
+  }
+
+  /**
+   * @brief Close, flush and rename the HDF5 file, under an exclusive lock if one is given, and then
+   * release its cache, whose write back does not hold up the HDF5 calls of the other threads
+   */
+  static void finalize_file(ClosingFile& closing,
+                            const std::string& name,
+                            const std::string& file_name,
+                            std::shared_mutex* exclusive_hdf5_mutex = nullptr)
+  {
+    try {
+      {
+        std::unique_lock<std::shared_mutex> hdf5_lock;
+        if (exclusive_hdf5_mutex != nullptr) {
+          hdf5_lock = std::unique_lock<std::shared_mutex>(*exclusive_hdf5_mutex);
+        }
+        closing.file_handle.reset();
+        closing.file_hold.reset();
+      }
+      closing.file_cache->close();
+    } catch (std::exception const& excpt) {
+      throw FileOperationProblem(ERS_HERE, name, file_name, excpt);
+    } catch (...) { // NOLINT(runtime/exceptions)
+      // NOLINT here because we *ARE* re-throwing the exception!
+      throw FileOperationProblem(ERS_HERE, name, file_name);
+    }
+  }
+
   /**
    * @brief Translates the specified input parameters into the appropriate filename.
    */
@@ -399,15 +691,7 @@ private:
 
       // close an existing open file
       if (m_file_handle.get() != nullptr) {
-        std::string open_filename = m_file_handle->get_file_name();
-        try {
-          m_file_handle.reset();
-        } catch (std::exception const& excpt) {
-          throw FileOperationProblem(ERS_HERE, get_name(), open_filename, excpt);
-        } catch (...) { // NOLINT(runtime/exceptions)
-          // NOLINT here because we *ARE* re-throwing the exception!
-          throw FileOperationProblem(ERS_HERE, get_name(), open_filename);
-        }
+        close_file();
       }
 
       // opening file for the first time OR something changed in the name or the way of opening the file
@@ -415,6 +699,16 @@ private:
                              << std::to_string(open_flags);
       m_basic_name_of_open_file = file_name;
       m_open_flags_of_open_file = open_flags;
+
+      // files that are written are created beforehand with the configured properties,
+      // and held open until HDF5RawDataFile has closed them
+      if (open_flags != HighFive::File::ReadOnly && !m_file_properties->is_default()) {
+        m_file_hold = m_file_properties->create_and_hold(unique_filename + ".writing");
+        if (!m_file_hold.is_held()) {
+          throw FileOperationProblem(ERS_HERE, get_name(), unique_filename + ".writing");
+        }
+      }
+
       try {
         m_file_handle.reset(new hdf5libs::HDF5RawDataFile(unique_filename,
                                                           m_run_number,
@@ -425,8 +719,10 @@ private:
                                                           ".writing",
                                                           open_flags));
       } catch (std::exception const& excpt) {
+        m_file_hold.reset();
         throw FileOperationProblem(ERS_HERE, get_name(), unique_filename, excpt);
       } catch (...) { // NOLINT(runtime/exceptions)
+        m_file_hold.reset();
         // NOLINT here because we *ARE* re-throwing the exception!
         throw FileOperationProblem(ERS_HERE, get_name(), unique_filename);
       }
@@ -439,6 +735,26 @@ private:
         // write attributes that aren't being handled by the HDF5RawDataFile right now
         // m_file_handle->write_attribute("data_format_version",(int)m_key_translator_ptr->get_current_version());
         m_file_handle->write_attribute("operational_environment", (std::string)m_config_params.operational_environment);
+
+        // the checksums are written, and the record offsets read, through a handle of our own,
+        // with which HDF5 shares the open file
+        if ((m_fragment_checksums || m_manifest_writer) && !m_file_hold.is_held()) {
+          m_file_hold = HDF5FileProperties::FileHold(
+            H5Fopen((unique_filename + ".writing").c_str(), H5F_ACC_RDWR, H5P_DEFAULT));
+        }
+
+        // in all-per-file mode the files grow up to the maximum file size, which is the
+        // space that is reserved for them; the other files are written in one go
+        m_file_cache->open(unique_filename + ".writing", m_operation_mode == "all-per-file" ? m_max_file_size : 0);
+
+        if (m_manifest_writer) {
+          try {
+            m_manifest_writer->add_file(std::filesystem::path(unique_filename).filename().string());
+          } catch (TriggerManifestProblem const& excpt) {
+            ers::warning(excpt);
+            m_manifest_writer.reset();
+          }
+        }
       }
     } else {
       TLOG_DEBUG(TLVL_BASIC) << get_name() << ": Pointer file to  " << m_basic_name_of_open_file
@@ -446,6 +762,107 @@ private:
     }
   }
 
+  void store_fragment_checksums(uint64_t record_number,                      // NOLINT(build/unsigned)
+                                daqdataformats::sequence_number_t sequence_number)
+  {
+    auto checksums = m_fragment_checksums->finish();
+    std::string record_name = m_file_layout->get_record_number_string(record_number, sequence_number);
+
+    std::string error;
+    if (!m_file_hold.is_held()) {
+      error = "the file could not be opened for the checksums";
+    } else {
+      hid_t group_id = H5Gopen2(m_file_hold.get_id(), record_name.c_str(), H5P_DEFAULT);
+      if (group_id < 0) {
+        error = "the group of the record could not be opened";
+      } else {
+        error = FragmentChecksums::write_attribute(group_id, checksums);
+        H5Gclose(group_id);
+      }
+    }
+    if (!error.empty()) {
+      ers::warning(FragmentChecksumsNotStored(ERS_HERE, get_name(), record_name, m_file_handle->get_file_name(), error));
+    }
+  }
+
+  /**
+   * @brief Name shared by the manifest of a run and the journals of its writers
+   */
+  std::string get_manifest_base_name(daqdataformats::run_number_t run_number) const
+  {
+    std::ostringstream work_oss;
+    work_oss << m_config_params.filename_parameters.overall_prefix;
+    if (work_oss.str().length() > 0) {
+      work_oss << "_";
+    }
+    work_oss << m_config_params.filename_parameters.run_number_prefix;
+    work_oss << std::setw(m_config_params.filename_parameters.digits_for_run_number) << std::setfill('0') << run_number;
+    return work_oss.str();
+  }
+
+  std::string get_manifest_journal_name(daqdataformats::run_number_t run_number) const
+  {
+    return (std::filesystem::path(m_path) / (get_manifest_base_name(run_number) + "_" +
+                                             m_config_params.filename_parameters.writer_identifier +
+                                             ".manifest.part"))
+      .string();
+  }
+
+  /**
+   * @brief Record the location of a record written in the open file: the offset is the
+   * address of its header dataset, when the HDF5 library can tell it
+   */
+  void add_manifest_entry(uint64_t record_number,                      // NOLINT(build/unsigned)
+                          daqdataformats::sequence_number_t sequence_number)
+  {
+    uint64_t offset = TriggerManifestWriter::s_unknown_offset; // NOLINT(build/unsigned)
+    if (m_file_hold.is_held()) {
+      std::string dataset_path = m_file_layout->get_record_number_string(record_number, sequence_number) + "/" +
+                                 m_file_layout_params.record_header_dataset_name;
+      hid_t dataset_id = H5I_INVALID_HID;
+      H5E_BEGIN_TRY
+      {
+        dataset_id = H5Dopen2(m_file_hold.get_id(), dataset_path.c_str(), H5P_DEFAULT);
+      }
+      H5E_END_TRY;
+      if (dataset_id >= 0) {
+        haddr_t address = H5Dget_offset(dataset_id);
+        if (address != HADDR_UNDEF) {
+          offset = address;
+        }
+        H5Dclose(dataset_id);
+      }
+    }
+
+    try {
+      m_manifest_writer->add_entry(record_number, sequence_number, offset);
+    } catch (TriggerManifestProblem const& excpt) {
+      ers::warning(excpt);
+      m_manifest_writer.reset();
+    }
+  }
+
+  /**
+   * @brief Close the journal of this writer, and merge it into the manifest of the run, which
+   * deletes it. The other writers of the run merge their own journals when they finish, so the
+   * manifest is complete once the last one has finished.
+   */
+  void merge_trigger_manifest(daqdataformats::run_number_t run_number)
+  {
+    std::string journal_name = m_manifest_writer->get_journal_path();
+    m_manifest_writer.reset();
+
+    std::string manifest_name =
+      (std::filesystem::path(m_path) / (get_manifest_base_name(run_number) + ".manifest")).string();
+    try {
+      auto entries = TriggerManifest::merge({ journal_name }, manifest_name);
+      TLOG() << get_name() << ": merged " << journal_name << " into the trigger manifest " << manifest_name << " ("
+             << entries << " records)";
+    } catch (TriggerManifestProblem const& excpt) {
+      ers::warning(excpt);
+    }
+  }
+
   size_t get_free_space(const std::string& the_path)
   {
     struct statvfs vfs_results;
@@ -0,0 +1,227 @@
+/**
+ * @file HDF5FileProperties.hpp
+ *
+ * HDF5FileProperties builds the HDF5 file access and file creation property
+ * lists configured for the HDF5DataStore, and creates files with them.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_PLUGINS_HDF5FILEPROPERTIES_HPP_
+#define DFMODULES_PLUGINS_HDF5FILEPROPERTIES_HPP_
+
+#include "dfmodules/hdf5datastore/Structs.hpp"
+
+#include "ers/Issue.hpp"
+
+#include "hdf5.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+
+namespace dunedaq {
+
+// Disable coverage checking LCOV_EXCL_START
+ERS_DECLARE_ISSUE(dfmodules,
+                  InvalidHDF5FileProperties,
+                  "Invalid HDF5 file properties: " << reason,
+                  ((std::string)reason))
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief HDF5FileProperties holds the file access (FAPL) and file creation (FCPL)
+ * property lists of the HDF5DataStore files.
+ *
+ * HDF5RawDataFile opens its files with the library defaults, so the properties are
+ * applied by creating the file beforehand with create_and_hold(), and keeping that
+ * handle open while HDF5RawDataFile opens the same file: the creation properties are
+ * stored in the file, and HDF5 shares the open file, with the access properties of the
+ * first open, between the two handles. The held handle has to be closed once the
+ * HDF5RawDataFile has been closed, which is what the FileHold class takes care of.
+ */
+class HDF5FileProperties
+{
+public:
+  /**
+   * @brief Owner of a file handle that is closed when the owner is destroyed or reset
+   */
+  class FileHold
+  {
+  public:
+    FileHold() = default;
+    explicit FileHold(hid_t file_id)
+      : m_file_id(file_id)
+    {}
+    ~FileHold() { reset(); }
+
+    FileHold(const FileHold&) = delete;
+    FileHold& operator=(const FileHold&) = delete;
+    FileHold(FileHold&& other)
+      : m_file_id(other.m_file_id)
+    {
+      other.m_file_id = H5I_INVALID_HID;
+    }
+    FileHold& operator=(FileHold&& other)
+    {
+      if (this != &other) {
+        reset();
+        m_file_id = other.m_file_id;
+        other.m_file_id = H5I_INVALID_HID;
+      }
+      return *this;
+    }
+
+    void reset()
+    {
+      if (m_file_id >= 0) {
+        H5Fclose(m_file_id);
+        m_file_id = H5I_INVALID_HID;
+      }
+    }
+    bool is_held() const { return m_file_id >= 0; }
+    hid_t get_id() const { return m_file_id; }
+
+  private:
+    hid_t m_file_id{ H5I_INVALID_HID };
+  };
+
+  /**
+   * @throws InvalidHDF5FileProperties if the configuration is inconsistent or rejected by the HDF5 library
+   */
+  explicit HDF5FileProperties(const hdf5datastore::FileProperties& conf)
+    : m_conf(conf)
+  {
+    m_fapl = H5Pcreate(H5P_FILE_ACCESS);
+    m_fcpl = H5Pcreate(H5P_FILE_CREATE);
+    if (m_fapl < 0 || m_fcpl < 0) {
+      close();
+      throw InvalidHDF5FileProperties(ERS_HERE, "unable to create the property lists");
+    }
+    try {
+      apply();
+    } catch (...) { // NOLINT(runtime/exceptions)
+      close();
+      throw;
+    }
+  }
+
+  ~HDF5FileProperties() { close(); }
+
+  HDF5FileProperties(const HDF5FileProperties&) = delete;
+  HDF5FileProperties& operator=(const HDF5FileProperties&) = delete;
+  HDF5FileProperties(HDF5FileProperties&&) = delete;
+  HDF5FileProperties& operator=(HDF5FileProperties&&) = delete;
+
+  /**
+   * @brief Whether all the properties are left to the library defaults, in which case there is nothing to apply
+   */
+  bool is_default() const { return m_is_default; }
+
+  hid_t get_fapl() const { return m_fapl; }
+  hid_t get_fcpl() const { return m_fcpl; }
+
+  /**
+   * @brief Create a file with the configured properties, or open it with the access properties
+   * if it already exists, and hold it open
+   * @return The hold, which is empty if the file could not be created or opened
+   */
+  FileHold create_and_hold(const std::string& file_name) const
+  {
+    if (std::filesystem::exists(file_name)) {
+      return FileHold(H5Fopen(file_name.c_str(), H5F_ACC_RDWR, m_fapl));
+    }
+    return FileHold(H5Fcreate(file_name.c_str(), H5F_ACC_EXCL, m_fcpl, m_fapl));
+  }
+
+private:
+  void check(herr_t status, const std::string& what)
+  {
+    if (status < 0) {
+      throw InvalidHDF5FileProperties(ERS_HERE, "the HDF5 library rejected the " + what);
+    }
+    m_is_default = false;
+  }
+
+  void apply()
+  {
+    bool paged = false;
+    if (m_conf.file_space_strategy != "default") {
+      H5F_fspace_strategy_t strategy;
+      if (m_conf.file_space_strategy == "fsm_aggr") {
+        strategy = H5F_FSPACE_STRATEGY_FSM_AGGR;
+      } else if (m_conf.file_space_strategy == "page") {
+        strategy = H5F_FSPACE_STRATEGY_PAGE;
+        paged = true;
+      } else if (m_conf.file_space_strategy == "aggr") {
+        strategy = H5F_FSPACE_STRATEGY_AGGR;
+      } else if (m_conf.file_space_strategy == "none") {
+        strategy = H5F_FSPACE_STRATEGY_NONE;
+      } else {
+        throw InvalidHDF5FileProperties(ERS_HERE, "unknown file space strategy \"" + m_conf.file_space_strategy + "\"");
+      }
+      check(H5Pset_file_space_strategy(m_fcpl, strategy, m_conf.file_space_persist, 1), "file space strategy");
+    }
+    if (m_conf.file_space_page_size > 0) {
+      if (!paged) {
+        throw InvalidHDF5FileProperties(ERS_HERE, "file_space_page_size needs the \"page\" file space strategy");
+      }
+      check(H5Pset_file_space_page_size(m_fcpl, m_conf.file_space_page_size), "file space page size");
+    }
+    if (m_conf.page_buffer_size > 0) {
+      if (!paged) {
+        throw InvalidHDF5FileProperties(ERS_HERE, "page_buffer_size needs the \"page\" file space strategy");
+      }
+      check(H5Pset_page_buffer_size(m_fapl, m_conf.page_buffer_size, 0, 0), "page buffer size");
+    }
+
+    if (m_conf.metadata_cache_size_bytes > 0) {
+      H5AC_cache_config_t mdc_config;
+      mdc_config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+      check(H5Pget_mdc_config(m_fapl, &mdc_config), "metadata cache configuration");
+      mdc_config.set_initial_size = true;
+      mdc_config.initial_size = m_conf.metadata_cache_size_bytes;
+      mdc_config.max_size = std::max<size_t>(mdc_config.max_size, m_conf.metadata_cache_size_bytes);
+      mdc_config.min_size = std::min<size_t>(mdc_config.min_size, m_conf.metadata_cache_size_bytes);
+      check(H5Pset_mdc_config(m_fapl, &mdc_config), "metadata cache size");
+    }
+    if (m_conf.alignment > 1) {
+      check(H5Pset_alignment(m_fapl, m_conf.alignment_threshold, m_conf.alignment), "alignment");
+    }
+    if (m_conf.sieve_buffer_size > 0) {
+      check(H5Pset_sieve_buf_size(m_fapl, m_conf.sieve_buffer_size), "sieve buffer size");
+    }
+    if (m_conf.meta_block_size > 0) {
+      check(H5Pset_meta_block_size(m_fapl, m_conf.meta_block_size), "meta block size");
+    }
+    if (m_conf.use_latest_format) {
+      check(H5Pset_libver_bounds(m_fapl, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST), "latest format bounds");
+    }
+  }
+
+  void close()
+  {
+    if (m_fapl >= 0) {
+      H5Pclose(m_fapl);
+      m_fapl = H5I_INVALID_HID;
+    }
+    if (m_fcpl >= 0) {
+      H5Pclose(m_fcpl);
+      m_fcpl = H5I_INVALID_HID;
+    }
+  }
+
+  hdf5datastore::FileProperties m_conf;
+  hid_t m_fapl{ H5I_INVALID_HID };
+  hid_t m_fcpl{ H5I_INVALID_HID };
+  bool m_is_default{ true };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_PLUGINS_HDF5FILEPROPERTIES_HPP_
@@ -8,6 +8,7 @@
 
 #include "TPStreamWriter.hpp"
 #include "dfmodules/CommonIssues.hpp"
+#include "dfmodules/InstrumentedMutex.hpp"
 #include "dfmodules/TPBundleHandler.hpp"
 #include "dfmodules/tpstreamwriter/Nljs.hpp"
 #include "dfmodules/tpstreamwriterinfo/InfoNljs.hpp"
@@ -41,6 +42,7 @@ TPStreamWriter::TPStreamWriter(const std::string& name)
   : dunedaq::appfwk::DAQModule(name)
   , m_thread(std::bind(&TPStreamWriter::do_work, this, std::placeholders::_1))
   , m_queue_timeout(100)
+  , m_run_report(name, "TPStreamWriter")
 {
   register_command("conf", &TPStreamWriter::do_conf);
   register_command("start", &TPStreamWriter::do_start);
@@ -57,7 +59,7 @@ TPStreamWriter::init(const nlohmann::json& payload)
 }
 
 void
-TPStreamWriter::get_info(opmonlib::InfoCollector& ci, int /*level*/)
+TPStreamWriter::get_info(opmonlib::InfoCollector& ci, int level)
 {
   tpstreamwriterinfo::Info info;
 
@@ -66,6 +68,13 @@ TPStreamWriter::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   info.bytes_output = m_bytes_output.exchange(0);
 
   ci.add(info);
+  m_get_timeslice_perf.get_info(ci);
+  LockProfiler::get_info(ci, get_name());
+
+  std::lock_guard<std::mutex> lk(m_data_writer_mutex);
+  if (m_data_writer) {
+    m_data_writer->get_info(ci, level);
+  }
 }
 
 void
@@ -75,10 +84,15 @@ TPStreamWriter::do_conf(const data_t& payload)
   tpstreamwriter::ConfParams conf_params = payload.get<tpstreamwriter::ConfParams>();
   m_accumulation_interval_ticks = conf_params.tp_accumulation_interval_ticks;
   m_source_id = conf_params.source_id;
+  m_thread_placement = ThreadPlacement(conf_params.thread_placement);
+  m_get_timeslice_perf.set_enabled(conf_params.perf_counters);
+  m_run_report.configure(conf_params.run_report);
 
   // create the DataStore instance here
   try {
-    m_data_writer = make_data_store(payload["data_store_parameters"]);
+    auto data_store = make_data_store(payload["data_store_parameters"]);
+    std::lock_guard<std::mutex> lk(m_data_writer_mutex);
+    m_data_writer = std::move(data_store);
   } catch (const ers::Issue& excpt) {
     throw UnableToConfigure(ERS_HERE, get_name(), excpt);
   }
@@ -108,6 +122,7 @@ TPStreamWriter::do_start(const nlohmann::json& payload)
     throw UnableToStart(ERS_HERE, get_name(), m_run_number, excpt);
   }
 
+  m_run_report.start(m_run_number);
   m_thread.start_working_thread(get_name());
 
   TLOG() << get_name() << " successfully started for run number " << m_run_number;
@@ -128,6 +143,7 @@ TPStreamWriter::do_stop(const nlohmann::json& /*payload*/)
   } catch (const std::exception& excpt) {
     ers::error(ProblemDuringStop(ERS_HERE, get_name(), m_run_number, excpt));
   }
+  m_run_report.stop();
 
   TLOG() << get_name() << " successfully stopped for run number " << m_run_number;
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
@@ -139,6 +155,7 @@ TPStreamWriter::do_scrap(const data_t& /*payload*/)
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_scrap() method";
 
   // clear/reset the DataStore instance here
+  std::lock_guard<std::mutex> lk(m_data_writer_mutex);
   m_data_writer.reset();
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_scrap() method";
@@ -149,13 +166,16 @@ TPStreamWriter::do_work(std::atomic<bool>& running_flag)
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_work() method";
 
+  m_thread_placement.apply_to_current_thread(get_name());
+
   using namespace std::chrono;
   size_t n_tpset_received = 0;
   auto start_time = steady_clock::now();
   daqdataformats::timestamp_t first_timestamp = 0;
   daqdataformats::timestamp_t last_timestamp = 0;
 
-  TPBundleHandler tp_bundle_handler(m_accumulation_interval_ticks, m_run_number, std::chrono::seconds(1));
+  TPBundleHandler tp_bundle_handler(
+    m_accumulation_interval_ticks, m_run_number, std::chrono::seconds(1), &m_get_timeslice_perf, get_name());
 
   while (running_flag.load()) {
     trigger::TPSet tpset;
@@ -163,6 +183,7 @@ TPStreamWriter::do_work(std::atomic<bool>& running_flag)
       tpset = m_tpset_source->receive(m_queue_timeout);
       ++n_tpset_received;
       ++m_tpset_received;
+      m_run_tpsets_received.add();
     } catch (iomanager::TimeoutExpired&) {
       continue;
     }
@@ -194,14 +215,18 @@ TPStreamWriter::do_work(std::atomic<bool>& running_flag)
       // write the TSH and the fragments as a set of data blocks
       bool should_retry = true;
       size_t retry_wait_usec = 1000;
+      auto write_start = steady_clock::now();
       do {
         should_retry = false;
         try {
           m_data_writer->write(*timeslice_ptr);
 	  ++m_tpset_written;
 	  m_bytes_output += timeslice_ptr->get_total_size_bytes();
+	  m_run_timeslices_written.add();
+	  m_run_bytes_output.add(timeslice_ptr->get_total_size_bytes());
         } catch (const RetryableDataStoreProblem& excpt) {
           should_retry = true;
+          m_run_write_retries.add();
           ers::error(DataWritingProblem(ERS_HERE,
                                         get_name(),
                                         timeslice_ptr->get_header().timeslice_number,
@@ -213,6 +238,7 @@ TPStreamWriter::do_work(std::atomic<bool>& running_flag)
           usleep(retry_wait_usec);
           retry_wait_usec *= 2;
         } catch (const std::exception& excpt) {
+          m_run_write_failures.add();
           ers::error(DataWritingProblem(ERS_HERE,
                                         get_name(),
                                         timeslice_ptr->get_header().timeslice_number,
@@ -220,6 +246,7 @@ TPStreamWriter::do_work(std::atomic<bool>& running_flag)
                                         excpt));
         }
       } while (should_retry && running_flag.load());
+      m_run_write_latency.record(duration_cast<microseconds>(steady_clock::now() - write_start));
     }
 
     if (first_timestamp == 0) {
@@ -235,6 +262,7 @@ TPStreamWriter::do_work(std::atomic<bool>& running_flag)
 
   TLOG() << "Received " << n_tpset_received << " TPSets in " << time_ms << "ms. " << rate_hz
          << " TPSet/s. Inferred clock frequency " << inferred_clock_frequency << "Hz";
+  m_run_report.set_value("inferred_clock_frequency_hz", inferred_clock_frequency);
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
 } // NOLINT Function length
 
@@ -12,6 +12,9 @@
 #define DFMODULES_PLUGINS_TPSTREAMWRITER_HPP_
 
 #include "dfmodules/DataStore.hpp"
+#include "dfmodules/PerfCounters.hpp"
+#include "dfmodules/RunReport.hpp"
+#include "dfmodules/ThreadPlacement.hpp"
 
 #include "appfwk/DAQModule.hpp"
 #include "iomanager/Receiver.hpp"
@@ -20,6 +23,7 @@
 #include "utilities/WorkerThread.hpp"
 
 #include <memory>
+#include <mutex>
 #include <string>
 
 namespace dunedaq {
@@ -55,6 +59,7 @@ private:
   // Threading
   dunedaq::utilities::WorkerThread m_thread;
   void do_work(std::atomic<bool>&);
+  ThreadPlacement m_thread_placement;
 
   // Configuration
   std::chrono::milliseconds m_queue_timeout;
@@ -69,12 +74,25 @@ private:
 
   // Worker(s)
   std::unique_ptr<DataStore> m_data_writer;
+  std::mutex m_data_writer_mutex; // guards the creation and reset of m_data_writer against get_info()
 
   // Metrics
   std::atomic<uint64_t> m_tpset_received = { 0 };         // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_tpset_written  = { 0 };         // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_bytes_output   = { 0 };         // NOLINT(build/unsigned)
 
+  // optional hardware performance counters of the assembly of the TimeSlices
+  PerfSection m_get_timeslice_perf{ "get_timeslice" };
+
+  // end-of-run report, whose figures are not reset by get_info()
+  RunReport m_run_report;
+  RunReport::Counter& m_run_tpsets_received = m_run_report.add_counter("tpsets_received");
+  RunReport::Counter& m_run_timeslices_written = m_run_report.add_counter("timeslices_written");
+  RunReport::Counter& m_run_bytes_output = m_run_report.add_counter("bytes_output");
+  RunReport::Counter& m_run_write_retries = m_run_report.add_counter("write_retries");
+  RunReport::Counter& m_run_write_failures = m_run_report.add_counter("write_failures");
+  RunReport::Latency& m_run_write_latency = m_run_report.add_latency("write");
+
 };
 } // namespace dfmodules
 
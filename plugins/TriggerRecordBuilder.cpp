@@ -25,6 +25,7 @@
 #include <limits>
 #include <memory>
 #include <numeric>
+#include <set>
 #include <string>
 #include <thread>
 #include <utility>
@@ -47,12 +48,37 @@ namespace dfmodules {
 
 using daqdataformats::TriggerRecordErrorBits;
 
+namespace {
+
+// Deep copy of a TriggerRecord, made with one copy of each Fragment buffer
+std::unique_ptr<daqdataformats::TriggerRecord>
+clone_trigger_record(daqdataformats::TriggerRecord& record)
+{
+  auto copy = std::make_unique<daqdataformats::TriggerRecord>(record.get_header_ref());
+  for (const auto& fragment : record.get_fragments_ref()) {
+    copy->add_fragment(std::make_unique<daqdataformats::Fragment>(
+      fragment->get_storage_location(), daqdataformats::Fragment::BufferAdoptionMode::kCopyFromBuffer));
+  }
+  return copy;
+}
+
+} // namespace
+
 TriggerRecordBuilder::TriggerRecordBuilder(const std::string& name)
   : dunedaq::appfwk::DAQModule(name)
   , m_thread(std::bind(&TriggerRecordBuilder::do_work, this, std::placeholders::_1))
   , m_queue_timeout(100)
+  , m_flight_recorder(name)
+  , m_run_report(name, "TriggerRecordBuilder")
 {
 
+  m_flight_recorder.add_gauge("pending_trigger_decisions", [this]() { return m_trigger_decisions_counter.load(); });
+  m_flight_recorder.add_gauge("fragments_in_the_book", [this]() { return m_fragment_counter.load(); });
+  m_flight_recorder.add_gauge("pending_fragments", [this]() { return m_pending_fragment_counter.load(); });
+  m_flight_recorder.add_gauge("timed_out_trigger_records", [this]() { return m_timed_out_trigger_records.load(); });
+  m_flight_recorder.add_gauge("abandoned_trigger_records", [this]() { return m_abandoned_trigger_records.load(); });
+  m_flight_recorder.add_gauge("unexpected_fragments", [this]() { return m_unexpected_fragments.load(); });
+
   register_command("conf", &TriggerRecordBuilder::do_conf);
   register_command("scrap", &TriggerRecordBuilder::do_scrap);
   register_command("start", &TriggerRecordBuilder::do_start);
@@ -73,8 +99,6 @@ TriggerRecordBuilder::init(const data_t& init_data)
 
   auto iom = iomanager::IOManager::get();
   m_trigger_decision_input = iom->get_receiver<dfmessages::TriggerDecision>(ci["trigger_decision_input"]);
-  m_trigger_record_output =
-    iom->get_sender<std::unique_ptr<daqdataformats::TriggerRecord>>(ci["trigger_record_output"]);
 
   m_fragment_input = iom->get_receiver<std::unique_ptr<daqdataformats::Fragment>>(ci["data_fragment_all"]);
   if (ci.count("mon_connection") > 0) {
@@ -85,14 +109,29 @@ TriggerRecordBuilder::init(const data_t& init_data)
   // copied into the DataRequests so that data producers know where to send their fragments
   m_reply_connection = ci["data_fragment_all"];
 
+  // the records are sent to "trigger_record_output" and to any "trigger_record_output_*"
+  // connection, each one normally leading to a different DataWriter
+  std::map<std::string, std::string> record_output_conn_ref_map;
   m_producer_conn_ref_map.clear();
+  m_batch_conn_ref_map.clear();
   auto ini = init_data.get<appfwk::app::ModInit>();
   for (const auto &cr : ini.conn_refs) {
-    if (cr.name.find("request_output_") != std::string::npos) {
+    if (cr.name.rfind("request_batch_output_", 0) == 0) {
+      m_batch_conn_ref_map[cr.name] = cr.uid;
+    } else if (cr.name.find("request_output_") != std::string::npos) {
       m_producer_conn_ref_map[cr.name] = cr.uid;
+    } else if (cr.name == "trigger_record_output" || cr.name.rfind("trigger_record_output_", 0) == 0) {
+      record_output_conn_ref_map[cr.name] = cr.uid;
     }
   }
 
+  m_trigger_record_outputs.clear();
+  for (const auto& [conn_name, uid] : record_output_conn_ref_map) {
+    m_trigger_record_outputs.push_back(iom->get_sender<trigger_record_ptr_t>(uid));
+  }
+  TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": " << m_trigger_record_outputs.size()
+                                      << " TriggerRecord output connections";
+
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting init() method";
 }
 
@@ -115,20 +154,38 @@ TriggerRecordBuilder::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   i.lost_fragments = m_lost_fragments.load();
   i.invalid_requests = m_invalid_requests.load();
   i.duplicated_trigger_ids = m_duplicated_trigger_ids.load();
+  i.rerequested_fragments = m_rerequested_fragments.load();
+  i.recovered_fragments = m_recovered_fragments.load();
+  i.duplicate_fragments = m_duplicate_fragments.load();
 
   // operation metrics
   i.received_trigger_decisions = m_received_trigger_decisions.exchange(0);
   i.generated_trigger_records = m_generated_trigger_records.exchange(0);
   i.generated_data_requests = m_generated_data_requests.exchange(0);
+  i.sent_data_request_batches = m_sent_data_request_batches.exchange(0);
+  i.batched_data_requests = m_batched_data_requests.exchange(0);
+  i.data_request_batching_time = m_data_request_batching_time.exchange(0);
   i.sleep_counter = m_sleep_counter.exchange(0);
   i.loop_counter = m_loop_counter.exchange(0);
   i.data_waiting_time = m_data_waiting_time.exchange(0);
   i.data_request_width = m_data_request_width.exchange(0);
   i.trigger_decision_width = m_trigger_decision_width.exchange(0);
+  i.adaptive_timeout_records = m_adaptive_timeout_records.exchange(0);
+  i.adaptive_timeout_total_us = m_adaptive_timeout_total.exchange(0);
+  i.adaptive_timeout_min_us = m_adaptive_timeout_min.exchange(0);
+  i.adaptive_timeout_max_us = m_adaptive_timeout_max.exchange(0);
   i.received_trmon_requests = m_trmon_request_counter.exchange(0);
   i.sent_trmon = m_trmon_sent_counter.exchange(0);
 
+  // summaries of suppressed issues are also due when the issues stop occurring
+  m_timed_out_issue_limiter.check_summary();
+  m_unexpected_fragment_issue_limiter.check_summary();
+  m_rerequest_issue_limiter.check_summary();
+
   ci.add(i);
+  m_fragment_intake_perf.get_info(ci);
+  m_record_completion_perf.get_info(ci);
+  LockProfiler::get_info(ci, get_name());
 }
 
 void
@@ -141,15 +198,37 @@ TriggerRecordBuilder::do_conf(const data_t& payload)
   triggerrecordbuilder::ConfParams parsed_conf = payload.get<triggerrecordbuilder::ConfParams>();
 
   m_trigger_timeout = duration_type(parsed_conf.trigger_record_timeout_ms);
+  m_rerequest_timeout = duration_type(parsed_conf.fragment_rerequest_timeout_ms);
+  m_max_rerequests = parsed_conf.max_fragment_rerequests;
+  m_latency_tracker.configure(parsed_conf.adaptive_timeout, m_trigger_timeout);
+  if (m_latency_tracker.is_enabled()) {
+    TLOG() << get_name() << ": adaptive trigger record timeouts between "
+           << parsed_conf.adaptive_timeout.min_timeout_ms << " and " << m_trigger_timeout.count() << " ms";
+  }
 
   m_loop_sleep = m_queue_timeout = std::chrono::milliseconds(parsed_conf.general_queue_timeout);
+  m_record_output_skip_timeout = std::chrono::milliseconds(parsed_conf.record_output_skip_timeout_ms);
+  m_data_request_batch_size = parsed_conf.data_request_batch_size;
+  m_data_request_batch_window = std::chrono::microseconds(parsed_conf.data_request_batch_window_us);
 
   TLOG() << get_name() << ": timeouts (ms): queue = " << m_queue_timeout.count() << ", loop = " << m_loop_sleep.count();
   m_max_time_window = parsed_conf.max_time_window;
+  m_max_queued_mon_records = parsed_conf.max_queued_trmon_records;
 
   m_this_trb_source_id.subsystem = daqdataformats::SourceID::Subsystem::kTRBuilder;
   m_this_trb_source_id.id = parsed_conf.source_id;
 
+  m_thread_placement = ThreadPlacement(parsed_conf.thread_placement);
+  m_flight_recorder.configure(parsed_conf.flight_recorder);
+  m_fragment_intake_perf.set_enabled(parsed_conf.perf_counters);
+  m_record_completion_perf.set_enabled(parsed_conf.perf_counters);
+  m_run_report.configure(parsed_conf.run_report);
+
+  auto summary_interval = std::chrono::milliseconds(parsed_conf.issue_summary_interval_ms);
+  m_timed_out_issue_limiter.configure(parsed_conf.max_reported_issues, summary_interval);
+  m_unexpected_fragment_issue_limiter.configure(parsed_conf.max_reported_issues, summary_interval);
+  m_rerequest_issue_limiter.configure(parsed_conf.max_reported_issues, summary_interval);
+
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_conf() method";
 }
 
@@ -174,9 +253,50 @@ TriggerRecordBuilder::do_start(const data_t& args)
   // Register the callback to receive monitoring requests
   if (m_mon_receiver) {
     m_mon_requests.clear();
+    m_mon_sending = true;
+    m_mon_sender = std::make_unique<WorkerPool>(1, get_name().substr(0, 10) + "-mon");
     m_mon_receiver->add_callback(std::bind(&TriggerRecordBuilder::tr_requested, this, std::placeholders::_1));
   }
 
+  // Resolve the DataRequest senders now rather than when the first request for each
+  // SourceID is dispatched, so that the first trigger of the run does not pay for it
+  // and connection problems are reported at start
+  for (const auto& [conn_name, uid] : m_producer_conn_ref_map) {
+    try {
+      get_iom_sender<dfmessages::DataRequest>(uid);
+    } catch (ers::Issue const& iss) {
+      ers::warning(ConnectionWarmUpFailed(ERS_HERE, conn_name, uid, iss));
+    }
+  }
+
+  m_pending_batches.clear();
+  m_batch_of_sourceid.clear();
+  if (m_data_request_batch_size > 1) {
+    for (const auto& [conn_name, uid] : m_batch_conn_ref_map) {
+      try {
+        m_pending_batches[uid].sender = get_iom_sender<DataRequestBatch>(uid);
+      } catch (ers::Issue const& iss) {
+        ers::warning(ConnectionWarmUpFailed(ERS_HERE, conn_name, uid, iss));
+      }
+    }
+  }
+
+  m_loop_sleep = m_queue_timeout;
+  if (m_producer_conn_ref_map.size() > 0) {
+    m_loop_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(
+      m_queue_timeout / (2. + log2(m_producer_conn_ref_map.size())));
+    if (m_loop_sleep.count() == 0) {
+      m_loop_sleep = m_queue_timeout;
+    }
+  }
+  TLOG_DEBUG(TLVL_WORK_STEPS) << get_name() << ": " << m_producer_conn_ref_map.size()
+                              << " DataRequest connections, loop sleep = " << m_loop_sleep.count() << " ms";
+
+  m_next_record_output = 0;
+  m_record_output_of_trigger.clear();
+
+  m_flight_recorder.start(*m_run_number);
+  m_run_report.start(*m_run_number);
   m_thread.start_working_thread(get_name());
   TLOG() << get_name() << " successfully started";
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_start() method";
@@ -193,6 +313,13 @@ TriggerRecordBuilder::do_stop(const data_t& /*args*/)
   }
 
   m_thread.stop_working_thread();
+
+  // The copies that are still queued are given a single attempt each
+  m_mon_sending = false;
+  m_mon_sender.reset();
+
+  m_flight_recorder.stop();
+  m_run_report.stop();
   TLOG() << get_name() << " successfully stopped";
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_stop() method";
 }
@@ -207,9 +334,55 @@ TriggerRecordBuilder::tr_requested(const dfmessages::TRMonRequest& req)
     return;
 
   // Add requests to pending requests
-  // To be done: choose a concurrent container implementation.
-  const std::lock_guard<std::mutex> lock(m_mon_mutex);
-  m_mon_requests.push_back(req);
+  m_mon_requests.add(req);
+}
+
+void
+TriggerRecordBuilder::send_to_monitoring(daqdataformats::TriggerRecord& record)
+{
+  auto trigger_type = record.get_header_data().trigger_type;
+  if (!m_mon_requests.may_have(trigger_type)) {
+    return;
+  }
+
+  // While the sender is behind, the requests are left for the next TRs of their type
+  if (m_queued_mon_records.load() >= m_max_queued_mon_records) {
+    return;
+  }
+  auto requests = m_mon_requests.take(trigger_type);
+  if (requests.empty()) {
+    return;
+  }
+
+  // the record that is sent to monitoring is a flat copy of the header and of each fragment buffer
+  auto record_copy = std::make_shared<trigger_record_ptr_t>(clone_trigger_record(record));
+  ++m_queued_mon_records;
+  m_mon_sender->submit([this, record_copy, requests = std::move(requests)]() {
+    auto iom = iomanager::IOManager::get();
+    for (size_t i = 0; i < requests.size(); ++i) {
+      bool last_request = (i + 1 == requests.size());
+      bool wasSentSuccessfully = false;
+      do {
+        try {
+          // the last destination gets the copy itself, the others a copy of it
+          trigger_record_ptr_t extra_copy;
+          if (!last_request) {
+            extra_copy = clone_trigger_record(**record_copy);
+          }
+          trigger_record_ptr_t& record_to_send = last_request ? *record_copy : extra_copy;
+          iom->get_sender<trigger_record_ptr_t>(requests[i].data_destination)
+            ->send(std::move(record_to_send), m_queue_timeout);
+          ++m_trmon_sent_counter;
+          wasSentSuccessfully = true;
+        } catch (const ers::Issue& excpt) {
+          std::ostringstream oss_warn;
+          oss_warn << "Sending TR to connection \"" << requests[i].data_destination << "\" failed";
+          ers::warning(iomanager::OperationFailed(ERS_HERE, oss_warn.str(), excpt));
+        }
+      } while (m_mon_sending.load() && !wasSentSuccessfully);
+    }
+    --m_queued_mon_records;
+  });
 }
 
 void
@@ -217,8 +390,15 @@ TriggerRecordBuilder::do_work(std::atomic<bool>& running_flag)
 {
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering do_work() method";
 
+  m_thread_placement.apply_to_current_thread(get_name());
+
   // clean books from possible previous memory
   m_trigger_records.clear();
+  m_rerequest_states.clear();
+  m_rerequested_records_sent.clear();
+  m_record_deadlines.clear();
+  m_latency_tracker.reset();
+  m_next_rerequest_check = clock_type::now();
   m_trigger_decisions_counter.store(0);
   m_unexpected_trigger_decisions.store(0);
   m_pending_fragment_counter.store(0);
@@ -230,6 +410,9 @@ TriggerRecordBuilder::do_work(std::atomic<bool>& running_flag)
   m_lost_fragments.store(0);
   m_invalid_requests.store(0);
   m_duplicated_trigger_ids.store(0);
+  m_rerequested_fragments.store(0);
+  m_recovered_fragments.store(0);
+  m_duplicate_fragments.store(0);
 
   bool run_again = false;
 
@@ -284,12 +467,16 @@ TriggerRecordBuilder::do_work(std::atomic<bool>& running_flag)
     } // if books were updated
 
     //-------------------------------------------------
-    // Check if some fragments are obsolete
+    // Request the late fragments again, and check if some fragments are obsolete
     //--------------------------------------------------
+    request_missing_fragments(running_flag);
     book_updates |= check_stale_requests(running_flag);
 
     run_again = book_updates || new_fragments;
 
+    // the batches are sent without waiting for their time window when there is nothing else to do
+    flush_data_request_batches(!run_again, running_flag);
+
     if (!run_again) {
       if (running_flag.load()) {
         ++m_sleep_counter;
@@ -301,6 +488,8 @@ TriggerRecordBuilder::do_work(std::atomic<bool>& running_flag)
 
   } // working loop
 
+  flush_data_request_batches(true, running_flag);
+
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Starting draining phase ";
   std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
 
@@ -328,6 +517,11 @@ TriggerRecordBuilder::do_work(std::atomic<bool>& running_flag)
            << std::endl
            << "Draining took : " << time_span.count() << " s";
   TLOG() << ProgressUpdate(ERS_HERE, get_name(), oss_summ.str());
+  m_run_report.set_value("draining_time_s", time_span.count());
+
+  m_timed_out_issue_limiter.flush();
+  m_unexpected_fragment_issue_limiter.flush();
+  m_rerequest_issue_limiter.flush();
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Exiting do_work() method";
 } // NOLINT(readability/fn_size)
@@ -347,6 +541,8 @@ TriggerRecordBuilder::read_fragments()
   if (!temp_fragment)
     return false;
 
+  PerfScope perf_scope(m_fragment_intake_perf);
+
   TLOG_DEBUG(TLVL_FRAGMENT_RECEIVE) << get_name() << " Received fragment for trigger/sequence_number "
                                     << temp_fragment.value()->get_trigger_number() << "."
                                     << temp_fragment.value()->get_sequence_number() << " from "
@@ -374,14 +570,44 @@ TriggerRecordBuilder::read_fragments()
 
   } // if there is a corresponding trigger ID entry in the boook
 
+  // once a fragment has been requested again, both the late and the new copy may arrive
   if (requested) {
+    auto state = m_rerequest_states.find(temp_id);
+    if (state != m_rerequest_states.end() && state->second.attempts > 0) {
+      auto source_id = temp_fragment.value()->get_element_id();
+      for (const auto& fragment : it->second.second->get_fragments_ref()) {
+        if (fragment->get_element_id() == source_id) {
+          ++m_duplicate_fragments;
+          m_run_duplicate_fragments.add();
+          return true;
+        }
+      }
+      ++m_recovered_fragments;
+    }
+  }
+
+  if (requested) {
+    if (m_latency_tracker.is_enabled()) {
+      m_latency_tracker.add_sample(
+        temp_fragment.value()->get_element_id(),
+        std::chrono::duration_cast<FragmentLatencyTracker::duration_type>(clock_type::now() - it->second.first));
+    }
     it->second.second->add_fragment(std::move(*temp_fragment));
     ++m_fragment_counter;
     --m_pending_fragment_counter;
+    m_run_fragments.add();
+    m_run_fragments_in_book.observe(m_fragment_counter.load());
+  } else if (it == m_trigger_records.end() && m_rerequested_records_sent.count(temp_id) > 0) {
+    // the other copy of a fragment that was requested again, after its record was sent
+    ++m_duplicate_fragments;
+    m_run_duplicate_fragments.add();
   } else {
-    ers::error(UnexpectedFragment(
-      ERS_HERE, temp_id, temp_fragment.value()->get_fragment_type_code(), temp_fragment.value()->get_element_id()));
+    if (m_unexpected_fragment_issue_limiter.should_report(temp_id.trigger_number)) {
+      ers::error(UnexpectedFragment(
+        ERS_HERE, temp_id, temp_fragment.value()->get_fragment_type_code(), temp_fragment.value()->get_element_id()));
+    }
     ++m_unexpected_fragments;
+    m_run_unexpected_fragments.add();
   }
 
   return true;
@@ -412,6 +638,7 @@ TriggerRecordBuilder::read_and_process_trigger_decision(iomanager::Receiver::tim
   }
 
   ++m_received_trigger_decisions;
+  m_run_trigger_decisions.add();
 
   bool book_updates = create_trigger_records_and_dispatch(*temp_dec, running) > 0;
 
@@ -430,8 +657,20 @@ TriggerRecordBuilder::extract_trigger_record(const TriggerId& id)
   auto duration = time - it->second.first;
 
   m_data_waiting_time += std::chrono::duration_cast<duration_type>(duration).count();
+  m_run_building_latency.record(std::chrono::duration_cast<std::chrono::microseconds>(duration));
 
   m_trigger_records.erase(it);
+  auto state = m_rerequest_states.find(id);
+  if (state != m_rerequest_states.end()) {
+    if (state->second.attempts > 0) {
+      m_rerequested_records_sent.insert(id);
+      if (m_rerequested_records_sent.size() > s_max_rerequested_records_sent) {
+        m_rerequested_records_sent.erase(m_rerequested_records_sent.begin());
+      }
+    }
+    m_rerequest_states.erase(state);
+  }
+  m_record_deadlines.erase(id);
 
   --m_trigger_decisions_counter;
   m_fragment_counter -= temp->get_fragments_ref().size();
@@ -441,6 +680,7 @@ TriggerRecordBuilder::extract_trigger_record(const TriggerId& id)
   if (missing_fragments > 0) {
 
     m_lost_fragments += missing_fragments;
+    m_run_lost_fragments.add(missing_fragments);
     m_pending_fragment_counter -= missing_fragments;
     temp->get_header_ref().set_error_bit(TriggerRecordErrorBits::kIncomplete, true);
 
@@ -534,8 +774,21 @@ TriggerRecordBuilder::create_trigger_records_and_dispatch(const dfmessages::Trig
     tr.get_header_ref().set_trigger_type(td.trigger_type);
     tr.get_header_ref().set_element_id(m_this_trb_source_id);
 
+    if (m_rerequest_timeout.count() > 0) {
+      m_rerequest_states[slice_id] = RerequestState{ entry.first, 0, td.readout_type };
+    }
+
+    if (m_latency_tracker.is_enabled()) {
+      auto timeout = m_latency_tracker.get_timeout(slice_components);
+      m_record_deadlines[slice_id] = entry.first + timeout;
+      account_adaptive_timeout(timeout);
+      TLOG_DEBUG(TLVL_BOOKKEEPING) << get_name() << ": TR " << slice_id << " times out after " << timeout.count()
+                                   << " us";
+    }
+
     m_trigger_decisions_counter++;
     m_pending_fragment_counter += slice_components.size();
+    m_run_records_in_book.observe(m_trigger_decisions_counter.load());
     ++new_tr_counter;
 
     // create and send the requests
@@ -572,8 +825,12 @@ TriggerRecordBuilder::dispatch_data_requests(dfmessages::DataRequest dr,
 
 {
 
+  if (m_data_request_batch_size > 1 && batch_data_request(dr, sid, running)) {
+    return true;
+  }
+
   // find the queue for sourceid_req in the map
-  std::unique_lock<std::mutex> lk(m_map_sourceid_connections_mutex);
+  std::unique_lock<InstrumentedMutex> lk(m_map_sourceid_connections_mutex);
   std::shared_ptr<data_req_sender_t> sender = nullptr;
   auto it_req = m_map_sourceid_connections.find(sid);
   if (it_req == m_map_sourceid_connections.end() || it_req->second == nullptr) {
@@ -587,12 +844,6 @@ TriggerRecordBuilder::dispatch_data_requests(dfmessages::DataRequest dr,
         sender = get_iom_sender<dfmessages::DataRequest>(uid);
 
         m_map_sourceid_connections[sid] = sender;
-
-        m_loop_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(
-                m_queue_timeout / (2. + log2(m_map_sourceid_connections.size())));
-        if (m_loop_sleep.count() == 0) {
-          m_loop_sleep = m_queue_timeout;
-        }
       }
     } catch (ers::Issue const& iss) {
       // if sourceid request is not valid. then trhow error and continue
@@ -626,6 +877,7 @@ TriggerRecordBuilder::dispatch_data_requests(dfmessages::DataRequest dr,
       sender->send(std::move(dr), m_queue_timeout);
       wasSentSuccessfully = true;
       ++m_generated_data_requests;
+      m_run_data_requests.add();
     } catch (const ers::Issue& excpt) {
       std::ostringstream oss_warn;
       oss_warn << "Send to connection \"" << sender->get_name() << "\" failed";
@@ -636,64 +888,265 @@ TriggerRecordBuilder::dispatch_data_requests(dfmessages::DataRequest dr,
   return wasSentSuccessfully;
 }
 
+bool
+TriggerRecordBuilder::batch_data_request(dfmessages::DataRequest& dr,
+                                         const daqdataformats::SourceID& sid,
+                                         std::atomic<bool>& running)
+{
+  auto it_batch = m_batch_of_sourceid.find(sid);
+  if (it_batch == m_batch_of_sourceid.end()) {
+    PendingBatch* pending = nullptr;
+    auto map_element = m_batch_conn_ref_map.find("request_batch_output_" + sid.to_string());
+    if (map_element != m_batch_conn_ref_map.end()) {
+      pending = &m_pending_batches[map_element->second];
+    }
+    it_batch = m_batch_of_sourceid.emplace(sid, pending).first;
+  }
+
+  PendingBatch* pending = it_batch->second;
+  if (pending == nullptr) {
+    return false;
+  }
+  if (pending->sender == nullptr) {
+    try {
+      auto uid = m_batch_conn_ref_map.at("request_batch_output_" + sid.to_string());
+      pending->sender = get_iom_sender<DataRequestBatch>(uid);
+    } catch (ers::Issue const& iss) {
+      // the requests of this SourceID are sent individually until the connection can be resolved
+      TLOG_DEBUG(TLVL_DISPATCH_DATAREQ) << get_name() << ": no batch sender for SourceID " << sid << ": " << iss;
+      return false;
+    }
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (pending->batch.requests.empty()) {
+    pending->first_request = now;
+    pending->batch.requests.reserve(m_data_request_batch_size);
+  }
+  pending->enqueue_time_sum +=
+    std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+  pending->batch.requests.push_back(std::move(dr));
+
+  if (pending->batch.requests.size() >= m_data_request_batch_size) {
+    flush_data_request_batches(false, running);
+  }
+  return true;
+}
+
+void
+TriggerRecordBuilder::flush_data_request_batches(bool force, std::atomic<bool>& running)
+{
+  auto now = std::chrono::steady_clock::now();
+  for (auto& [uid, pending] : m_pending_batches) {
+    size_t batch_size = pending.batch.requests.size();
+    if (batch_size == 0) {
+      continue;
+    }
+    if (!force && batch_size < m_data_request_batch_size && now - pending.first_request < m_data_request_batch_window) {
+      continue;
+    }
+
+    auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    auto waiting_time = now_us * static_cast<std::chrono::microseconds::rep>(batch_size) - pending.enqueue_time_sum;
+
+    bool wasSentSuccessfully = false;
+    do {
+      TLOG_DEBUG(TLVL_DISPATCH_DATAREQ) << get_name() << ": Pushing a batch of " << batch_size
+                                        << " DataRequests onto connection :" << pending.sender->get_name();
+      try {
+        // on failure, the batch is left untouched and can be sent again
+        pending.sender->send(std::move(pending.batch), m_queue_timeout);
+        wasSentSuccessfully = true;
+      } catch (const ers::Issue& excpt) {
+        std::ostringstream oss_warn;
+        oss_warn << "Send to connection \"" << pending.sender->get_name() << "\" failed";
+        ers::warning(iomanager::OperationFailed(ERS_HERE, oss_warn.str(), excpt));
+      }
+    } while (!wasSentSuccessfully && running.load());
+
+    if (wasSentSuccessfully) {
+      ++m_sent_data_request_batches;
+      m_batched_data_requests += batch_size;
+      m_generated_data_requests += batch_size;
+      m_run_data_requests.add(batch_size);
+      m_data_request_batching_time += waiting_time;
+    } else {
+      m_invalid_requests += batch_size;
+    }
+    pending.batch.requests.clear();
+    pending.enqueue_time_sum = 0;
+  }
+}
+
 bool
 TriggerRecordBuilder::send_trigger_record(const TriggerId& id, std::atomic<bool>& running)
 {
+  PerfScope perf_scope(m_record_completion_perf);
 
   trigger_record_ptr_t temp_record(extract_trigger_record(id));
 
   // Send to monitoring, if needed
-
   if (m_mon_receiver) {
-    const std::lock_guard<std::mutex> lock(m_mon_mutex);
-    auto it = m_mon_requests.begin();
-    while (it != m_mon_requests.end()) {
-      // send TR to mon if correct trigger type
-      if (it->trigger_type == temp_record->get_header_data().trigger_type) {
-        auto iom = iomanager::IOManager::get();
-        bool wasSentSuccessfully = false;
-        do {
-          try {
-            // HACK to copy the trigger record so we can send it off to monitoring
-            auto trigger_record_bytes =
-              serialization::serialize(temp_record, serialization::SerializationType::kMsgPack);
-            trigger_record_ptr_t record_copy = serialization::deserialize<trigger_record_ptr_t>(trigger_record_bytes);
-            iom->get_sender<trigger_record_ptr_t>(it->data_destination)->send(std::move(record_copy), m_queue_timeout);
-            ++m_trmon_sent_counter;
-            wasSentSuccessfully = true;
-          } catch (const ers::Issue& excpt) {
-            std::ostringstream oss_warn;
-            oss_warn << "Sending TR to connection \"" << it->data_destination << "\" failed";
-            ers::warning(iomanager::OperationFailed(ERS_HERE, oss_warn.str(), excpt));
-          }
-        } while (running.load() && !wasSentSuccessfully);
-        it = m_mon_requests.erase(it);
-      } else {
-        ++it;
-      }
-    }
-  } // if m_mon_receiver
+    send_to_monitoring(*temp_record);
+  }
+
+  // all the sequences of a trigger go to the same output, so that a single DataWriter sees all of them
+  auto trigger_number = temp_record->get_header_ref().get_trigger_number();
+  size_t sequence_count = temp_record->get_header_ref().get_max_sequence_number() + 1;
+  auto assigned = m_record_output_of_trigger.find(trigger_number);
 
   bool wasSentSuccessfully = false;
-  do {
-    try {
-      m_trigger_record_output->send(std::move(temp_record), m_queue_timeout);
-      wasSentSuccessfully = true;
-      ++m_generated_trigger_records;
-    } catch (const ers::Issue& excpt) {
-      ers::warning(excpt);
+  size_t output_index = 0;
+  if (assigned != m_record_output_of_trigger.end()) {
+    output_index = assigned->second.output_index;
+    do {
+      try {
+        m_trigger_record_outputs[output_index]->send(std::move(temp_record), m_queue_timeout);
+        wasSentSuccessfully = true;
+      } catch (const ers::Issue& excpt) {
+        ers::warning(excpt);
+      }
+    } while (running.load() && !wasSentSuccessfully); // push while loop
+  } else {
+    wasSentSuccessfully = send_to_next_record_output(temp_record, output_index, running);
+    if (sequence_count > 1) {
+      assigned =
+        m_record_output_of_trigger.emplace(trigger_number, RecordOutputAssignment{ output_index, sequence_count }).first;
     }
-  } while (running.load() && !wasSentSuccessfully); // push while loop
+  }
+
+  if (wasSentSuccessfully) {
+    ++m_generated_trigger_records;
+    m_run_trigger_records.add();
+  }
+  if (assigned != m_record_output_of_trigger.end() && --assigned->second.sequences_left == 0) {
+    m_record_output_of_trigger.erase(assigned);
+  }
 
   if (!wasSentSuccessfully) {
     ++m_abandoned_trigger_records;
     m_lost_fragments += temp_record->get_fragments_ref().size();
+    m_run_abandoned_records.add();
+    m_run_lost_fragments.add(temp_record->get_fragments_ref().size());
     ers::error(dunedaq::dfmodules::AbandonedTriggerDecision(ERS_HERE, id));
   }
 
   return wasSentSuccessfully;
 }
 
+bool
+TriggerRecordBuilder::send_to_next_record_output(trigger_record_ptr_t& record,
+                                                 size_t& output_index,
+                                                 std::atomic<bool>& running)
+{
+  // Round-robin over the outputs, skipping the ones that can't take the record within
+  // the skip timeout; the last output tried in a round is given the full queue timeout,
+  // so that a round where all the outputs are full is equivalent to a single output being full
+  const size_t output_count = m_trigger_record_outputs.size();
+  do {
+    for (size_t attempt = 0; attempt < output_count; ++attempt) {
+      size_t index = (m_next_record_output + attempt) % output_count;
+      bool last_attempt = (attempt + 1 == output_count);
+      try {
+        m_trigger_record_outputs[index]->send(std::move(record),
+                                              last_attempt ? m_queue_timeout : m_record_output_skip_timeout);
+        output_index = index;
+        m_next_record_output = (index + 1) % output_count;
+        return true;
+      } catch (const iomanager::TimeoutExpired& excpt) {
+        if (last_attempt) {
+          ers::warning(excpt);
+        }
+      } catch (const ers::Issue& excpt) {
+        ers::warning(excpt);
+      }
+    }
+  } while (running.load());
+
+  return false;
+}
+
+void
+TriggerRecordBuilder::request_missing_fragments(std::atomic<bool>& running)
+{
+  if (m_rerequest_timeout.count() == 0 || m_max_rerequests == 0) {
+    return;
+  }
+
+  // the book is not scanned more often than a fraction of the timeout
+  auto now = clock_type::now();
+  if (now < m_next_rerequest_check) {
+    return;
+  }
+  m_next_rerequest_check = now + m_rerequest_timeout / 4;
+
+  for (auto& [id, state] : m_rerequest_states) {
+
+    if (state.attempts >= m_max_rerequests || now - state.last_request < m_rerequest_timeout) {
+      continue;
+    }
+
+    auto it = m_trigger_records.find(id);
+    if (it == m_trigger_records.end()) {
+      continue;
+    }
+    daqdataformats::TriggerRecord& tr = *it->second.second;
+    daqdataformats::TriggerRecordHeader& header = tr.get_header_ref();
+    if (tr.get_fragments_ref().size() >= header.get_num_requested_components()) {
+      continue;
+    }
+
+    std::set<daqdataformats::SourceID> received;
+    for (const auto& fragment : tr.get_fragments_ref()) {
+      received.insert(fragment->get_element_id());
+    }
+
+    ++state.attempts;
+    state.last_request = now;
+    size_t missing_fragments = 0;
+    for (size_t i = 0; i < header.get_num_requested_components(); ++i) {
+      const daqdataformats::ComponentRequest& request = header[i];
+      if (received.count(request.component) > 0) {
+        continue;
+      }
+
+      dfmessages::DataRequest dataReq;
+      dataReq.trigger_number = header.get_trigger_number();
+      dataReq.sequence_number = header.get_sequence_number();
+      dataReq.run_number = header.get_run_number();
+      dataReq.trigger_timestamp = header.get_trigger_timestamp();
+      dataReq.readout_type = state.readout_type;
+      dataReq.request_information = request;
+      dataReq.data_destination = m_reply_connection;
+      if (dispatch_data_requests(std::move(dataReq), request.component, running)) {
+        ++missing_fragments;
+      }
+    }
+
+    m_rerequested_fragments += missing_fragments;
+    m_run_rerequested_fragments.add(missing_fragments);
+    if (m_rerequest_issue_limiter.should_report(id.trigger_number)) {
+      ers::warning(FragmentsRequestedAgain(ERS_HERE, id, missing_fragments, state.attempts));
+    }
+  }
+}
+
+void
+TriggerRecordBuilder::account_adaptive_timeout(FragmentLatencyTracker::duration_type timeout)
+{
+  auto us = static_cast<metric_counter_type>(timeout.count());
+  ++m_adaptive_timeout_records;
+  m_adaptive_timeout_total += us;
+  // the minimum and maximum are reset to 0 by get_info()
+  auto min = m_adaptive_timeout_min.load();
+  if (min == 0 || us < min) {
+    m_adaptive_timeout_min.store(us);
+  }
+  if (us > m_adaptive_timeout_max.load()) {
+    m_adaptive_timeout_max.store(us);
+  }
+}
+
 bool
 TriggerRecordBuilder::check_stale_requests(std::atomic<bool>& running)
 {
@@ -707,20 +1160,42 @@ TriggerRecordBuilder::check_stale_requests(std::atomic<bool>& running)
   if (m_trigger_timeout.count() > 0) {
 
     std::vector<TriggerId> stale_triggers;
+    auto now = clock_type::now();
 
     for (auto it = m_trigger_records.begin(); it != m_trigger_records.end(); ++it) {
 
       daqdataformats::TriggerRecord& tr = *it->second.second;
 
-      auto tr_time = clock_type::now() - it->second.first;
+      auto deadline = it->second.first + m_trigger_timeout;
+      if (m_latency_tracker.is_enabled()) {
+        auto record_deadline = m_record_deadlines.find(it->first);
+        if (record_deadline != m_record_deadlines.end()) {
+          deadline = record_deadline->second;
+        }
+      }
+
+      if (now > deadline) {
 
-      if (tr_time > m_trigger_timeout) {
+        auto timeout = deadline - it->second.first;
+        if (m_timed_out_issue_limiter.should_report(it->first.trigger_number)) {
+          ers::error(TimedOutTriggerDecision(ERS_HERE,
+                                             it->first,
+                                             tr.get_header_ref().get_trigger_timestamp(),
+                                             std::chrono::duration_cast<duration_type>(timeout).count()));
+        }
+        m_flight_recorder.request_dump("TimedOutTriggerDecision");
 
-        ers::error(TimedOutTriggerDecision(ERS_HERE, it->first, tr.get_header_ref().get_trigger_timestamp()));
+        // the missing fragments are at least as late as the timeout: without them, the latency
+        // estimates of the sources that miss their deadlines would stay too low
+        if (m_latency_tracker.is_enabled()) {
+          add_missing_fragment_latencies(tr,
+                                         std::chrono::duration_cast<FragmentLatencyTracker::duration_type>(timeout));
+        }
 
         // mark trigger record for seding
         stale_triggers.push_back(it->first);
         ++m_timed_out_trigger_records;
+        m_run_timed_out_records.add();
 
         book_updates = true;
       }
@@ -737,6 +1212,26 @@ TriggerRecordBuilder::check_stale_requests(std::atomic<bool>& running)
   return book_updates;
 }
 
+void
+TriggerRecordBuilder::add_missing_fragment_latencies(const daqdataformats::TriggerRecord& tr,
+                                                     FragmentLatencyTracker::duration_type latency)
+{
+  const auto& header = tr.get_header_ref();
+  for (size_t i = 0; i < header.get_num_requested_components(); ++i) {
+    auto source_id = header.at(i).component;
+    bool received = false;
+    for (const auto& fragment : tr.get_fragments_ref()) {
+      if (fragment->get_element_id() == source_id) {
+        received = true;
+        break;
+      }
+    }
+    if (!received) {
+      m_latency_tracker.add_sample(source_id, latency);
+    }
+  }
+}
+
 } // namespace dfmodules
 } // namespace dunedaq
 
@@ -9,6 +9,16 @@
 #ifndef DFMODULES_PLUGINS_TRIGGERRECORDBUILDER_HPP_
 #define DFMODULES_PLUGINS_TRIGGERRECORDBUILDER_HPP_
 
+#include "dfmodules/DataRequestBatch.hpp"
+#include "dfmodules/FlightRecorder.hpp"
+#include "dfmodules/FragmentLatencyTracker.hpp"
+#include "dfmodules/InstrumentedMutex.hpp"
+#include "dfmodules/IssueRateLimiter.hpp"
+#include "dfmodules/PerfCounters.hpp"
+#include "dfmodules/RunReport.hpp"
+#include "dfmodules/ThreadPlacement.hpp"
+#include "dfmodules/TRMonRequestIndex.hpp"
+#include "dfmodules/WorkerPool.hpp"
 #include "dfmodules/triggerrecordbuilderinfo/InfoNljs.hpp"
 
 #include "daqdataformats/Fragment.hpp"
@@ -26,10 +36,10 @@
 #include "iomanager/Receiver.hpp"
 
 #include <chrono>
-#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -112,9 +122,11 @@ ERS_DECLARE_ISSUE(dfmodules,                 ///< Namespace
  */
 ERS_DECLARE_ISSUE(dfmodules,               ///< Namespace
                   TimedOutTriggerDecision, ///< Issue class name
-                  "trigger id: " << trigger_id << " generate at: " << trigger_timestamp << " timed out", ///< Message
+                  "trigger id: " << trigger_id << " generate at: " << trigger_timestamp << " timed out after "
+                                 << timeout_ms << " ms", ///< Message
                   ((dfmodules::TriggerId)trigger_id)               ///< Message parameters
                   ((daqdataformats::timestamp_t)trigger_timestamp) ///< Message parameters
+                  ((int64_t)timeout_ms)                            ///< Message parameters
 )
 
 /**
@@ -146,6 +158,18 @@ ERS_DECLARE_ISSUE(dfmodules,                ///< Namespace
                   ((dfmodules::TriggerId)trigger_id) ///< Message parameters
 )
 
+/**
+ * @brief Fragments requested again
+ */
+ERS_DECLARE_ISSUE(dfmodules,               ///< Namespace
+                  FragmentsRequestedAgain, ///< Issue class name
+                  "trigger ID " << trigger_id << ": " << missing_fragments << " missing fragments requested again (attempt "
+                                << attempt << ')',
+                  ((dfmodules::TriggerId)trigger_id) ///< Message parameters
+                  ((size_t)missing_fragments)        ///< Message parameters
+                  ((unsigned)attempt)                ///< Message parameters
+)
+
 /**
  * @brief Missing connection ID
  */
@@ -182,9 +206,17 @@ public:
   void init(const data_t&) override;
   void get_info(opmonlib::InfoCollector& ci, int level) override;
 
+  using clock_type = std::chrono::high_resolution_clock;
+  /**
+   * @brief Book of the TriggerRecords being built, with the time at which each of them was created
+   */
+  using trigger_record_book_t =
+    std::map<TriggerId, std::pair<clock_type::time_point, std::unique_ptr<daqdataformats::TriggerRecord>>>;
+
 protected:
   using trigger_decision_receiver_t = iomanager::ReceiverConcept<dfmessages::TriggerDecision>;
   using data_req_sender_t = iomanager::SenderConcept<dfmessages::DataRequest>;
+  using data_req_batch_sender_t = iomanager::SenderConcept<DataRequestBatch>;
   using fragment_receiver_t = iomanager::ReceiverConcept<std::unique_ptr<daqdataformats::Fragment>>;
 
   using trigger_record_ptr_t = std::unique_ptr<daqdataformats::TriggerRecord>;
@@ -205,12 +237,31 @@ protected:
                               const daqdataformats::SourceID&,
                               std::atomic<bool>& running);
 
+  bool batch_data_request(dfmessages::DataRequest&, const daqdataformats::SourceID&, std::atomic<bool>& running);
+  // this adds the request to the batch of its SourceID, if it has one, and returns false otherwise
+
+  void flush_data_request_batches(bool force, std::atomic<bool>& running);
+  // this sends the batches that are full or old enough, or all of them when forced
+
   bool send_trigger_record(const TriggerId&, std::atomic<bool>& running);
   // this creates a trigger record and send it
 
+  bool send_to_next_record_output(trigger_record_ptr_t& record, size_t& output_index, std::atomic<bool>& running);
+  // this sends a record to the next output that can take it, and returns the index of that output
+
   bool check_stale_requests(std::atomic<bool>& running);
   // it returns true when there are changes in the book = a TR timed out
 
+  void add_missing_fragment_latencies(const daqdataformats::TriggerRecord& tr,
+                                      FragmentLatencyTracker::duration_type latency);
+  // this accounts for the fragments missing from a TR that timed out in the latency estimates
+
+  void account_adaptive_timeout(FragmentLatencyTracker::duration_type timeout);
+  // this adds the timeout chosen for a TR to the metrics
+
+  void request_missing_fragments(std::atomic<bool>& running);
+  // this sends the data requests again for the fragments that are late
+
 private:
   // Commands
   void do_conf(const data_t&);
@@ -220,10 +271,12 @@ private:
 
   // Monitoring callback
   void tr_requested(const dfmessages::TRMonRequest &);
+  void send_to_monitoring(daqdataformats::TriggerRecord& record);
 
   // Threading
   dunedaq::utilities::WorkerThread m_thread;
   void do_work(std::atomic<bool>&);
+  ThreadPlacement m_thread_placement;
 
   // Configuration
   std::chrono::milliseconds m_queue_timeout;
@@ -237,24 +290,67 @@ private:
 
   // Output connections
   std::map<std::string, std::string> m_producer_conn_ref_map;
-  std::shared_ptr<trigger_record_sender_t> m_trigger_record_output;
-  mutable std::mutex m_map_sourceid_connections_mutex;
+  std::vector<std::shared_ptr<trigger_record_sender_t>> m_trigger_record_outputs; ///< In connection name order
+  std::chrono::milliseconds m_record_output_skip_timeout;
+  size_t m_next_record_output = 0;
+  struct RecordOutputAssignment
+  {
+    size_t output_index;
+    size_t sequences_left;
+  };
+  std::map<daqdataformats::trigger_number_t, RecordOutputAssignment> m_record_output_of_trigger; ///< Multi-sequence triggers in progress
+  mutable InstrumentedMutex m_map_sourceid_connections_mutex{ get_name(), "TriggerRecordBuilder.sourceid_connections" };
   std::map<daqdataformats::SourceID, std::shared_ptr<data_req_sender_t>> m_map_sourceid_connections; ///< Mappinng between SourceID and connections
 
+  // Batching of the DataRequests, for the SourceIDs with a request_batch_output_* connection;
+  // the batches are kept per connection, and only accessed by the working thread
+  std::map<std::string, std::string> m_batch_conn_ref_map;
+  size_t m_data_request_batch_size = 0;
+  std::chrono::microseconds m_data_request_batch_window;
+  struct PendingBatch
+  {
+    std::shared_ptr<data_req_batch_sender_t> sender;
+    DataRequestBatch batch;
+    std::chrono::steady_clock::time_point first_request;
+    std::chrono::microseconds::rep enqueue_time_sum = 0; ///< Sum of the request enqueue times, in us since the epoch
+  };
+  std::map<std::string, PendingBatch> m_pending_batches; ///< By connection uid
+  std::map<daqdataformats::SourceID, PendingBatch*> m_batch_of_sourceid; ///< nullptr for SourceIDs without batching
+
   // bookeeping
-  using clock_type = std::chrono::high_resolution_clock;
-  std::map<TriggerId, std::pair<clock_type::time_point, trigger_record_ptr_t>> m_trigger_records;
+  trigger_record_book_t m_trigger_records;
 
   // Data request properties
   daqdataformats::timestamp_diff_t m_max_time_window;
 
+  // Requests of late fragments, only kept when they are enabled
+  struct RerequestState
+  {
+    clock_type::time_point last_request;
+    unsigned attempts;
+    dfmessages::ReadoutType readout_type;
+  };
+  std::map<TriggerId, RerequestState> m_rerequest_states;
+  clock_type::time_point m_next_rerequest_check;
+  // Recently sent records that had requests again, whose late copies are duplicates; the oldest are dropped
+  static constexpr size_t s_max_rerequested_records_sent = 1000;
+  std::set<TriggerId> m_rerequested_records_sent;
+
+  // Per-record deadlines, only kept when the adaptive timeouts are enabled
+  FragmentLatencyTracker m_latency_tracker;
+  std::map<TriggerId, clock_type::time_point> m_record_deadlines;
+
   // Run information
   std::unique_ptr<const daqdataformats::run_number_t> m_run_number = nullptr;
 
   // Monitoring related variables
-  std::mutex m_mon_mutex;
   std::shared_ptr<iomanager::ReceiverConcept<dfmessages::TRMonRequest>> m_mon_receiver;
-  std::list<dfmessages::TRMonRequest> m_mon_requests;
+  TRMonRequestIndex m_mon_requests{ get_name(), "TriggerRecordBuilder.mon" };
+  // the copies of the TRs are sent to monitoring off the record output path, while the run is going on
+  std::atomic<bool> m_mon_sending{ false };
+  std::unique_ptr<WorkerPool> m_mon_sender;
+  std::atomic<size_t> m_queued_mon_records{ 0 };
+  size_t m_max_queued_mon_records{ 10 };
 
   // book related metrics
   using metric_counter_type = decltype(triggerrecordbuilderinfo::Info::pending_trigger_decisions);
@@ -269,23 +365,66 @@ private:
   mutable std::atomic<metric_counter_type> m_invalid_requests = { 0 };             // in the run
   mutable std::atomic<metric_counter_type> m_duplicated_trigger_ids = { 0 };       // in the run
   mutable std::atomic<metric_counter_type> m_abandoned_trigger_records = { 0 };    // in the run
+  mutable std::atomic<metric_counter_type> m_rerequested_fragments = { 0 };        // in the run
+  mutable std::atomic<metric_counter_type> m_recovered_fragments = { 0 };          // in the run
+  mutable std::atomic<metric_counter_type> m_duplicate_fragments = { 0 };          // in the run
 
   mutable std::atomic<metric_counter_type> m_received_trigger_decisions = { 0 }; // in between calls
   mutable std::atomic<metric_counter_type> m_generated_trigger_records = { 0 };  // in between calls
   mutable std::atomic<metric_counter_type> m_generated_data_requests = { 0 };    // in between calls
+  mutable std::atomic<metric_counter_type> m_sent_data_request_batches = { 0 };  // in between calls
+  mutable std::atomic<metric_counter_type> m_batched_data_requests = { 0 };      // in between calls
+  mutable std::atomic<metric_counter_type> m_data_request_batching_time = { 0 }; // in between calls
   mutable std::atomic<metric_counter_type> m_sleep_counter = { 0 };              // in between calls
   mutable std::atomic<metric_counter_type> m_loop_counter = { 0 };               // in between calls
   mutable std::atomic<metric_counter_type> m_data_waiting_time = { 0 };          // in between calls
   mutable std::atomic<metric_counter_type> m_trigger_decision_width = { 0 };     // in between calls
   mutable std::atomic<metric_counter_type> m_data_request_width = { 0 };         // in between calls
+  mutable std::atomic<metric_counter_type> m_adaptive_timeout_records = { 0 };   // in between calls
+  mutable std::atomic<metric_counter_type> m_adaptive_timeout_total = { 0 };     // in between calls
+  mutable std::atomic<metric_counter_type> m_adaptive_timeout_min = { 0 };       // in between calls
+  mutable std::atomic<metric_counter_type> m_adaptive_timeout_max = { 0 };       // in between calls
 
   mutable std::atomic<metric_counter_type> m_trmon_request_counter = { 0 };
   mutable std::atomic<metric_counter_type> m_trmon_sent_counter = { 0 };
 
+  // rate limiting of the issues that can be reported for every record or fragment
+  IssueRateLimiter m_timed_out_issue_limiter{ "TimedOutTriggerDecision" };
+  IssueRateLimiter m_unexpected_fragment_issue_limiter{ "UnexpectedFragment" };
+  IssueRateLimiter m_rerequest_issue_limiter{ "FragmentsRequestedAgain",
+                                              10,
+                                              std::chrono::milliseconds(10000),
+                                              IssueRateLimiter::Severity::kWarning };
+
+  // recent history of the book, dumped when a TriggerDecision times out
+  FlightRecorder m_flight_recorder;
+
+  // optional hardware performance counters of the hot sections
+  PerfSection m_fragment_intake_perf{ "fragment_intake" };
+  PerfSection m_record_completion_perf{ "record_completion" };
+
+  // end-of-run report, whose figures are not reset by get_info()
+  RunReport m_run_report;
+  RunReport::Counter& m_run_trigger_decisions = m_run_report.add_counter("trigger_decisions");
+  RunReport::Counter& m_run_trigger_records = m_run_report.add_counter("trigger_records");
+  RunReport::Counter& m_run_fragments = m_run_report.add_counter("fragments");
+  RunReport::Counter& m_run_data_requests = m_run_report.add_counter("data_requests");
+  RunReport::Counter& m_run_rerequested_fragments = m_run_report.add_counter("rerequested_fragments");
+  RunReport::Counter& m_run_timed_out_records = m_run_report.add_counter("timed_out_trigger_records");
+  RunReport::Counter& m_run_abandoned_records = m_run_report.add_counter("abandoned_trigger_records");
+  RunReport::Counter& m_run_lost_fragments = m_run_report.add_counter("lost_fragments");
+  RunReport::Counter& m_run_unexpected_fragments = m_run_report.add_counter("unexpected_fragments");
+  RunReport::Counter& m_run_duplicate_fragments = m_run_report.add_counter("duplicate_fragments");
+  RunReport::Latency& m_run_building_latency = m_run_report.add_latency("trigger_record_building");
+  RunReport::Peak& m_run_records_in_book = m_run_report.add_peak("trigger_records_in_the_book");
+  RunReport::Peak& m_run_fragments_in_book = m_run_report.add_peak("fragments_in_the_book");
+
   // time thresholds
   using duration_type = std::chrono::milliseconds;
   duration_type m_old_trigger_threshold;
   duration_type m_trigger_timeout;
+  duration_type m_rerequest_timeout;
+  unsigned m_max_rerequests;
 };
 } // namespace dfmodules
 } // namespace dunedaq
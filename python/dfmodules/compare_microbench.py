@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+
+# Compares two result files of the dfmodules_microbench application, typically
+# from two commits built and run on the same machine, and reports the change of
+# the median time per operation of every benchmark that both files contain.
+
+import json
+import sys
+
+import click
+
+# Add -h as default help option
+CONTEXT_SETTINGS = dict(help_option_names=['-h', '--help'])
+
+def load_results(file_name):
+    with open(file_name) as f:
+        output = json.load(f)
+    results = {}
+    for result in output["results"]:
+        key = (result["benchmark"], json.dumps(result["parameters"], sort_keys=True))
+        results[key] = result
+    return output.get("label", ""), results
+
+@click.command(context_settings=CONTEXT_SETTINGS)
+@click.option('-t', '--threshold', default=10.0, help="Change of the median time per operation, in percent, above which a benchmark is reported as a regression")
+@click.argument('baseline', type=click.Path(exists=True))
+@click.argument('candidate', type=click.Path(exists=True))
+
+def cli(threshold, baseline, candidate):
+    baseline_label, baseline_results = load_results(baseline)
+    candidate_label, candidate_results = load_results(candidate)
+
+    print(f"{'benchmark':32}{'parameters':56}{baseline_label or 'baseline':>14}{candidate_label or 'candidate':>14}{'change %':>10}")
+    regressions = 0
+    for key, result in candidate_results.items():
+        if key not in baseline_results:
+            continue
+        before = baseline_results[key]["ns_per_op_median"]
+        after = result["ns_per_op_median"]
+        change = 100. * (after - before) / before if before > 0 else 0.
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -threshold:
+            flag = "  improvement"
+        print(f"{key[0]:32}{key[1]:56}{before:14.1f}{after:14.1f}{change:10.1f}{flag}")
+
+    sys.exit(1 if regressions > 0 else 0)
+
+if __name__ == '__main__':
+    cli()
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+# Compares the end-of-run reports of the dataflow modules from two runs, typically
+# with two software versions on the same configuration, and reports the change of
+# every figure that both runs contain. Each argument is either a report file or a
+# directory, of which the reports of the given run (or of all runs) are used; the
+# reports are matched by module name.
+
+import glob
+import json
+import os
+import sys
+
+import click
+
+# Add -h as default help option
+CONTEXT_SETTINGS = dict(help_option_names=['-h', '--help'])
+
+# Whether a higher value of a figure is worse, for the figures that can regress
+HIGHER_IS_WORSE = {
+    "latencies_us": True,
+    "peaks": True,
+    "states": True,
+    "peak_rss_kb": True,
+}
+
+def load_reports(path, run):
+    if os.path.isdir(path):
+        pattern = f"runreport_*_run{run:06d}.json" if run is not None else "runreport_*.json"
+        file_names = sorted(glob.glob(os.path.join(path, pattern)))
+    else:
+        file_names = [path]
+    reports = {}
+    for file_name in file_names:
+        with open(file_name) as f:
+            report = json.load(f)
+        reports[report["module"]] = report
+    return reports
+
+def flatten(report):
+    figures = {}
+    figures[("peak_rss_kb", "")] = report.get("peak_rss_kb", 0)
+    for name, counter in report.get("counters", {}).items():
+        figures[("counters", f"{name}.total")] = counter["total"]
+        figures[("counters", f"{name}.rate_hz")] = counter["rate_hz"]
+    for name, latency in report.get("latencies_us", {}).items():
+        for quantity in ("mean", "p50", "p90", "p99", "max"):
+            figures[("latencies_us", f"{name}.{quantity}")] = latency[quantity]
+    for name, peak in report.get("peaks", {}).items():
+        figures[("peaks", name)] = peak
+    for name, state in report.get("states", {}).items():
+        figures[("states", f"{name}.fraction")] = state["fraction"]
+    for name, value in report.get("values", {}).items():
+        figures[("values", name)] = value
+    return figures
+
+def is_regression(section, name, change, threshold):
+    if section in HIGHER_IS_WORSE:
+        return change > threshold
+    if section == "counters" and name.endswith(".rate_hz"):
+        return change < -threshold
+    return False
+
+@click.command(context_settings=CONTEXT_SETTINGS)
+@click.option('-t', '--threshold', default=10.0, help="Change of a figure, in percent, beyond which it is reported as a regression: higher latencies, peaks, busy fractions and memory, or lower rates")
+@click.option('-r', '--run', type=int, default=None, help="Run number of the reports to use in the directories, if they contain several runs")
+@click.option('-a', '--all-figures', is_flag=True, help="Print all the figures, not only those that changed by more than the threshold")
+@click.argument('baseline', type=click.Path(exists=True))
+@click.argument('candidate', type=click.Path(exists=True))
+
+def cli(threshold, run, all_figures, baseline, candidate):
+    baseline_reports = load_reports(baseline, run)
+    candidate_reports = load_reports(candidate, run)
+
+    print(f"{'module':24}{'figure':56}{'baseline':>14}{'candidate':>14}{'change %':>10}")
+    regressions = 0
+    for module, report in sorted(candidate_reports.items()):
+        if module not in baseline_reports:
+            print(f"{module:24}only in the candidate reports")
+            continue
+        before_figures = flatten(baseline_reports[module])
+        for key, after in flatten(report).items():
+            if key not in before_figures:
+                continue
+            section, name = key
+            before = before_figures[key]
+            change = 100. * (after - before) / before if before != 0 else 0.
+            flag = ""
+            if is_regression(section, name, change, threshold):
+                flag = "  REGRESSION"
+                regressions += 1
+            elif not all_figures and abs(change) <= threshold:
+                continue
+            figure = f"{section}.{name}" if name else section
+            print(f"{module:24}{figure:56}{before:14.6g}{after:14.6g}{change:10.1f}{flag}")
+
+    for module in sorted(set(baseline_reports) - set(candidate_reports)):
+        print(f"{module:24}only in the baseline reports")
+
+    sys.exit(1 if regressions > 0 else 0)
+
+if __name__ == '__main__':
+    cli()
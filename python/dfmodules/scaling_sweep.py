@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+
+# Helpers for dataflow scaling studies on a single host.
+#
+# A sweep is a set of configuration parameters of fddaqconf_gen, each given as a dotted
+# path into the configuration dictionary with a list of values, e.g.
+#     dataflow.token_count=10,40
+#     dataflow.apps.*.max_trigger_record_window=0,1000000
+#     hsi.random_trigger_rate_hz=1,10
+# A "*" path element applies the value to every element of a list, e.g. to every
+# dataflow app.  The matrix of configurations is the product of the swept values and of
+# the numbers of dataflow apps (TRB + DataWriter) to run.  It is used by
+# integtest/dataflow_scaling_test.py, which runs every configuration with nanorc,
+# validates its output like run_check.py does and appends the opmon totals of the run
+# to a results file, from which the "table" command prints a single table.
+#
+# The "matrix" command writes the configuration dictionaries of a sweep as JSON files,
+# for running them outside of the integtest framework with "fddaqconf_gen -c".
+
+import copy
+import glob
+import itertools
+import json
+import os
+import re
+
+# Opmon quantities that are summed over the apps and the reports of a run, and how the
+# reports of one app are combined: "sum" for the quantities that are reset at every
+# report, and "max" for the run totals that are reported as they grow
+DEFAULT_METRICS = {
+    "decisions_sent": "sum",
+    "tokens_received": "sum",
+    "received_trigger_decisions": "sum",
+    "generated_trigger_records": "sum",
+    "timed_out_trigger_records": "max",
+    "abandoned_trigger_records": "max",
+    "lost_fragments": "max",
+    "new_records_written": "sum",
+    "new_bytes_output": "sum",
+}
+
+def parse_value(text):
+    try:
+        return json.loads(text)
+    except ValueError:
+        return text
+
+def parse_sweep(specs):
+    """Parse "path=value1,value2,..." specifications into an ordered dictionary of value lists"""
+    sweep = {}
+    for spec in specs:
+        path, sep, values = spec.partition("=")
+        if not sep or not path or not values:
+            raise ValueError(f"Invalid sweep specification \"{spec}\", expected path=value1,value2,...")
+        sweep[path.strip()] = [parse_value(v.strip()) for v in values.split(",")]
+    return sweep
+
+def set_conf_value(conf, path, value):
+    """Set the element at a dotted path of a configuration dictionary, "*" matching all list elements"""
+    keys = path.split(".")
+    targets = [conf]
+    for key in keys[:-1]:
+        next_targets = []
+        for target in targets:
+            if key == "*":
+                next_targets.extend(target)
+            elif isinstance(target, list):
+                next_targets.append(target[int(key)])
+            else:
+                next_targets.append(target.setdefault(key, {}))
+        targets = next_targets
+    for target in targets:
+        if keys[-1] == "*":
+            for idx in range(len(target)):
+                target[idx] = copy.deepcopy(value)
+        elif isinstance(target, list):
+            target[int(keys[-1])] = copy.deepcopy(value)
+        else:
+            target[keys[-1]] = copy.deepcopy(value)
+
+def set_dataflow_apps(conf, number_of_dataflow_apps):
+    """Replace the dataflow apps of a configuration by copies of its first one"""
+    template = conf["dataflow"]["apps"][0] if conf["dataflow"]["apps"] else {}
+    conf["dataflow"]["apps"] = []
+    for df_app in range(number_of_dataflow_apps):
+        dfapp_conf = copy.deepcopy(template)
+        dfapp_conf["app_name"] = f"dataflow{df_app}"
+        conf["dataflow"]["apps"].append(dfapp_conf)
+
+def configuration_name(number_of_dataflow_apps, values):
+    name = f"df{number_of_dataflow_apps}"
+    for path, value in values.items():
+        name += f"_{path.split('.')[-1]}={value}"
+    return name
+
+def generate_matrix(base_conf, sweep, dataflow_app_counts=(1,)):
+    """
+    Return the configurations of a sweep, by name, with their swept values.
+    The dataflow apps are set before the swept values, so that "*" paths reach all of them
+    """
+    matrix = {}
+    paths = list(sweep.keys())
+    for number_of_dataflow_apps in dataflow_app_counts:
+        for combination in itertools.product(*[sweep[path] for path in paths]):
+            values = dict(zip(paths, combination))
+            conf = copy.deepcopy(base_conf)
+            set_dataflow_apps(conf, number_of_dataflow_apps)
+            for path, value in values.items():
+                set_conf_value(conf, path, value)
+            parameters = {"dataflow_apps": number_of_dataflow_apps}
+            parameters.update(values)
+            matrix[configuration_name(number_of_dataflow_apps, values)] = (conf, parameters)
+    return matrix
+
+def find_metrics(document, metrics, found):
+    """Collect the numeric values of the given quantities anywhere in an opmon document"""
+    if isinstance(document, dict):
+        for key, value in document.items():
+            if key in metrics and isinstance(value, (int, float)) and not isinstance(value, bool):
+                found.setdefault(key, []).append(value)
+            else:
+                find_metrics(value, metrics, found)
+    elif isinstance(document, list):
+        for value in document:
+            find_metrics(value, metrics, found)
+
+def collect_opmon(run_dir, metrics=DEFAULT_METRICS):
+    """
+    Sum the opmon quantities of a run over the apps, from the info_<app>_<port>.json
+    files that the apps write in the run directory, one JSON report per line
+    """
+    totals = {name: 0 for name in metrics}
+    for file_name in sorted(glob.glob(os.path.join(run_dir, "info_*.json"))):
+        found = {}
+        with open(file_name) as f:
+            for line in f:
+                line = line.strip()
+                if not line:
+                    continue
+                try:
+                    find_metrics(json.loads(line), metrics, found)
+                except ValueError:
+                    continue
+        for name, values in found.items():
+            totals[name] += sum(values) if metrics[name] == "sum" else max(values)
+    return totals
+
+def append_result(results_file, name, parameters, metrics):
+    with open(results_file, "a") as f:
+        f.write(json.dumps({"configuration": name, "parameters": parameters, "metrics": metrics}) + "\n")
+
+def format_table(results):
+    parameter_names = []
+    metric_names = []
+    for result in results:
+        parameter_names += [p for p in result["parameters"] if p not in parameter_names]
+        metric_names += [m for m in result["metrics"] if m not in metric_names]
+    columns = parameter_names + metric_names
+    rows = [[str(result["parameters"].get(p, "")) for p in parameter_names] +
+            [f"{result['metrics'][m]:.6g}" if m in result["metrics"] else "" for m in metric_names]
+            for result in results]
+    widths = [max([len(column.split(".")[-1])] + [len(row[idx]) for row in rows]) for idx, column in enumerate(columns)]
+    lines = ["  ".join(column.split(".")[-1].rjust(widths[idx]) for idx, column in enumerate(columns))]
+    lines += ["  ".join(value.rjust(widths[idx]) for idx, value in enumerate(row)) for row in rows]
+    return "\n".join(lines)
+
+if __name__ == '__main__':
+    import click
+
+    # Add -h as default help option
+    CONTEXT_SETTINGS = dict(help_option_names=['-h', '--help'])
+
+    @click.group(context_settings=CONTEXT_SETTINGS)
+    def cli():
+        pass
+
+    @cli.command()
+    @click.option('-s', '--sweep', multiple=True, help="Swept parameter, as path=value1,value2,...; can be repeated")
+    @click.option('-m', '--dataflow-apps', default="1", help="Comma-separated numbers of dataflow apps")
+    @click.argument('base_config', type=click.Path(exists=True))
+    @click.argument('output_dir', type=click.Path())
+    def matrix(sweep, dataflow_apps, base_config, output_dir):
+        """Write the configuration dictionaries of a sweep of BASE_CONFIG to OUTPUT_DIR"""
+        with open(base_config) as f:
+            base_conf = json.load(f)
+        os.makedirs(output_dir, exist_ok=True)
+        app_counts = [int(count) for count in dataflow_apps.split(",")]
+        for name, (conf, parameters) in generate_matrix(base_conf, parse_sweep(sweep), app_counts).items():
+            file_name = os.path.join(output_dir, re.sub(r"[^\w.=-]", "_", name) + ".json")
+            with open(file_name, "w") as f:
+                json.dump(conf, f, indent=4)
+            print(f"{file_name}: {parameters}")
+
+    @cli.command()
+    @click.option('--csv', 'csv_file', type=click.Path(), default=None, help="Also write the table as CSV to this file")
+    @click.argument('results_file', type=click.Path(exists=True))
+    def table(csv_file, results_file):
+        """Print the results of the configurations of a sweep as a single table"""
+        with open(results_file) as f:
+            results = [json.loads(line) for line in f if line.strip()]
+        print(format_table(results))
+        if csv_file:
+            import csv
+            with open(csv_file, "w", newline="") as f:
+                writer = csv.writer(f)
+                parameter_names = list(dict.fromkeys(p for r in results for p in r["parameters"]))
+                metric_names = list(dict.fromkeys(m for r in results for m in r["metrics"]))
+                writer.writerow(["configuration"] + parameter_names + metric_names)
+                for r in results:
+                    writer.writerow([r["configuration"]] + [r["parameters"].get(p, "") for p in parameter_names] +
+                                    [r["metrics"].get(m, "") for m in metric_names])
+
+    cli()
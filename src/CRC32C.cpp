@@ -0,0 +1,152 @@
+/**
+ * @file CRC32C.cpp CRC32C checksum implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/CRC32C.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+// Reflected CRC32C polynomial
+constexpr uint32_t s_polynomial = 0x82f63b78;
+
+// Tables of the slicing-by-8 software implementation: s_tables[k][b] is the CRC of
+// byte b followed by k zero bytes
+using table_t = std::array<std::array<uint32_t, 256>, 8>;
+
+table_t
+make_tables()
+{
+  table_t tables;
+  for (uint32_t b = 0; b < 256; ++b) {
+    uint32_t crc = b;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) ? s_polynomial : 0);
+    }
+    tables[0][b] = crc;
+  }
+  for (uint32_t b = 0; b < 256; ++b) {
+    for (size_t k = 1; k < tables.size(); ++k) {
+      tables[k][b] = (tables[k - 1][b] >> 8) ^ tables[0][tables[k - 1][b] & 0xff];
+    }
+  }
+  return tables;
+}
+
+const table_t s_tables = make_tables();
+
+uint32_t
+update_software(uint32_t crc, const uint8_t* data, size_t size)
+{
+  while (size >= 8) {
+    uint32_t low;
+    uint32_t high;
+    memcpy(&low, data, 4);
+    memcpy(&high, data + 4, 4);
+    low ^= crc;
+    crc = s_tables[7][low & 0xff] ^ s_tables[6][(low >> 8) & 0xff] ^ s_tables[5][(low >> 16) & 0xff] ^
+          s_tables[4][low >> 24] ^ s_tables[3][high & 0xff] ^ s_tables[2][(high >> 8) & 0xff] ^
+          s_tables[1][(high >> 16) & 0xff] ^ s_tables[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ s_tables[0][(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2"))) uint32_t
+update_hardware(uint32_t crc, const uint8_t* data, size_t size)
+{
+  uint64_t crc64 = crc;
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+  while (size-- > 0) {
+    crc = _mm_crc32_u8(crc, *data++);
+  }
+  return crc;
+}
+
+const bool s_hardware_support = __builtin_cpu_supports("sse4.2");
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+uint32_t
+update_hardware(uint32_t crc, const uint8_t* data, size_t size)
+{
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+    crc = __crc32cd(crc, word);
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = __crc32cb(crc, *data++);
+  }
+  return crc;
+}
+
+const bool s_hardware_support = true;
+
+#else
+
+uint32_t
+update_hardware(uint32_t crc, const uint8_t* data, size_t size)
+{
+  return update_software(crc, data, size);
+}
+
+const bool s_hardware_support = false;
+
+#endif
+
+} // namespace
+
+uint32_t
+CRC32C::compute(const void* data, size_t size, uint32_t previous_crc)
+{
+  if (!s_hardware_support) {
+    return compute_software(data, size, previous_crc);
+  }
+  return ~update_hardware(~previous_crc, static_cast<const uint8_t*>(data), size);
+}
+
+uint32_t
+CRC32C::compute_software(const void* data, size_t size, uint32_t previous_crc)
+{
+  return ~update_software(~previous_crc, static_cast<const uint8_t*>(data), size);
+}
+
+bool
+CRC32C::has_hardware_support()
+{
+  return s_hardware_support;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
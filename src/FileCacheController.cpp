@@ -0,0 +1,157 @@
+/**
+ * @file FileCacheController.cpp FileCacheController class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FileCacheController.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+/**
+ * @brief Name used by TRACE TLOG calls from this source file
+ */
+#define TRACE_NAME "FileCacheController" // NOLINT
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+constexpr int s_tlvl_file_cache = 5;
+} // namespace
+
+FileCacheController::FileCacheController(const filecache::FileCacheControl& conf)
+  : m_preallocate(conf.preallocate)
+  , m_preallocation_size(conf.preallocation_size_bytes)
+  , m_write_behind_bytes(conf.write_behind_bytes)
+  , m_drop_cache(conf.drop_cache)
+{}
+
+FileCacheController::~FileCacheController()
+{
+  close();
+}
+
+void
+FileCacheController::open(const std::string& file_name, size_t expected_size)
+{
+  close();
+  if (is_disabled()) {
+    return;
+  }
+
+  m_file_name = file_name;
+  m_preallocated_bytes = 0;
+  m_write_behind_failed = false;
+  m_write_started_offset = 0;
+  m_written_back_offset = 0;
+
+  m_fd = ::open(file_name.c_str(), O_WRONLY | O_CLOEXEC);
+  if (m_fd < 0) {
+    report_problem("open the file", errno);
+    return;
+  }
+
+  size_t reservation = m_preallocation_size > 0 ? m_preallocation_size : expected_size;
+  if (m_preallocate && reservation > 0) {
+    // FALLOC_FL_KEEP_SIZE leaves the file size unchanged, which the writing library relies on
+    if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, reservation) == 0) {
+      m_preallocated_bytes = reservation;
+      TLOG_DEBUG(s_tlvl_file_cache) << "Reserved " << reservation << " bytes for file " << file_name;
+    } else {
+      report_problem("reserve " + std::to_string(reservation) + " bytes", errno);
+    }
+  }
+}
+
+void
+FileCacheController::update()
+{
+  if (m_fd < 0 || m_write_behind_bytes == 0 || m_write_behind_failed) {
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(m_fd, &file_stat) != 0) {
+    m_write_behind_failed = true;
+    report_problem("get the size", errno);
+    return;
+  }
+  size_t file_size = file_stat.st_size;
+
+  while (file_size >= m_write_started_offset + m_write_behind_bytes) {
+    // start the writeback of the window that has just been completed...
+    if (sync_file_range(m_fd, m_write_started_offset, m_write_behind_bytes, SYNC_FILE_RANGE_WRITE) != 0) {
+      m_write_behind_failed = true;
+      report_problem("start the writeback", errno);
+      return;
+    }
+    m_write_started_offset += m_write_behind_bytes;
+
+    // ...and wait for the one before it, which has most likely been written back in the meantime
+    if (m_write_started_offset >= m_written_back_offset + 2 * m_write_behind_bytes) {
+      unsigned flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+      if (sync_file_range(m_fd, m_written_back_offset, m_write_behind_bytes, flags) != 0) {
+        m_write_behind_failed = true;
+        report_problem("wait for the writeback", errno);
+        return;
+      }
+      if (m_drop_cache) {
+        posix_fadvise(m_fd, m_written_back_offset, m_write_behind_bytes, POSIX_FADV_DONTNEED);
+      }
+      m_written_back_offset += m_write_behind_bytes;
+    }
+  }
+}
+
+void
+FileCacheController::close()
+{
+  if (m_fd < 0) {
+    return;
+  }
+
+  struct stat file_stat;
+  int stat_errno = (fstat(m_fd, &file_stat) == 0) ? 0 : errno;
+
+  if (m_drop_cache) {
+    // sync_file_range with a zero length covers the whole file
+    unsigned flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER;
+    if (sync_file_range(m_fd, 0, 0, flags) != 0) {
+      report_problem("write back the file", errno);
+    } else {
+      posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+  }
+
+  // truncating a file to its own size releases the blocks reserved beyond its end
+  if (m_preallocated_bytes > 0) {
+    if (stat_errno != 0) {
+      report_problem("release the reserved space", stat_errno);
+    } else if (ftruncate(m_fd, file_stat.st_size) != 0) {
+      report_problem("release the reserved space", errno);
+    }
+  }
+
+  ::close(m_fd);
+  m_fd = -1;
+}
+
+void
+FileCacheController::report_problem(const std::string& operation, int error_number)
+{
+  ers::warning(FileCacheControlProblem(ERS_HERE, m_file_name, operation, std::strerror(error_number)));
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,235 @@
+/**
+ * @file FlightRecorder.cpp FlightRecorder class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FlightRecorder.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+/**
+ * @brief Name used by TRACE TLOG calls from this source file
+ */
+#define TRACE_NAME "FlightRecorder" // NOLINT
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+std::string
+json_escape(const std::string& text)
+{
+  std::ostringstream oss;
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        oss << "\\\"";
+        break;
+      case '\\':
+        oss << "\\\\";
+        break;
+      case '\n':
+        oss << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+          oss << c;
+        }
+    }
+  }
+  return oss.str();
+}
+
+} // namespace
+
+FlightRecorder::FlightRecorder(std::string owner_name)
+  : m_owner_name(std::move(owner_name))
+  , m_thread(std::bind(&FlightRecorder::do_work, this, std::placeholders::_1))
+{}
+
+FlightRecorder::~FlightRecorder()
+{
+  stop();
+}
+
+void
+FlightRecorder::configure(const flightrecorder::FlightRecorder& conf)
+{
+  m_enabled = conf.enabled;
+  m_sample_interval = std::chrono::milliseconds(std::max<uint32_t>(conf.sample_interval_ms, 1)); // NOLINT
+  m_post_anomaly = std::chrono::milliseconds(conf.post_anomaly_ms);
+  m_min_dump_interval = std::chrono::milliseconds(conf.min_dump_interval_ms);
+  m_capacity = std::max<size_t>(conf.history_ms / m_sample_interval.count(), 1);
+  m_output_path = conf.output_path;
+}
+
+void
+FlightRecorder::add_gauge(const std::string& name, gauge_t gauge)
+{
+  m_gauge_names.push_back(name);
+  m_gauges.push_back(std::move(gauge));
+}
+
+void
+FlightRecorder::start(daqdataformats::run_number_t run_number)
+{
+  m_run_number = run_number;
+  m_dump_requested.store(false);
+  m_dump_due_time.store(0);
+  m_next_dump_allowed.store(0);
+  m_anomaly_count.store(0);
+  m_dump_count.store(0);
+
+  if (!m_enabled) {
+    return;
+  }
+
+  m_row_size = 1 + m_gauges.size();
+  m_history.assign(m_capacity * m_row_size, 0);
+  m_samples_taken = 0;
+  m_start_time = clock_type::now();
+  m_thread.start_working_thread(m_owner_name.substr(0, 8) + "-fr");
+}
+
+void
+FlightRecorder::stop()
+{
+  if (m_thread.thread_running()) {
+    m_thread.stop_working_thread();
+  }
+}
+
+void
+FlightRecorder::request_dump(const char* reason)
+{
+  if (!m_enabled) {
+    return;
+  }
+  m_anomaly_count.fetch_add(1, std::memory_order_relaxed);
+
+  auto now = clock_type::now().time_since_epoch().count();
+  if (now < m_next_dump_allowed.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // The first anomaly after a dump claims the next one; the others are only counted
+  bool expected = false;
+  if (!m_dump_requested.compare_exchange_strong(expected, true)) {
+    return;
+  }
+  // published before the due time, which the sampling thread reads first
+  m_dump_reason.store(reason);
+  m_dump_due_time.store(now + std::chrono::duration_cast<clock_type::duration>(m_post_anomaly).count());
+}
+
+void
+FlightRecorder::do_work(std::atomic<bool>& running_flag)
+{
+  auto next_sample = clock_type::now();
+  while (running_flag.load()) {
+    auto now = clock_type::now();
+    take_sample(now);
+
+    auto due_time = m_dump_due_time.load();
+    if (due_time != 0 && now.time_since_epoch().count() >= due_time) {
+      dump(m_dump_reason.load());
+    }
+
+    next_sample += m_sample_interval;
+    if (next_sample < now) {
+      // samples that were missed are not made up for
+      next_sample = now + m_sample_interval;
+    }
+    std::this_thread::sleep_until(next_sample);
+  }
+
+  // an anomaly shortly before the stop is dumped without waiting for post_anomaly_ms
+  if (m_dump_due_time.load() != 0) {
+    take_sample(clock_type::now());
+    dump(m_dump_reason.load());
+  }
+}
+
+void
+FlightRecorder::take_sample(clock_type::time_point now)
+{
+  auto* row = &m_history[(m_samples_taken % m_capacity) * m_row_size];
+  row[0] = std::chrono::duration_cast<std::chrono::microseconds>(now - m_start_time).count();
+  for (size_t i = 0; i < m_gauges.size(); ++i) {
+    row[i + 1] = m_gauges[i]();
+  }
+  ++m_samples_taken;
+}
+
+void
+FlightRecorder::dump(const std::string& reason)
+{
+  auto dump_index = m_dump_count.fetch_add(1) + 1;
+
+  std::time_t wall_time = std::time(nullptr);
+  std::tm tm_buf;
+  gmtime_r(&wall_time, &tm_buf);
+  std::ostringstream name_oss;
+  name_oss << "flightrecorder_" << m_owner_name << "_run" << std::setw(6) << std::setfill('0') << m_run_number << "_"
+           << std::put_time(&tm_buf, "%Y%m%dT%H%M%S") << "_" << dump_index << ".json";
+  auto file_path = std::filesystem::path(m_output_path) / name_oss.str();
+  auto temp_path = file_path;
+  temp_path += ".writing";
+
+  size_t sample_count = std::min<uint64_t>(m_samples_taken, m_capacity);
+  uint64_t first_sample = m_samples_taken - sample_count; // NOLINT(build/unsigned)
+
+  {
+    std::ofstream ofs(temp_path);
+    ofs << "{\n  \"module\": \"" << json_escape(m_owner_name) << "\",\n  \"run_number\": " << m_run_number
+        << ",\n  \"reason\": \"" << json_escape(reason) << "\",\n  \"anomalies\": " << m_anomaly_count.load()
+        << ",\n  \"sample_interval_ms\": " << m_sample_interval.count() << ",\n  \"columns\": [\"time_us\"";
+    for (const auto& name : m_gauge_names) {
+      ofs << ", \"" << json_escape(name) << "\"";
+    }
+    ofs << "],\n  \"samples\": [";
+    for (size_t i = 0; i < sample_count; ++i) {
+      const auto* row = &m_history[((first_sample + i) % m_capacity) * m_row_size];
+      ofs << (i == 0 ? "\n    [" : ",\n    [");
+      for (size_t j = 0; j < m_row_size; ++j) {
+        ofs << (j == 0 ? "" : ", ") << row[j];
+      }
+      ofs << "]";
+    }
+    ofs << "\n  ]\n}\n";
+    ofs.close();
+
+    std::error_code ec;
+    if (ofs.fail()) {
+      ers::warning(FlightRecorderDumpFailed(ERS_HERE, m_owner_name, file_path.string(), "the file could not be written"));
+    } else if (std::filesystem::rename(temp_path, file_path, ec); ec) {
+      ers::warning(FlightRecorderDumpFailed(ERS_HERE, m_owner_name, file_path.string(), ec.message()));
+    } else {
+      TLOG() << FlightRecorderDumped(ERS_HERE, m_owner_name, sample_count, file_path.string(), reason);
+    }
+  }
+
+  auto now = clock_type::now().time_since_epoch().count();
+  m_next_dump_allowed.store(now + std::chrono::duration_cast<clock_type::duration>(m_min_dump_interval).count());
+  m_dump_due_time.store(0);
+  m_dump_requested.store(false);
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,120 @@
+/**
+ * @file FragmentChecksums.cpp FragmentChecksums class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FragmentChecksums.hpp"
+
+#include "dfmodules/CRC32C.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+FragmentChecksums::FragmentChecksums(size_t thread_count)
+  : m_pool(thread_count, "checksums")
+{}
+
+void
+FragmentChecksums::start(const fragments_t& fragments)
+{
+  m_checksums.resize(fragments.size());
+  m_futures.clear();
+
+  // one task per thread, each with a consecutive range of Fragments
+  size_t task_count = std::min(m_pool.get_thread_count(), fragments.size());
+  for (size_t task = 0; task < task_count; ++task) {
+    size_t begin = fragments.size() * task / task_count;
+    size_t end = fragments.size() * (task + 1) / task_count;
+    m_futures.push_back(m_pool.submit([this, &fragments, begin, end]() {
+      for (size_t i = begin; i < end; ++i) {
+        const auto& fragment = fragments[i];
+        auto source_id = fragment->get_element_id();
+        m_checksums[i].subsystem = static_cast<uint32_t>(source_id.subsystem); // NOLINT(build/unsigned)
+        m_checksums[i].source_id = source_id.id;
+        m_checksums[i].crc32c = CRC32C::compute(fragment->get_storage_location(), fragment->get_size());
+      }
+    }));
+  }
+}
+
+std::vector<FragmentChecksum>
+FragmentChecksums::finish()
+{
+  for (auto& future : m_futures) {
+    future.get();
+  }
+  m_futures.clear();
+  return std::move(m_checksums);
+}
+
+hid_t
+FragmentChecksums::create_h5_type()
+{
+  hid_t type_id = H5Tcreate(H5T_COMPOUND, sizeof(FragmentChecksum));
+  H5Tinsert(type_id, "subsystem", HOFFSET(FragmentChecksum, subsystem), H5T_NATIVE_UINT32);
+  H5Tinsert(type_id, "source_id", HOFFSET(FragmentChecksum, source_id), H5T_NATIVE_UINT32);
+  H5Tinsert(type_id, "crc32c", HOFFSET(FragmentChecksum, crc32c), H5T_NATIVE_UINT32);
+  return type_id;
+}
+
+std::string
+FragmentChecksums::write_attribute(hid_t object_id, const std::vector<FragmentChecksum>& checksums)
+{
+  std::string error;
+  hsize_t dims[1] = { checksums.size() };
+  hid_t space_id = H5Screate_simple(1, dims, nullptr);
+  hid_t type_id = create_h5_type();
+  hid_t attr_id = H5I_INVALID_HID;
+  H5E_BEGIN_TRY
+  {
+    attr_id = H5Acreate2(object_id, s_attribute_name, type_id, space_id, H5P_DEFAULT, H5P_DEFAULT);
+  }
+  H5E_END_TRY;
+  if (attr_id < 0) {
+    // attributes are limited to 64 kB unless the file uses the latest file format
+    error = "unable to create the attribute for " + std::to_string(checksums.size()) + " checksums";
+  } else {
+    if (H5Awrite(attr_id, type_id, checksums.data()) < 0) {
+      error = "unable to write the attribute";
+    }
+    H5Aclose(attr_id);
+  }
+  H5Tclose(type_id);
+  H5Sclose(space_id);
+  return error;
+}
+
+bool
+FragmentChecksums::read_attribute(hid_t object_id, std::vector<FragmentChecksum>& checksums)
+{
+  if (H5Aexists(object_id, s_attribute_name) <= 0) {
+    return false;
+  }
+  hid_t attr_id = H5Aopen(object_id, s_attribute_name, H5P_DEFAULT);
+  if (attr_id < 0) {
+    return false;
+  }
+  hid_t space_id = H5Aget_space(attr_id);
+  hssize_t count = H5Sget_simple_extent_npoints(space_id);
+  hid_t type_id = create_h5_type();
+  bool success = false;
+  if (count >= 0) {
+    checksums.resize(count);
+    success = H5Aread(attr_id, type_id, checksums.data()) >= 0;
+  }
+  H5Tclose(type_id);
+  H5Sclose(space_id);
+  H5Aclose(attr_id);
+  return success;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
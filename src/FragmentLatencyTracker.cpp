@@ -0,0 +1,144 @@
+/**
+ * @file FragmentLatencyTracker.cpp FragmentLatencyTracker class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FragmentLatencyTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dunedaq {
+namespace dfmodules {
+
+void
+FragmentLatencyTracker::configure(const adaptivetimeout::AdaptiveTimeout& conf, std::chrono::milliseconds max_timeout)
+{
+  m_sources.clear();
+  m_enabled = conf.enabled;
+  if (!m_enabled) {
+    return;
+  }
+
+  if (max_timeout.count() == 0) {
+    throw InvalidAdaptiveTimeout(ERS_HERE, "trigger_record_timeout_ms, the upper bound of the timeouts, is not set");
+  }
+  if (!(conf.quantile > 0 && conf.quantile <= 1)) {
+    throw InvalidAdaptiveTimeout(ERS_HERE, "quantile must be in (0, 1]");
+  }
+  if (!(conf.safety_factor >= 1)) {
+    throw InvalidAdaptiveTimeout(ERS_HERE, "safety_factor must be at least 1");
+  }
+  if (conf.min_timeout_ms > max_timeout.count()) {
+    throw InvalidAdaptiveTimeout(ERS_HERE, "min_timeout_ms is larger than trigger_record_timeout_ms");
+  }
+  if (conf.history_samples > 0 && conf.history_samples < conf.min_samples) {
+    throw InvalidAdaptiveTimeout(ERS_HERE, "history_samples is smaller than min_samples");
+  }
+
+  m_quantile = conf.quantile;
+  m_safety_factor = conf.safety_factor;
+  m_min_samples = std::max<uint32_t>(conf.min_samples, 1); // NOLINT(build/unsigned)
+  m_history_samples = conf.history_samples;
+  m_min_timeout = std::chrono::milliseconds(conf.min_timeout_ms);
+  m_max_timeout = max_timeout;
+}
+
+size_t
+FragmentLatencyTracker::bin_of(duration_type latency)
+{
+  auto us = latency.count();
+  if (us < 1) {
+    return 0;
+  }
+  // the octave is the position of the most significant bit, the bin within it comes from the next two bits
+  size_t octave = 63 - __builtin_clzll(static_cast<unsigned long long>(us)); // NOLINT
+  size_t sub_bin = (octave >= 2 ? (us >> (octave - 2)) : (us << (2 - octave))) & (s_bins_per_octave - 1);
+  return std::min(1 + octave * s_bins_per_octave + sub_bin, s_bin_count - 1);
+}
+
+FragmentLatencyTracker::duration_type
+FragmentLatencyTracker::upper_edge_of(size_t bin)
+{
+  if (bin == 0) {
+    return duration_type(1);
+  }
+  int octave = static_cast<int>((bin - 1) / s_bins_per_octave);
+  int sub_bin = static_cast<int>((bin - 1) % s_bins_per_octave);
+  auto edge = std::ldexp(static_cast<double>(s_bins_per_octave + sub_bin + 1), octave - 2);
+  return duration_type(static_cast<duration_type::rep>(std::ceil(edge)));
+}
+
+void
+FragmentLatencyTracker::add_sample(const daqdataformats::SourceID& source_id, duration_type latency)
+{
+  auto& histogram = m_sources[source_id];
+
+  if (m_history_samples > 0 && histogram.samples_since_decay >= m_history_samples) {
+    for (auto& weight : histogram.weights) {
+      weight *= 0.5;
+    }
+    histogram.total_weight *= 0.5;
+    histogram.samples_since_decay = 0;
+  }
+
+  histogram.weights[bin_of(latency)] += 1;
+  histogram.total_weight += 1;
+  ++histogram.samples;
+  ++histogram.samples_since_decay;
+
+  if (histogram.samples < m_min_samples) {
+    return;
+  }
+  if (!histogram.quantile || ++histogram.samples_since_refresh >= s_refresh_interval) {
+    refresh_quantile(histogram);
+  }
+}
+
+void
+FragmentLatencyTracker::refresh_quantile(Histogram& histogram) const
+{
+  double target = m_quantile * histogram.total_weight;
+  double cumulative = 0;
+  size_t bin = 0;
+  for (; bin < s_bin_count - 1; ++bin) {
+    cumulative += histogram.weights[bin];
+    if (cumulative >= target) {
+      break;
+    }
+  }
+  histogram.quantile = upper_edge_of(bin);
+  histogram.samples_since_refresh = 0;
+}
+
+std::optional<FragmentLatencyTracker::duration_type>
+FragmentLatencyTracker::get_latency_quantile(const daqdataformats::SourceID& source_id) const
+{
+  auto it = m_sources.find(source_id);
+  if (it == m_sources.end()) {
+    return std::nullopt;
+  }
+  return it->second.quantile;
+}
+
+FragmentLatencyTracker::duration_type
+FragmentLatencyTracker::get_timeout(const std::vector<daqdataformats::ComponentRequest>& components) const
+{
+  duration_type slowest{ 0 };
+  for (const auto& component : components) {
+    auto quantile = get_latency_quantile(component.component);
+    if (!quantile) {
+      return m_max_timeout;
+    }
+    slowest = std::max(slowest, *quantile);
+  }
+
+  auto timeout = duration_type(static_cast<duration_type::rep>(std::ceil(slowest.count() * m_safety_factor)));
+  return std::clamp<duration_type>(timeout, m_min_timeout, m_max_timeout);
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
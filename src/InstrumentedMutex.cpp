@@ -0,0 +1,141 @@
+/**
+ * @file InstrumentedMutex.cpp LockStats and LockProfiler class implementations
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/InstrumentedMutex.hpp"
+#include "dfmodules/lockprofileinfo/InfoNljs.hpp"
+
+#include <map>
+#include <memory>
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+struct Registry
+{
+  std::mutex mutex;
+  std::map<std::string, std::unique_ptr<LockStats>> stats;
+};
+
+Registry&
+registry()
+{
+  static Registry s_registry;
+  return s_registry;
+}
+
+/**
+ * @brief Reset the histogram and return the upper edge of the bins holding the given quantiles and the maximum
+ */
+void
+take_quantiles(std::array<std::atomic<uint64_t>, LockStats::s_bin_count>& histogram, // NOLINT(build/unsigned)
+               uint64_t& p50,                                                        // NOLINT(build/unsigned)
+               uint64_t& p99,                                                        // NOLINT(build/unsigned)
+               uint64_t& max)                                                        // NOLINT(build/unsigned)
+{
+  std::array<uint64_t, LockStats::s_bin_count> counts; // NOLINT(build/unsigned)
+  uint64_t total = 0;                                   // NOLINT(build/unsigned)
+  for (size_t i = 0; i < counts.size(); ++i) {
+    counts[i] = histogram[i].exchange(0, std::memory_order_relaxed);
+    total += counts[i];
+  }
+  p50 = p99 = max = 0;
+  uint64_t seen = 0; // NOLINT(build/unsigned)
+  for (size_t i = 0; i < counts.size(); ++i) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    uint64_t upper_edge = uint64_t(1) << i; // NOLINT(build/unsigned)
+    seen += counts[i];
+    if (p50 == 0 && 2 * seen >= total) {
+      p50 = upper_edge;
+    }
+    if (p99 == 0 && 100 * seen >= 99 * total) {
+      p99 = upper_edge;
+    }
+    max = upper_edge;
+  }
+}
+
+} // namespace
+
+size_t
+LockStats::bin_of(uint64_t ns) // NOLINT(build/unsigned)
+{
+  // bin i holds the times up to 2^i ns
+  size_t bin = ns <= 1 ? 0 : 64 - __builtin_clzll(ns - 1);
+  return bin < s_bin_count ? bin : s_bin_count - 1;
+}
+
+void
+LockStats::record_acquisition(bool contended, uint64_t wait_ns) // NOLINT(build/unsigned)
+{
+  m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+  if (contended) {
+    m_contended.fetch_add(1, std::memory_order_relaxed);
+    m_wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+  }
+  m_wait_histogram[bin_of(wait_ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+LockStats::record_release(uint64_t hold_ns) // NOLINT(build/unsigned)
+{
+  m_hold_ns.fetch_add(hold_ns, std::memory_order_relaxed);
+  m_hold_histogram[bin_of(hold_ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+LockStats::get_info(opmonlib::InfoCollector& ci)
+{
+  lockprofileinfo::Info info;
+  info.acquisitions = m_acquisitions.exchange(0);
+  info.contended_acquisitions = m_contended.exchange(0);
+  info.wait_time_ns = m_wait_ns.exchange(0);
+  info.hold_time_ns = m_hold_ns.exchange(0);
+  take_quantiles(m_wait_histogram, info.wait_p50_ns, info.wait_p99_ns, info.wait_max_ns);
+  take_quantiles(m_hold_histogram, info.hold_p50_ns, info.hold_p99_ns, info.hold_max_ns);
+  ci.add(info);
+}
+
+LockStats&
+LockProfiler::get_stats(const std::string& owner, const std::string& name)
+{
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lk(reg.mutex);
+  auto& stats = reg.stats[owner + "/" + name];
+  if (!stats) {
+    stats = std::make_unique<LockStats>();
+  }
+  return *stats;
+}
+
+void
+LockProfiler::get_info(opmonlib::InfoCollector& ci, const std::string& owner)
+{
+  // the keys are "<owner>/<name>", and the names have no "/"
+  const std::string prefix = owner + "/";
+  auto& reg = registry();
+  std::lock_guard<std::mutex> lk(reg.mutex);
+  for (auto it = reg.stats.lower_bound(prefix); it != reg.stats.end(); ++it) {
+    if (it->first.compare(0, prefix.size(), prefix) != 0) {
+      break;
+    }
+    if (it->first.find('/', prefix.size()) != std::string::npos) {
+      // a lock of an owner whose name starts with this one followed by "/"
+      continue;
+    }
+    opmonlib::InfoCollector lock_ic;
+    it->second->get_info(lock_ic);
+    ci.add("lock_" + it->first.substr(it->first.find_last_of("./") + 1), lock_ic);
+  }
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
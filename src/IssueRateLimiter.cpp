@@ -0,0 +1,127 @@
+/**
+ * @file IssueRateLimiter.cpp IssueRateLimiter class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/IssueRateLimiter.hpp"
+
+#include "ers/ers.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace dunedaq {
+namespace dfmodules {
+
+IssueRateLimiter::IssueRateLimiter(std::string issue_name,
+                                   size_t max_full_reports,
+                                   std::chrono::milliseconds summary_interval,
+                                   Severity severity)
+  : m_issue_name(std::move(issue_name))
+  , m_severity(severity)
+  , m_max_full_reports(max_full_reports)
+  , m_summary_interval(std::chrono::duration_cast<clock_type::duration>(summary_interval).count())
+  , m_interval_start(clock_type::now().time_since_epoch().count())
+{
+  for (auto& sample : m_samples) {
+    sample.store(0, std::memory_order_relaxed);
+  }
+}
+
+void
+IssueRateLimiter::configure(size_t max_full_reports, std::chrono::milliseconds summary_interval)
+{
+  flush();
+  m_max_full_reports.store(max_full_reports);
+  m_summary_interval.store(std::chrono::duration_cast<clock_type::duration>(summary_interval).count());
+  m_total_count.store(0);
+  m_total_suppressed.store(0);
+}
+
+bool
+IssueRateLimiter::should_report(uint64_t sample_id)
+{
+  m_total_count.fetch_add(1, std::memory_order_relaxed);
+
+  auto max_full_reports = m_max_full_reports.load(std::memory_order_relaxed);
+  if (max_full_reports == 0) {
+    return true;
+  }
+
+  roll_interval(clock_type::now(), false);
+
+  if (m_interval_count.fetch_add(1, std::memory_order_relaxed) < max_full_reports) {
+    return true;
+  }
+
+  auto index = m_interval_suppressed.fetch_add(1, std::memory_order_relaxed);
+  if (index < s_max_samples) {
+    m_samples[index].store(sample_id, std::memory_order_relaxed);
+  }
+  m_total_suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void
+IssueRateLimiter::check_summary()
+{
+  roll_interval(clock_type::now(), false);
+}
+
+void
+IssueRateLimiter::flush()
+{
+  roll_interval(clock_type::now(), true);
+}
+
+void
+IssueRateLimiter::roll_interval(clock_type::time_point now, bool force)
+{
+  auto now_count = now.time_since_epoch().count();
+  auto elapsed = now_count - m_interval_start.load(std::memory_order_relaxed);
+  if (!force && elapsed < m_summary_interval.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // Only one thread closes an interval, the others carry on with the current one
+  std::unique_lock<std::mutex> lk(m_summary_mutex, std::try_to_lock);
+  if (!lk.owns_lock()) {
+    return;
+  }
+  elapsed = now_count - m_interval_start.load(std::memory_order_relaxed);
+  if (!force && elapsed < m_summary_interval.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto suppressed = m_interval_suppressed.exchange(0);
+  std::ostringstream samples;
+  for (size_t i = 0; i < std::min<uint64_t>(suppressed, s_max_samples); ++i) {
+    samples << (i == 0 ? "" : ", ") << m_samples[i].load(std::memory_order_relaxed);
+  }
+  if (suppressed > s_max_samples) {
+    samples << ", ...";
+  }
+  m_interval_count.store(0);
+  m_interval_start.store(now_count);
+  lk.unlock();
+
+  if (suppressed == 0) {
+    return;
+  }
+
+  auto interval_ms = std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::duration(elapsed)).count();
+  SuppressedIssuesSummary summary(ERS_HERE, m_issue_name, suppressed, interval_ms, samples.str());
+  if (m_severity == Severity::kError) {
+    ers::error(summary);
+  } else {
+    ers::warning(summary);
+  }
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
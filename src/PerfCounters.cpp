@@ -0,0 +1,180 @@
+/**
+ * @file PerfCounters.cpp PerfSection and PerfScope class implementations
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/PerfCounters.hpp"
+#include "dfmodules/perfcountersinfo/InfoNljs.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+/**
+ * @brief The counters of a thread, opened as a group so that they are scheduled together
+ */
+class ThreadCounters
+{
+public:
+  static constexpr int s_counter_count = 4;
+
+  ThreadCounters()
+  {
+    const uint64_t configs[s_counter_count] = { // NOLINT(build/unsigned)
+                                                PERF_COUNT_HW_CPU_CYCLES,
+                                                PERF_COUNT_HW_INSTRUCTIONS,
+                                                PERF_COUNT_HW_CACHE_MISSES,
+                                                PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int i = 0; i < s_counter_count; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      m_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : m_fds[0], PERF_FLAG_FD_CLOEXEC);
+      if (m_fds[i] < 0) {
+        m_reason = std::string("perf_event_open: ") + std::strerror(errno);
+        close_all();
+        return;
+      }
+    }
+  }
+
+  ~ThreadCounters() { close_all(); }
+
+  ThreadCounters(const ThreadCounters&) = delete;
+  ThreadCounters& operator=(const ThreadCounters&) = delete;
+
+  bool read(PerfCounterValues& values, std::string& reason)
+  {
+    if (m_fds[0] < 0) {
+      reason = m_reason;
+      return false;
+    }
+    // the number of counters, the enabled and running times, and the values
+    uint64_t buffer[3 + s_counter_count]; // NOLINT(build/unsigned)
+    if (::read(m_fds[0], buffer, sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer))) {
+      reason = std::string("read: ") + std::strerror(errno);
+      return false;
+    }
+    values.time_enabled_ns = buffer[1];
+    values.time_running_ns = buffer[2];
+    values.cycles = buffer[3];
+    values.instructions = buffer[4];
+    values.llc_misses = buffer[5];
+    values.branch_misses = buffer[6];
+    return true;
+  }
+
+private:
+  void close_all()
+  {
+    for (auto& fd : m_fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      fd = -1;
+    }
+  }
+
+  int m_fds[s_counter_count] = { -1, -1, -1, -1 };
+  std::string m_reason;
+};
+
+} // namespace
+
+bool
+PerfSection::read_thread_counters(PerfCounterValues& values, std::string& reason)
+{
+  // opened by each thread the first time it needs them
+  thread_local ThreadCounters counters;
+  return counters.read(values, reason);
+}
+
+void
+PerfSection::add(const PerfCounterValues& start, const PerfCounterValues& end, bool counted)
+{
+  m_invocations.fetch_add(1, std::memory_order_relaxed);
+  auto enabled = end.time_enabled_ns - start.time_enabled_ns;
+  auto running = end.time_running_ns - start.time_running_ns;
+  if (counted && running > 0) {
+    // estimate of the counts of the whole invocation, when the counters were multiplexed
+    double scale = running < enabled ? static_cast<double>(enabled) / running : 1.;
+    auto scaled = [scale](uint64_t count) { return static_cast<uint64_t>(count * scale); }; // NOLINT(build/unsigned)
+    m_counted_invocations.fetch_add(1, std::memory_order_relaxed);
+    m_cycles.fetch_add(scaled(end.cycles - start.cycles), std::memory_order_relaxed);
+    m_instructions.fetch_add(scaled(end.instructions - start.instructions), std::memory_order_relaxed);
+    m_llc_misses.fetch_add(scaled(end.llc_misses - start.llc_misses), std::memory_order_relaxed);
+    m_branch_misses.fetch_add(scaled(end.branch_misses - start.branch_misses), std::memory_order_relaxed);
+    m_time_enabled_ns.fetch_add(enabled, std::memory_order_relaxed);
+    m_time_running_ns.fetch_add(running, std::memory_order_relaxed);
+  }
+}
+
+void
+PerfSection::report_unavailable(const std::string& reason)
+{
+  if (!m_reported.exchange(true)) {
+    ers::warning(PerfCountersUnavailable(ERS_HERE, m_name, reason));
+  }
+}
+
+void
+PerfSection::get_info(opmonlib::InfoCollector& ci)
+{
+  if (!is_enabled()) {
+    return;
+  }
+  perfcountersinfo::Info info;
+  info.invocations = m_invocations.exchange(0);
+  info.counted_invocations = m_counted_invocations.exchange(0);
+  info.cycles = m_cycles.exchange(0);
+  info.instructions = m_instructions.exchange(0);
+  info.llc_misses = m_llc_misses.exchange(0);
+  info.branch_misses = m_branch_misses.exchange(0);
+  info.time_enabled_ns = m_time_enabled_ns.exchange(0);
+  info.time_running_ns = m_time_running_ns.exchange(0);
+
+  opmonlib::InfoCollector section_ic;
+  section_ic.add(info);
+  ci.add("perf_" + m_name, section_ic);
+}
+
+void
+PerfScope::start()
+{
+  std::string reason;
+  m_counted = PerfSection::read_thread_counters(m_start, reason);
+  if (!m_counted) {
+    m_section->report_unavailable(reason);
+  }
+}
+
+void
+PerfScope::stop()
+{
+  PerfCounterValues end;
+  std::string reason;
+  if (m_counted) {
+    m_counted = PerfSection::read_thread_counters(end, reason);
+  }
+  m_section->add(m_start, end, m_counted);
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,138 @@
+/**
+ * @file RecordProcessingChain.cpp RecordProcessingChain class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/RecordProcessingChain.hpp"
+#include "dfmodules/recordprocessorinfo/InfoNljs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <utility>
+
+namespace dunedaq {
+namespace dfmodules {
+
+RecordProcessingChain::RecordProcessingChain(std::vector<std::unique_ptr<RecordProcessor>> processors,
+                                             size_t thread_count,
+                                             size_t max_in_flight)
+  : m_processors(std::move(processors))
+  , m_stats(new ProcessorStats[m_processors.size()])
+  , m_max_in_flight(std::max<size_t>(max_in_flight, 1))
+  , m_pool(thread_count, "recprocessing")
+{}
+
+RecordProcessingChain::~RecordProcessingChain() = default;
+
+void
+RecordProcessingChain::prepare_for_run(daqdataformats::run_number_t run_number)
+{
+  for (auto& processor : m_processors) {
+    processor->prepare_for_run(run_number);
+  }
+}
+
+void
+RecordProcessingChain::submit(record_ptr_t record, std::vector<ProcessedRecord>& done)
+{
+  m_in_flight.push_back(InFlight{ std::move(record), true, {} });
+  InFlight& slot = m_in_flight.back();
+  slot.done = m_pool.submit([this, &slot]() { slot.keep = process(*slot.record); });
+
+  collect(done);
+  while (m_in_flight.size() > m_max_in_flight) {
+    pop_front(done);
+  }
+}
+
+void
+RecordProcessingChain::collect(std::vector<ProcessedRecord>& done)
+{
+  while (!m_in_flight.empty() &&
+         m_in_flight.front().done.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    pop_front(done);
+  }
+}
+
+void
+RecordProcessingChain::drain(std::vector<ProcessedRecord>& done)
+{
+  while (!m_in_flight.empty()) {
+    pop_front(done);
+  }
+}
+
+void
+RecordProcessingChain::pop_front(std::vector<ProcessedRecord>& done)
+{
+  auto& front = m_in_flight.front();
+  front.done.wait();
+  done.push_back(ProcessedRecord{ std::move(front.record), front.keep });
+  m_in_flight.pop_front();
+}
+
+bool
+RecordProcessingChain::process(daqdataformats::TriggerRecord& record)
+{
+  for (size_t i = 0; i < m_processors.size(); ++i) {
+    auto& stats = m_stats[i];
+    size_t bytes_in = record.get_total_size_bytes();
+    auto start_time = std::chrono::steady_clock::now();
+
+    bool keep = true;
+    bool failed = false;
+    try {
+      keep = m_processors[i]->process(record);
+    } catch (const std::exception& excpt) {
+      failed = true;
+      ers::error(RecordProcessingFailed(ERS_HERE,
+                                        m_processors[i]->get_name(),
+                                        record.get_header_ref().get_trigger_number(),
+                                        record.get_header_ref().get_sequence_number(),
+                                        excpt));
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    stats.processing_time_us += std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    ++stats.records_processed;
+    stats.bytes_in += bytes_in;
+    if (failed) {
+      ++stats.failures;
+      stats.bytes_out += record.get_total_size_bytes();
+      return true;
+    }
+    if (!keep) {
+      ++stats.records_dropped;
+      return false;
+    }
+    stats.bytes_out += record.get_total_size_bytes();
+  }
+  return true;
+}
+
+void
+RecordProcessingChain::get_info(opmonlib::InfoCollector& ci, int level)
+{
+  for (size_t i = 0; i < m_processors.size(); ++i) {
+    auto& stats = m_stats[i];
+    recordprocessorinfo::Info info;
+    info.records_processed = stats.records_processed.exchange(0);
+    info.records_dropped = stats.records_dropped.exchange(0);
+    info.failures = stats.failures.exchange(0);
+    info.processing_time_us = stats.processing_time_us.exchange(0);
+    info.bytes_in = stats.bytes_in.exchange(0);
+    info.bytes_out = stats.bytes_out.exchange(0);
+
+    opmonlib::InfoCollector processor_ic;
+    processor_ic.add(info);
+    m_processors[i]->get_info(processor_ic, level);
+    ci.add(m_processors[i]->get_name(), processor_ic);
+  }
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,108 @@
+/**
+ * @file RecordReorderBuffer.cpp RecordReorderBuffer class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/RecordReorderBuffer.hpp"
+
+#include <utility>
+
+namespace dunedaq {
+namespace dfmodules {
+
+void
+RecordReorderBuffer::configure(size_t max_records, size_t max_bytes, std::chrono::milliseconds max_hold)
+{
+  m_max_records = max_records;
+  m_max_bytes = max_bytes;
+  m_max_hold = max_hold;
+}
+
+void
+RecordReorderBuffer::reset()
+{
+  m_records.clear();
+  m_arrivals.clear();
+  m_last_released.reset();
+  m_held_records.store(0);
+  m_held_bytes.store(0);
+  m_late_records.store(0);
+}
+
+RecordReorderBuffer::key_t
+RecordReorderBuffer::key_of(daqdataformats::TriggerRecord& record)
+{
+  return { record.get_header_ref().get_trigger_number(), record.get_header_ref().get_sequence_number() };
+}
+
+void
+RecordReorderBuffer::push(record_ptr_t record, clock_type::time_point now, std::vector<record_ptr_t>& released)
+{
+  auto key = key_of(*record);
+  // a record that comes before one that was released, or a duplicate of a held one, cannot be ordered
+  if ((m_last_released && key <= *m_last_released) || m_records.count(key) > 0) {
+    m_late_records.fetch_add(1, std::memory_order_relaxed);
+    released.push_back(std::move(record));
+    release_expired(now, released);
+    return;
+  }
+
+  size_t size = record->get_total_size_bytes();
+  m_records.emplace(key, HeldRecord{ std::move(record), size });
+  m_arrivals.emplace_back(now, key);
+  m_held_records.store(m_records.size(), std::memory_order_relaxed);
+  m_held_bytes.fetch_add(size, std::memory_order_relaxed);
+
+  while (m_records.size() > m_max_records ||
+         (m_max_bytes > 0 && m_held_bytes.load(std::memory_order_relaxed) > m_max_bytes)) {
+    release_front(released);
+  }
+  release_expired(now, released);
+}
+
+void
+RecordReorderBuffer::release_expired(clock_type::time_point now, std::vector<record_ptr_t>& released)
+{
+  while (!m_arrivals.empty()) {
+    const auto& [arrival, key] = m_arrivals.front();
+    if (m_records.count(key) == 0) {
+      // released already, because of the limits or of a later record that expired
+      m_arrivals.pop_front();
+      continue;
+    }
+    if (now - arrival < m_max_hold) {
+      break;
+    }
+    auto expired_key = key;
+    while (!m_records.empty() && m_records.begin()->first <= expired_key) {
+      release_front(released);
+    }
+    m_arrivals.pop_front();
+  }
+}
+
+void
+RecordReorderBuffer::flush(std::vector<record_ptr_t>& released)
+{
+  while (!m_records.empty()) {
+    release_front(released);
+  }
+  m_arrivals.clear();
+}
+
+void
+RecordReorderBuffer::release_front(std::vector<record_ptr_t>& released)
+{
+  auto it = m_records.begin();
+  m_last_released = it->first;
+  m_held_bytes.fetch_sub(it->second.size, std::memory_order_relaxed);
+  released.push_back(std::move(it->second.record));
+  m_records.erase(it);
+  m_held_records.store(m_records.size(), std::memory_order_relaxed);
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
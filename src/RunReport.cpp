@@ -0,0 +1,295 @@
+/**
+ * @file RunReport.cpp RunReport class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/RunReport.hpp"
+
+#include "logging/Logging.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief Name used by TRACE TLOG calls from this source file
+ */
+#define TRACE_NAME "RunReport" // NOLINT
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+std::string
+format_utc(std::time_t wall_time)
+{
+  std::tm tm_buf;
+  gmtime_r(&wall_time, &tm_buf);
+  std::ostringstream oss;
+  oss << std::put_time(&tm_buf, "%Y-%m-%dT%H:%M:%SZ");
+  return oss.str();
+}
+
+} // namespace
+
+void
+RunReport::Latency::record(std::chrono::microseconds latency)
+{
+  uint64_t us = latency.count() > 0 ? latency.count() : 0; // NOLINT(build/unsigned)
+  // bin i holds the latencies up to 2^i us
+  size_t bin = us <= 1 ? 0 : 64 - __builtin_clzll(us - 1);
+  m_bins[std::min(bin, s_bin_count - 1)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(us, std::memory_order_relaxed);
+  auto max = m_max.load(std::memory_order_relaxed);
+  while (us > max && !m_max.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t // NOLINT(build/unsigned)
+RunReport::Latency::get_quantile(double fraction) const
+{
+  uint64_t count = 0; // NOLINT(build/unsigned)
+  std::array<uint64_t, s_bin_count> bins; // NOLINT(build/unsigned)
+  for (size_t i = 0; i < s_bin_count; ++i) {
+    bins[i] = m_bins[i].load(std::memory_order_relaxed);
+    count += bins[i];
+  }
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t seen = 0; // NOLINT(build/unsigned)
+  for (size_t i = 0; i < s_bin_count; ++i) {
+    seen += bins[i];
+    if (seen > 0 && static_cast<double>(seen) >= fraction * count) {
+      // the upper edge of the bin, but never more than the actual maximum
+      return std::min<uint64_t>(uint64_t(1) << i, get_max()); // NOLINT(build/unsigned)
+    }
+  }
+  return get_max();
+}
+
+double
+RunReport::Latency::get_mean() const
+{
+  auto count = get_count();
+  return count > 0 ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / count : 0.;
+}
+
+void
+RunReport::Latency::reset()
+{
+  for (auto& bin : m_bins) {
+    bin.store(0);
+  }
+  m_count.store(0);
+  m_sum.store(0);
+  m_max.store(0);
+}
+
+void
+RunReport::StateTimer::set(bool active)
+{
+  if (active == m_active.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (active == m_active.load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto now = clock_type::now();
+  if (!active) {
+    m_total += now - m_since;
+  }
+  m_since = now;
+  m_active.store(active, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds
+RunReport::StateTimer::get_time(clock_type::time_point now) const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto total = m_total;
+  if (m_active.load(std::memory_order_relaxed) && now > m_since) {
+    total += now - m_since;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(total);
+}
+
+void
+RunReport::StateTimer::reset(clock_type::time_point now)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_total = clock_type::duration::zero();
+  m_since = now;
+}
+
+RunReport::RunReport(std::string owner_name, std::string module_class)
+  : m_owner_name(std::move(owner_name))
+  , m_module_class(std::move(module_class))
+{}
+
+void
+RunReport::configure(const runreport::RunReport& conf)
+{
+  m_enabled = conf.enabled;
+  m_output_path = conf.output_path;
+}
+
+RunReport::Counter&
+RunReport::add_counter(const std::string& name)
+{
+  m_counters.emplace_back(name, std::make_unique<Counter>());
+  return *m_counters.back().second;
+}
+
+RunReport::Peak&
+RunReport::add_peak(const std::string& name)
+{
+  m_peaks.emplace_back(name, std::make_unique<Peak>());
+  return *m_peaks.back().second;
+}
+
+RunReport::Latency&
+RunReport::add_latency(const std::string& name)
+{
+  m_latencies.emplace_back(name, std::make_unique<Latency>());
+  return *m_latencies.back().second;
+}
+
+RunReport::StateTimer&
+RunReport::add_state(const std::string& name)
+{
+  m_states.emplace_back(name, std::make_unique<StateTimer>());
+  return *m_states.back().second;
+}
+
+void
+RunReport::set_value(const std::string& name, double value)
+{
+  std::lock_guard<std::mutex> lk(m_values_mutex);
+  m_values[name] = value;
+}
+
+void
+RunReport::start(daqdataformats::run_number_t run_number)
+{
+  m_run_number = run_number;
+  m_start_time = clock_type::now();
+  m_start_wall_time = std::time(nullptr);
+
+  for (auto& counter : m_counters) {
+    counter.second->reset();
+  }
+  for (auto& peak : m_peaks) {
+    peak.second->reset();
+  }
+  for (auto& latency : m_latencies) {
+    latency.second->reset();
+  }
+  for (auto& state : m_states) {
+    state.second->reset(m_start_time);
+  }
+  std::lock_guard<std::mutex> lk(m_values_mutex);
+  m_values.clear();
+}
+
+void
+RunReport::stop()
+{
+  if (!m_enabled) {
+    return;
+  }
+
+  std::ostringstream name_oss;
+  name_oss << "runreport_" << m_owner_name << "_run" << std::setw(6) << std::setfill('0') << m_run_number << ".json";
+  auto file_path = std::filesystem::path(m_output_path) / name_oss.str();
+  auto temp_path = file_path;
+  temp_path += ".writing";
+
+  std::ofstream ofs(temp_path);
+  write(ofs);
+  ofs.close();
+
+  std::error_code ec;
+  if (ofs.fail()) {
+    ers::warning(RunReportWriteFailed(ERS_HERE, m_owner_name, file_path.string(), "the file could not be written"));
+  } else if (std::filesystem::rename(temp_path, file_path, ec); ec) {
+    ers::warning(RunReportWriteFailed(ERS_HERE, m_owner_name, file_path.string(), ec.message()));
+  } else {
+    ers::info(RunReportWritten(ERS_HERE, m_owner_name, m_run_number, file_path.string()));
+  }
+}
+
+void
+RunReport::write(std::ostream& os) const
+{
+  auto now = clock_type::now();
+  double duration_s = std::chrono::duration<double>(now - m_start_time).count();
+
+  nlohmann::json report;
+  report["module"] = m_owner_name;
+  report["module_class"] = m_module_class;
+  report["run_number"] = m_run_number;
+  report["start_time"] = format_utc(m_start_wall_time);
+  report["stop_time"] = format_utc(std::time(nullptr));
+  report["duration_s"] = duration_s;
+  report["peak_rss_kb"] = get_peak_rss_kb();
+
+  auto& counters = report["counters"] = nlohmann::json::object();
+  for (const auto& [name, counter] : m_counters) {
+    auto total = counter->get();
+    counters[name] = { { "total", total }, { "rate_hz", duration_s > 0 ? total / duration_s : 0. } };
+  }
+
+  auto& latencies = report["latencies_us"] = nlohmann::json::object();
+  for (const auto& [name, latency] : m_latencies) {
+    latencies[name] = { { "count", latency->get_count() },    { "mean", latency->get_mean() },
+                        { "p50", latency->get_quantile(0.5) }, { "p90", latency->get_quantile(0.9) },
+                        { "p99", latency->get_quantile(0.99) }, { "max", latency->get_max() } };
+  }
+
+  auto& peaks = report["peaks"] = nlohmann::json::object();
+  for (const auto& [name, peak] : m_peaks) {
+    peaks[name] = peak->get();
+  }
+
+  auto& states = report["states"] = nlohmann::json::object();
+  for (const auto& [name, state] : m_states) {
+    double time_s = std::chrono::duration<double>(state->get_time(now)).count();
+    states[name] = { { "time_s", time_s }, { "fraction", duration_s > 0 ? time_s / duration_s : 0. } };
+  }
+
+  auto& values = report["values"] = nlohmann::json::object();
+  {
+    std::lock_guard<std::mutex> lk(m_values_mutex);
+    for (const auto& [name, value] : m_values) {
+      values[name] = value;
+    }
+  }
+
+  os << report.dump(2) << std::endl;
+}
+
+int64_t
+RunReport::get_peak_rss_kb()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  return usage.ru_maxrss;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,189 @@
+/**
+ * @file StorageBandwidthProbe.cpp StorageBandwidthProbe class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/StorageBandwidthProbe.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Name used by TRACE TLOG calls from this source file
+ */
+#define TRACE_NAME "StorageBandwidthProbe" // NOLINT
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+constexpr int s_tlvl_probe = 5;
+
+/**
+ * @brief Closes and removes the temporary file, however the measurement ends
+ */
+class ProbeFile
+{
+public:
+  explicit ProbeFile(const std::string& file_name)
+    : m_file_name(file_name)
+    , m_fd(::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))
+  {}
+  ~ProbeFile()
+  {
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      ::unlink(m_file_name.c_str());
+    }
+  }
+  ProbeFile(const ProbeFile&) = delete;
+  ProbeFile& operator=(const ProbeFile&) = delete;
+
+  int get_fd() const { return m_fd; }
+
+private:
+  std::string m_file_name;
+  int m_fd;
+};
+
+std::chrono::microseconds
+percentile(const std::vector<std::chrono::steady_clock::duration>& sorted_latencies, double fraction)
+{
+  if (sorted_latencies.empty()) {
+    return std::chrono::microseconds(0);
+  }
+  size_t index = std::min(static_cast<size_t>(fraction * sorted_latencies.size()), sorted_latencies.size() - 1);
+  return std::chrono::duration_cast<std::chrono::microseconds>(sorted_latencies[index]);
+}
+
+} // namespace
+
+StorageBandwidthProbe::StorageBandwidthProbe(const storageprobe::BandwidthProbe& conf)
+  : m_conf(conf)
+{
+  if (m_conf.block_sizes_bytes.empty()) {
+    m_conf.block_sizes_bytes.push_back(s_default_block_size);
+  }
+}
+
+std::vector<StorageBandwidthProbe::Result>
+StorageBandwidthProbe::run(const std::string& directory) const
+{
+  struct statvfs vfs_results;
+  if (statvfs(directory.c_str(), &vfs_results) != 0) {
+    throw StorageBandwidthProbeFailed(ERS_HERE, directory, std::strerror(errno));
+  }
+  // the probe should never be the one that fills the disk
+  size_t free_space = vfs_results.f_bsize * vfs_results.f_bavail;
+  if (free_space < 2 * m_conf.bytes_per_block_size) {
+    throw StorageBandwidthProbeFailed(ERS_HERE,
+                                      directory,
+                                      "only " + std::to_string(free_space) + " bytes are free, and the probe needs " +
+                                        std::to_string(2 * m_conf.bytes_per_block_size));
+  }
+
+  auto file_name =
+    (std::filesystem::path(directory) / (".storage_bandwidth_probe_" + std::to_string(getpid()) + ".tmp")).string();
+  auto max_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::milliseconds(m_conf.max_duration_ms)) /
+                      m_conf.block_sizes_bytes.size();
+
+  std::vector<Result> results;
+  for (auto block_size : m_conf.block_sizes_bytes) {
+    results.push_back(measure(file_name, std::max<size_t>(block_size, 1), max_duration));
+    const auto& result = results.back();
+    TLOG_DEBUG(s_tlvl_probe) << directory << ": " << result.bytes_written << " bytes in blocks of " << block_size
+                             << " written at " << result.bandwidth_bytes_per_s << " bytes/s, latency p50 "
+                             << result.latency_p50.count() << " us, p99 " << result.latency_p99.count() << " us, max "
+                             << result.latency_max.count() << " us";
+  }
+  return results;
+}
+
+StorageBandwidthProbe::Result
+StorageBandwidthProbe::measure(const std::string& file_name,
+                               size_t block_size,
+                               std::chrono::steady_clock::duration max_duration) const
+{
+  // random data, so that compressing or deduplicating file systems write all of it
+  std::vector<char> block(block_size);
+  std::mt19937 random_engine(block_size);
+  std::generate(block.begin(), block.end(), [&]() { return static_cast<char>(random_engine()); });
+
+  ProbeFile file(file_name);
+  if (file.get_fd() < 0) {
+    throw StorageBandwidthProbeFailed(ERS_HERE, file_name, std::strerror(errno));
+  }
+
+  Result result;
+  result.block_size = block_size;
+  std::vector<std::chrono::steady_clock::duration> latencies;
+  latencies.reserve(m_conf.bytes_per_block_size / block_size + 1);
+  size_t bytes_since_sync = 0;
+
+  auto start_time = std::chrono::steady_clock::now();
+  auto end_time = start_time + max_duration;
+  auto now = start_time;
+  while (result.bytes_written < m_conf.bytes_per_block_size && now < end_time) {
+    auto block_start = now;
+    size_t offset = 0;
+    while (offset < block_size) {
+      ssize_t written = ::write(file.get_fd(), block.data() + offset, block_size - offset);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw StorageBandwidthProbeFailed(ERS_HERE, file_name, std::strerror(errno));
+      }
+      offset += written;
+    }
+    result.bytes_written += block_size;
+    bytes_since_sync += block_size;
+
+    bool last = result.bytes_written >= m_conf.bytes_per_block_size;
+    if ((m_conf.sync_interval_bytes > 0 && bytes_since_sync >= m_conf.sync_interval_bytes) || last) {
+      if (::fdatasync(file.get_fd()) != 0) {
+        throw StorageBandwidthProbeFailed(ERS_HERE, file_name, std::strerror(errno));
+      }
+      bytes_since_sync = 0;
+    }
+    now = std::chrono::steady_clock::now();
+    latencies.push_back(now - block_start);
+  }
+  // the data written when the time ran out still has to reach the device
+  if (bytes_since_sync > 0) {
+    if (::fdatasync(file.get_fd()) != 0) {
+      throw StorageBandwidthProbeFailed(ERS_HERE, file_name, std::strerror(errno));
+    }
+    now = std::chrono::steady_clock::now();
+  }
+
+  result.duration = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time);
+  if (result.duration.count() > 0) {
+    result.bandwidth_bytes_per_s = result.bytes_written * 1e6 / result.duration.count();
+  }
+  std::sort(latencies.begin(), latencies.end());
+  result.latency_p50 = percentile(latencies, 0.5);
+  result.latency_p99 = percentile(latencies, 0.99);
+  if (!latencies.empty()) {
+    result.latency_max = std::chrono::duration_cast<std::chrono::microseconds>(latencies.back());
+  }
+  return result;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
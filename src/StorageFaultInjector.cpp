@@ -0,0 +1,158 @@
+/**
+ * @file StorageFaultInjector.cpp StorageFaultInjector class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/StorageFaultInjector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+
+namespace dunedaq {
+namespace dfmodules {
+
+StorageFaultInjector::StorageFaultInjector(const storagefaults::StorageFaults& conf)
+  : m_latency_mean_us(conf.latency_mean_us)
+  , m_latency_spread_us(conf.latency_spread_us)
+  , m_throughput_cap(conf.throughput_cap_bytes_per_s)
+  , m_stall_period(conf.stall_period_ms)
+  , m_stall_duration(conf.stall_duration_ms)
+  , m_full_period(conf.full_period_ms)
+  , m_full_duration(conf.full_duration_ms)
+  , m_full_probability(conf.full_probability)
+  , m_random_engine(conf.random_seed != 0 ? conf.random_seed : std::random_device()())
+{
+  if (conf.latency_distribution == "none") {
+    m_distribution = Distribution::kNone;
+  } else if (conf.latency_distribution == "constant") {
+    m_distribution = Distribution::kConstant;
+  } else if (conf.latency_distribution == "uniform") {
+    m_distribution = Distribution::kUniform;
+    if (m_latency_spread_us > m_latency_mean_us) {
+      throw InvalidStorageFaults(ERS_HERE, "the spread of a uniform latency cannot be larger than its mean");
+    }
+  } else if (conf.latency_distribution == "exponential") {
+    m_distribution = Distribution::kExponential;
+  } else if (conf.latency_distribution == "lognormal") {
+    m_distribution = Distribution::kLognormal;
+    if (m_latency_mean_us <= 0) {
+      throw InvalidStorageFaults(ERS_HERE, "a lognormal latency needs a positive mean");
+    }
+    // parameters of the underlying normal distribution that give the configured mean and standard deviation
+    double sigma2 = std::log(1. + (m_latency_spread_us * m_latency_spread_us) / (m_latency_mean_us * m_latency_mean_us));
+    m_lognormal = std::lognormal_distribution<double>(std::log(m_latency_mean_us) - sigma2 / 2, std::sqrt(sigma2));
+  } else {
+    throw InvalidStorageFaults(ERS_HERE, "unknown latency distribution \"" + conf.latency_distribution + "\"");
+  }
+
+  if (m_stall_period.count() > 0 && m_stall_duration > m_stall_period) {
+    throw InvalidStorageFaults(ERS_HERE, "the stalls cannot be longer than their period");
+  }
+  if (m_full_period.count() > 0 && m_full_duration > m_full_period) {
+    throw InvalidStorageFaults(ERS_HERE, "the full storage episodes cannot be longer than their period");
+  }
+  if (m_full_probability < 0 || m_full_probability > 1) {
+    throw InvalidStorageFaults(ERS_HERE, "full_probability has to be between 0 and 1");
+  }
+
+  start();
+}
+
+void
+StorageFaultInjector::start()
+{
+  m_start_time = clock_type::now();
+  m_device_free_time = m_start_time;
+  m_write_count = 0;
+  m_failed_write_count = 0;
+  m_stalled_write_count = 0;
+  m_injected_delay = clock_type::duration::zero();
+}
+
+bool
+StorageFaultInjector::is_full()
+{
+  clock_type::duration remaining;
+  bool full = in_episode(clock_type::now() - m_start_time, m_full_period, m_full_duration, remaining) ||
+              (m_full_probability > 0 && m_uniform(m_random_engine) < m_full_probability);
+  if (full) {
+    ++m_failed_write_count;
+  }
+  return full;
+}
+
+void
+StorageFaultInjector::delay_write(size_t bytes)
+{
+  ++m_write_count;
+  auto now = clock_type::now();
+  auto done_time = now;
+
+  clock_type::duration remaining;
+  if (in_episode(now - m_start_time, m_stall_period, m_stall_duration, remaining)) {
+    done_time += remaining;
+    ++m_stalled_write_count;
+  }
+
+  done_time += draw_latency();
+
+  if (m_throughput_cap > 0) {
+    auto write_time = std::chrono::duration_cast<clock_type::duration>(
+      std::chrono::duration<double>(static_cast<double>(bytes) / m_throughput_cap));
+    m_device_free_time = std::max(m_device_free_time, done_time) + write_time;
+    done_time = m_device_free_time;
+  }
+
+  if (done_time > now) {
+    std::this_thread::sleep_until(done_time);
+    m_injected_delay += done_time - now;
+  }
+}
+
+StorageFaultInjector::clock_type::duration
+StorageFaultInjector::draw_latency()
+{
+  double latency_us = 0;
+  switch (m_distribution) {
+    case Distribution::kNone:
+      break;
+    case Distribution::kConstant:
+      latency_us = m_latency_mean_us;
+      break;
+    case Distribution::kUniform:
+      latency_us = m_latency_mean_us + m_latency_spread_us * (2 * m_uniform(m_random_engine) - 1);
+      break;
+    case Distribution::kExponential:
+      latency_us = -m_latency_mean_us * std::log(1. - m_uniform(m_random_engine));
+      break;
+    case Distribution::kLognormal:
+      latency_us = m_lognormal(m_random_engine);
+      break;
+  }
+  return std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double, std::micro>(latency_us));
+}
+
+bool
+StorageFaultInjector::in_episode(clock_type::duration elapsed,
+                                 std::chrono::milliseconds period,
+                                 std::chrono::milliseconds duration,
+                                 clock_type::duration& remaining)
+{
+  if (period.count() == 0 || duration.count() == 0) {
+    return false;
+  }
+  auto phase = elapsed % period;
+  if (phase >= duration) {
+    return false;
+  }
+  remaining = duration - phase;
+  return true;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -62,7 +62,7 @@ TimeSliceAccumulator::add_tpset(trigger::TPSet&& tpset)
   }
 
   // create an entry in the top-level map for the sourceid in this TPSet, if needed
-  auto lk = std::lock_guard<std::mutex>(m_bundle_map_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_bundle_map_mutex);
   if (m_tpbundles_by_sourceid_and_start_time.count(tpset.origin) == 0) {
     tpbundles_by_start_time_t empty_bundle_map;
     m_tpbundles_by_sourceid_and_start_time[tpset.origin] = empty_bundle_map;
@@ -79,7 +79,7 @@ TimeSliceAccumulator::add_tpset(trigger::TPSet&& tpset)
 std::unique_ptr<daqdataformats::TimeSlice>
 TimeSliceAccumulator::get_timeslice()
 {
-  auto lk = std::lock_guard<std::mutex>(m_bundle_map_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_bundle_map_mutex);
   std::vector<std::unique_ptr<daqdataformats::Fragment>> list_of_fragments;
 
   // loop over all SourceID present in this accumulator
@@ -132,12 +132,13 @@ TPBundleHandler::add_tpset(trigger::TPSet&& tpset)
   // add the TPSet to any 'extra' accumulators
   for (size_t tsidx = (tsidx_from_begin_time + 1); tsidx <= tsidx_from_end_time; ++tsidx) {
     {
-      auto lk = std::lock_guard<std::mutex>(m_accumulator_map_mutex);
+      auto lk = std::lock_guard<InstrumentedMutex>(m_accumulator_map_mutex);
       if (m_timeslice_accumulators.count(tsidx) == 0) {
         TimeSliceAccumulator accum(tsidx * m_slice_interval,
                                    (tsidx + 1) * m_slice_interval,
                                    tsidx - m_slice_index_offset,
-                                   m_run_number);
+                                   m_run_number,
+                                   m_lock_owner);
         m_timeslice_accumulators[tsidx] = accum;
       }
     }
@@ -147,12 +148,13 @@ TPBundleHandler::add_tpset(trigger::TPSet&& tpset)
 
   // add the TPSet to the accumulator associated with the begin time
   {
-    auto lk = std::lock_guard<std::mutex>(m_accumulator_map_mutex);
+    auto lk = std::lock_guard<InstrumentedMutex>(m_accumulator_map_mutex);
     if (m_timeslice_accumulators.count(tsidx_from_begin_time) == 0) {
       TimeSliceAccumulator accum(tsidx_from_begin_time * m_slice_interval,
                                  (tsidx_from_begin_time + 1) * m_slice_interval,
                                  tsidx_from_begin_time - m_slice_index_offset,
-                                 m_run_number);
+                                 m_run_number,
+                                 m_lock_owner);
       m_timeslice_accumulators[tsidx_from_begin_time] = accum;
     }
   }
@@ -168,12 +170,13 @@ TPBundleHandler::get_properly_aged_timeslices()
   auto now = std::chrono::steady_clock::now();
   for (auto& [tsidx, accum] : m_timeslice_accumulators) {
     if ((now - accum.get_update_time()) >= m_cooling_off_time) {
+      PerfScope perf_scope(m_get_timeslice_perf);
       list_of_timeslices.push_back(accum.get_timeslice());
       elements_to_be_removed.push_back(tsidx);
     }
   }
 
-  auto lk = std::lock_guard<std::mutex>(m_accumulator_map_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_accumulator_map_mutex);
   for (auto& tsidx : elements_to_be_removed) {
     m_timeslice_accumulators.erase(tsidx);
   }
@@ -0,0 +1,64 @@
+/**
+ * @file TRMonRequestIndex.cpp TRMonRequestIndex class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/TRMonRequestIndex.hpp"
+
+#include <mutex>
+#include <utility>
+
+namespace dunedaq {
+namespace dfmodules {
+
+TRMonRequestIndex::TRMonRequestIndex(const std::string& lock_owner, const char* lock_name)
+  : m_mutex(lock_owner, lock_name)
+{}
+
+void
+TRMonRequestIndex::add(const dfmessages::TRMonRequest& request)
+{
+  const std::lock_guard<InstrumentedMutex> lock(m_mutex);
+  m_requests[request.trigger_type].push_back(request);
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+  // published after the request, so that a reader that sees the count finds the request
+  m_pending_in_bucket[get_bucket(request.trigger_type)].fetch_add(1, std::memory_order_release);
+}
+
+std::vector<dfmessages::TRMonRequest>
+TRMonRequestIndex::take(trigger_type_t trigger_type)
+{
+  std::vector<dfmessages::TRMonRequest> requests;
+  if (!may_have(trigger_type)) {
+    return requests;
+  }
+
+  const std::lock_guard<InstrumentedMutex> lock(m_mutex);
+  auto it = m_requests.find(trigger_type);
+  if (it == m_requests.end()) {
+    // the pending requests of the bucket are of other trigger types
+    return requests;
+  }
+  requests = std::move(it->second);
+  m_requests.erase(it);
+  m_pending.fetch_sub(requests.size(), std::memory_order_relaxed);
+  m_pending_in_bucket[get_bucket(trigger_type)].fetch_sub(requests.size(), std::memory_order_relaxed);
+  return requests;
+}
+
+void
+TRMonRequestIndex::clear()
+{
+  const std::lock_guard<InstrumentedMutex> lock(m_mutex);
+  m_requests.clear();
+  m_pending.store(0);
+  for (auto& count : m_pending_in_bucket) {
+    count.store(0);
+  }
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,298 @@
+/**
+ * @file ThreadPlacement.cpp ThreadPlacement class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/ThreadPlacement.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Name used by TRACE TLOG calls from this source file
+ */
+#define TRACE_NAME "ThreadPlacement" // NOLINT
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+// Size of the node masks passed to the memory policy system calls. It has to be
+// at least the number of possible nodes of the system for get_mempolicy.
+constexpr unsigned long s_max_numa_nodes = 1024; // NOLINT(runtime/int)
+constexpr unsigned long s_bits_per_word = 8 * sizeof(unsigned long); // NOLINT(runtime/int)
+
+using node_mask_t = std::vector<unsigned long>; // NOLINT(runtime/int)
+
+// glibc does not wrap the memory policy system calls, and libnuma is not used
+// only for these two
+long // NOLINT(runtime/int)
+set_mempolicy(int mode, const unsigned long* nodemask, unsigned long maxnode) // NOLINT(runtime/int)
+{
+  return syscall(SYS_set_mempolicy, mode, nodemask, maxnode);
+}
+
+long // NOLINT(runtime/int)
+get_mempolicy(int* mode, unsigned long* nodemask, unsigned long maxnode) // NOLINT(runtime/int)
+{
+  return syscall(SYS_get_mempolicy, mode, nodemask, maxnode, nullptr, 0UL);
+}
+
+std::string
+to_string(const std::set<int>& values)
+{
+  std::ostringstream oss;
+  for (auto it = values.begin(); it != values.end(); ++it) {
+    oss << (it == values.begin() ? "" : ",") << *it;
+  }
+  return oss.str();
+}
+
+const char*
+to_string(ThreadPlacement::MemoryPolicy policy)
+{
+  switch (policy) {
+    case ThreadPlacement::MemoryPolicy::kLocal:
+      return "local";
+    case ThreadPlacement::MemoryPolicy::kBind:
+      return "bind";
+    case ThreadPlacement::MemoryPolicy::kPreferred:
+      return "preferred";
+    case ThreadPlacement::MemoryPolicy::kInterleave:
+      return "interleave";
+    default:
+      return "default";
+  }
+}
+
+} // namespace
+
+ThreadPlacement::ThreadPlacement(const threadplacement::ThreadPlacement& conf)
+  : m_cpus(parse_cpu_list(conf.cpu_list))
+{
+  if (conf.memory_policy == "default" || conf.memory_policy.empty()) {
+    m_memory_policy = MemoryPolicy::kDefault;
+  } else if (conf.memory_policy == "local") {
+    m_memory_policy = MemoryPolicy::kLocal;
+  } else if (conf.memory_policy == "bind") {
+    m_memory_policy = MemoryPolicy::kBind;
+  } else if (conf.memory_policy == "preferred") {
+    m_memory_policy = MemoryPolicy::kPreferred;
+  } else if (conf.memory_policy == "interleave") {
+    m_memory_policy = MemoryPolicy::kInterleave;
+  } else {
+    throw InvalidThreadPlacement(ERS_HERE, "unknown memory policy \"" + conf.memory_policy + "\"");
+  }
+
+  if (m_memory_policy == MemoryPolicy::kDefault || m_memory_policy == MemoryPolicy::kLocal) {
+    return;
+  }
+
+  if (conf.numa_node >= 0) {
+    if (static_cast<unsigned long>(conf.numa_node) >= s_max_numa_nodes) { // NOLINT(runtime/int)
+      throw InvalidThreadPlacement(ERS_HERE, "NUMA node " + std::to_string(conf.numa_node) + " is out of range");
+    }
+    m_numa_nodes.insert(conf.numa_node);
+  } else {
+    for (auto cpu : m_cpus) {
+      auto node = numa_node_of_cpu(cpu);
+      if (node >= 0) {
+        m_numa_nodes.insert(node);
+      }
+    }
+  }
+
+  if (m_numa_nodes.empty()) {
+    throw InvalidThreadPlacement(ERS_HERE,
+                                 std::string("the \"") + to_string(m_memory_policy) +
+                                   "\" memory policy needs a numa_node, or a cpu_list on known NUMA nodes");
+  }
+  if (m_memory_policy == MemoryPolicy::kPreferred && m_numa_nodes.size() > 1) {
+    throw InvalidThreadPlacement(ERS_HERE,
+                                 "the \"preferred\" memory policy takes a single NUMA node, the CPUs in the list are on "
+                                 "nodes " + to_string(m_numa_nodes));
+  }
+}
+
+std::set<int>
+ThreadPlacement::parse_cpu_list(const std::string& cpu_list)
+{
+  std::set<int> cpus;
+  std::istringstream iss(cpu_list);
+  std::string token;
+  while (std::getline(iss, token, ',')) {
+    token.erase(0, token.find_first_not_of(" \t"));
+    token.erase(token.find_last_not_of(" \t") + 1);
+    if (token.empty()) {
+      continue;
+    }
+    try {
+      size_t pos = 0;
+      int first = std::stoi(token, &pos);
+      int last = first;
+      if (pos < token.size()) {
+        if (token[pos] != '-') {
+          throw std::invalid_argument(token);
+        }
+        std::string rest = token.substr(pos + 1);
+        last = std::stoi(rest, &pos);
+        if (pos != rest.size()) {
+          throw std::invalid_argument(token);
+        }
+      }
+      if (first < 0 || last < first || last >= CPU_SETSIZE) {
+        throw std::out_of_range(token);
+      }
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.insert(cpu);
+      }
+    } catch (const std::logic_error&) {
+      throw InvalidThreadPlacement(ERS_HERE, "invalid element \"" + token + "\" in CPU list \"" + cpu_list + "\"");
+    }
+  }
+  return cpus;
+}
+
+int
+ThreadPlacement::numa_node_of_cpu(int cpu)
+{
+  std::error_code ec;
+  std::filesystem::directory_iterator dir("/sys/devices/system/cpu/cpu" + std::to_string(cpu), ec);
+  if (ec) {
+    return -1;
+  }
+  for (const auto& entry : dir) {
+    std::string name = entry.path().filename().string();
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+        name.find_first_not_of("0123456789", 4) == std::string::npos) {
+      return std::stoi(name.substr(4));
+    }
+  }
+  return -1;
+}
+
+bool
+ThreadPlacement::apply_to_current_thread(const std::string& thread_name) const
+{
+  if (is_empty()) {
+    return true;
+  }
+
+  bool success = true;
+  if (!m_cpus.empty()) {
+    success &= apply_affinity(thread_name);
+  }
+  if (m_memory_policy != MemoryPolicy::kDefault) {
+    success &= apply_memory_policy(thread_name);
+  }
+
+  if (success) {
+    std::ostringstream oss;
+    oss << thread_name << ": thread placement applied";
+    if (!m_cpus.empty()) {
+      oss << ", CPUs " << to_string(m_cpus) << " (now running on CPU " << sched_getcpu() << ")";
+    }
+    if (m_memory_policy != MemoryPolicy::kDefault) {
+      oss << ", memory policy " << to_string(m_memory_policy);
+      if (!m_numa_nodes.empty()) {
+        oss << " on NUMA nodes " << to_string(m_numa_nodes);
+      }
+    }
+    TLOG() << oss.str();
+  }
+  return success;
+}
+
+bool
+ThreadPlacement::apply_affinity(const std::string& thread_name) const
+{
+  cpu_set_t requested;
+  CPU_ZERO(&requested);
+  for (auto cpu : m_cpus) {
+    CPU_SET(cpu, &requested);
+  }
+
+  int rc = pthread_setaffinity_np(pthread_self(), sizeof(requested), &requested);
+  if (rc != 0) {
+    ers::warning(ThreadPlacementFailed(ERS_HERE, thread_name, "CPU affinity " + to_string(m_cpus), strerror(rc)));
+    return false;
+  }
+
+  cpu_set_t actual;
+  CPU_ZERO(&actual);
+  rc = pthread_getaffinity_np(pthread_self(), sizeof(actual), &actual);
+  if (rc != 0 || !CPU_EQUAL(&requested, &actual)) {
+    ers::warning(ThreadPlacementFailed(ERS_HERE,
+                                       thread_name,
+                                       "CPU affinity " + to_string(m_cpus),
+                                       rc != 0 ? strerror(rc) : "the affinity read back differs from the requested one"));
+    return false;
+  }
+  return true;
+}
+
+bool
+ThreadPlacement::apply_memory_policy(const std::string& thread_name) const
+{
+  int mode = MPOL_DEFAULT;
+  switch (m_memory_policy) {
+    case MemoryPolicy::kLocal:
+      mode = MPOL_LOCAL;
+      break;
+    case MemoryPolicy::kBind:
+      mode = MPOL_BIND;
+      break;
+    case MemoryPolicy::kPreferred:
+      mode = MPOL_PREFERRED;
+      break;
+    case MemoryPolicy::kInterleave:
+      mode = MPOL_INTERLEAVE;
+      break;
+    default:
+      return true;
+  }
+
+  node_mask_t requested(s_max_numa_nodes / s_bits_per_word, 0);
+  for (auto node : m_numa_nodes) {
+    requested[node / s_bits_per_word] |= 1UL << (node % s_bits_per_word);
+  }
+
+  std::string what = std::string("memory policy ") + to_string(m_memory_policy);
+  if (set_mempolicy(mode, m_numa_nodes.empty() ? nullptr : requested.data(), s_max_numa_nodes) != 0) {
+    ers::warning(ThreadPlacementFailed(ERS_HERE, thread_name, what, strerror(errno)));
+    return false;
+  }
+
+  int actual_mode = -1;
+  node_mask_t actual(s_max_numa_nodes / s_bits_per_word, 0);
+  if (get_mempolicy(&actual_mode, actual.data(), s_max_numa_nodes) != 0) {
+    ers::warning(ThreadPlacementFailed(ERS_HERE, thread_name, what, strerror(errno)));
+    return false;
+  }
+  if (actual_mode != mode || (!m_numa_nodes.empty() && actual != requested)) {
+    ers::warning(ThreadPlacementFailed(
+      ERS_HERE, thread_name, what, "the memory policy read back differs from the requested one"));
+    return false;
+  }
+  return true;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,366 @@
+/**
+ * @file TriggerManifest.cpp TriggerManifest and TriggerManifestWriter class implementations
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/TriggerManifest.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+namespace dunedaq {
+namespace dfmodules {
+
+namespace {
+
+constexpr uint32_t s_file_frame = 1;    // NOLINT(build/unsigned)
+constexpr uint32_t s_entries_frame = 2; // NOLINT(build/unsigned)
+constexpr char s_magic[8] = { 'D', 'F', 'T', 'R', 'M', 'A', 'N', '1' };
+
+struct ManifestHeader
+{
+  char magic[8];
+  uint32_t file_count;     // NOLINT(build/unsigned)
+  uint32_t reserved;       // NOLINT(build/unsigned)
+  uint64_t entry_count;    // NOLINT(build/unsigned)
+  uint64_t entries_offset; // NOLINT(build/unsigned)
+};
+static_assert(sizeof(ManifestHeader) == 32, "ManifestHeader must be packed on 32 bytes");
+
+/**
+ * @brief Reads the frames of a journal, stopping at the first incomplete one
+ */
+void
+read_journal(const std::string& journal_path,
+             std::map<std::string, uint32_t>& file_ids, // NOLINT(build/unsigned)
+             std::vector<std::string>& file_names,
+             std::vector<TriggerManifestEntry>& entries)
+{
+  std::ifstream journal(journal_path, std::ios::binary);
+  if (!journal) {
+    throw TriggerManifestProblem(ERS_HERE, journal_path, "the journal could not be opened");
+  }
+
+  std::vector<uint32_t> local_to_global; // NOLINT(build/unsigned)
+  std::vector<char> payload;
+  uint32_t frame[2]; // NOLINT(build/unsigned)
+  while (journal.read(reinterpret_cast<char*>(frame), sizeof(frame))) {
+    payload.resize(frame[1]);
+    if (!journal.read(payload.data(), payload.size())) {
+      break;
+    }
+    if (frame[0] == s_file_frame) {
+      std::string name(payload.begin(), payload.end());
+      auto it = file_ids.emplace(name, file_names.size()).first;
+      if (it->second == file_names.size()) {
+        file_names.push_back(name);
+      }
+      local_to_global.push_back(it->second);
+    } else if (frame[0] == s_entries_frame) {
+      size_t count = payload.size() / sizeof(TriggerManifestEntry);
+      size_t first = entries.size();
+      entries.resize(first + count);
+      std::memcpy(&entries[first], payload.data(), count * sizeof(TriggerManifestEntry));
+      for (size_t i = first; i < entries.size(); ++i) {
+        if (entries[i].file_id >= local_to_global.size()) {
+          throw TriggerManifestProblem(ERS_HERE, journal_path, "an entry refers to an unknown file");
+        }
+        entries[i].file_id = local_to_global[entries[i].file_id];
+      }
+    }
+  }
+}
+
+/**
+ * @brief Reads the file table and the entries of a merged manifest
+ */
+void
+read_manifest(const std::string& manifest_path,
+              std::map<std::string, uint32_t>& file_ids, // NOLINT(build/unsigned)
+              std::vector<std::string>& file_names,
+              std::vector<TriggerManifestEntry>& entries)
+{
+  std::ifstream manifest(manifest_path, std::ios::binary);
+  ManifestHeader header;
+  if (!manifest.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, s_magic, sizeof(s_magic)) != 0) {
+    throw TriggerManifestProblem(ERS_HERE, manifest_path, "not a trigger manifest");
+  }
+
+  std::vector<uint32_t> local_to_global; // NOLINT(build/unsigned)
+  for (uint32_t i = 0; i < header.file_count; ++i) { // NOLINT(build/unsigned)
+    uint32_t length;                                  // NOLINT(build/unsigned)
+    std::string name;
+    if (manifest.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+      name.resize(length);
+      manifest.read(name.data(), length);
+    }
+    if (!manifest) {
+      throw TriggerManifestProblem(ERS_HERE, manifest_path, "the file table is corrupted");
+    }
+    auto it = file_ids.emplace(name, file_names.size()).first;
+    if (it->second == file_names.size()) {
+      file_names.push_back(name);
+    }
+    local_to_global.push_back(it->second);
+  }
+
+  size_t first = entries.size();
+  entries.resize(first + header.entry_count);
+  manifest.seekg(header.entries_offset);
+  if (!manifest.read(reinterpret_cast<char*>(&entries[first]), header.entry_count * sizeof(TriggerManifestEntry))) {
+    throw TriggerManifestProblem(ERS_HERE, manifest_path, "the entries are truncated or corrupted");
+  }
+  for (size_t i = first; i < entries.size(); ++i) {
+    if (entries[i].file_id >= local_to_global.size()) {
+      throw TriggerManifestProblem(ERS_HERE, manifest_path, "the entries are truncated or corrupted");
+    }
+    entries[i].file_id = local_to_global[entries[i].file_id];
+  }
+}
+
+} // namespace
+
+TriggerManifestWriter::TriggerManifestWriter(const std::string& journal_path, size_t flush_entries)
+  : m_journal_path(journal_path)
+  , m_journal(journal_path, std::ios::binary | std::ios::trunc)
+  , m_flush_entries(std::max<size_t>(flush_entries, 1))
+{
+  if (!m_journal) {
+    throw TriggerManifestProblem(ERS_HERE, m_journal_path, "the journal could not be created");
+  }
+  m_pending.reserve(m_flush_entries);
+}
+
+TriggerManifestWriter::~TriggerManifestWriter()
+{
+  try {
+    flush();
+  } catch (TriggerManifestProblem const& excpt) {
+    ers::warning(excpt);
+  }
+}
+
+void
+TriggerManifestWriter::add_file(const std::string& file_name)
+{
+  flush();
+  write_frame(s_file_frame, file_name.data(), file_name.size());
+  ++m_file_count;
+}
+
+void
+TriggerManifestWriter::add_entry(uint64_t trigger_number, // NOLINT(build/unsigned)
+                                 uint32_t sequence_number, // NOLINT(build/unsigned)
+                                 uint64_t offset)          // NOLINT(build/unsigned)
+{
+  if (m_file_count == 0) {
+    throw TriggerManifestProblem(ERS_HERE, m_journal_path, "an entry was added before any file");
+  }
+  m_pending.push_back(TriggerManifestEntry{ trigger_number, sequence_number, m_file_count - 1, offset });
+  if (m_pending.size() >= m_flush_entries) {
+    flush();
+  }
+}
+
+void
+TriggerManifestWriter::flush()
+{
+  if (!m_pending.empty()) {
+    write_frame(s_entries_frame, m_pending.data(), m_pending.size() * sizeof(TriggerManifestEntry));
+    m_pending.clear();
+  }
+  m_journal.flush();
+  if (!m_journal) {
+    throw TriggerManifestProblem(ERS_HERE, m_journal_path, "the journal could not be written");
+  }
+}
+
+void
+TriggerManifestWriter::write_frame(uint32_t kind, const void* payload, size_t size) // NOLINT(build/unsigned)
+{
+  uint32_t frame[2] = { kind, static_cast<uint32_t>(size) }; // NOLINT(build/unsigned)
+  m_journal.write(reinterpret_cast<const char*>(frame), sizeof(frame));
+  m_journal.write(static_cast<const char*>(payload), size);
+  if (!m_journal) {
+    throw TriggerManifestProblem(ERS_HERE, m_journal_path, "the journal could not be written");
+  }
+}
+
+size_t
+TriggerManifest::merge(const std::vector<std::string>& journal_paths, const std::string& manifest_path)
+{
+  // the writers of a run merge in turn, each one adding its journal to the manifest and deleting it
+  auto directory = std::filesystem::path(manifest_path).parent_path();
+  int lock_fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (lock_fd >= 0) {
+    flock(lock_fd, LOCK_EX);
+  }
+
+  try {
+    std::map<std::string, uint32_t> file_ids; // NOLINT(build/unsigned)
+    std::vector<std::string> file_names;
+    std::vector<TriggerManifestEntry> entries;
+    if (std::filesystem::exists(manifest_path)) {
+      read_manifest(manifest_path, file_ids, file_names, entries);
+    }
+    for (const auto& journal_path : journal_paths) {
+      read_journal(journal_path, file_ids, file_names, entries);
+    }
+    std::stable_sort(entries.begin(), entries.end());
+    // a journal that was merged, but not deleted before a crash, is in the manifest already
+    entries.erase(std::unique(entries.begin(),
+                              entries.end(),
+                              [](const TriggerManifestEntry& a, const TriggerManifestEntry& b) {
+                                return a.trigger_number == b.trigger_number &&
+                                       a.sequence_number == b.sequence_number && a.file_id == b.file_id &&
+                                       a.offset == b.offset;
+                              }),
+                  entries.end());
+
+    ManifestHeader header;
+    std::memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.file_count = file_names.size();
+    header.reserved = 0;
+    header.entry_count = entries.size();
+    header.entries_offset = sizeof(header);
+    for (const auto& name : file_names) {
+      header.entries_offset += sizeof(uint32_t) + name.size(); // NOLINT(build/unsigned)
+    }
+
+    std::string temp_path = manifest_path + ".writing";
+    {
+      std::ofstream manifest(temp_path, std::ios::binary | std::ios::trunc);
+      manifest.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      for (const auto& name : file_names) {
+        uint32_t length = name.size(); // NOLINT(build/unsigned)
+        manifest.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        manifest.write(name.data(), name.size());
+      }
+      manifest.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TriggerManifestEntry));
+      manifest.close();
+      if (manifest.fail()) {
+        std::error_code remove_ec;
+        std::filesystem::remove(temp_path, remove_ec);
+        throw TriggerManifestProblem(ERS_HERE, manifest_path, "the manifest could not be written");
+      }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, manifest_path, ec);
+    if (ec) {
+      throw TriggerManifestProblem(ERS_HERE, manifest_path, "the manifest could not be renamed: " + ec.message());
+    }
+    for (const auto& journal_path : journal_paths) {
+      std::filesystem::remove(journal_path, ec);
+    }
+
+    if (lock_fd >= 0) {
+      close(lock_fd);
+    }
+    return entries.size();
+  } catch (...) { // NOLINT(runtime/exceptions)
+    // NOLINT here because we *ARE* re-throwing the exception!
+    if (lock_fd >= 0) {
+      close(lock_fd);
+    }
+    throw;
+  }
+}
+
+TriggerManifest::TriggerManifest(const std::string& manifest_path)
+  : m_path(manifest_path)
+{
+  m_fd = open(m_path.c_str(), O_RDONLY);
+  if (m_fd < 0) {
+    throw TriggerManifestProblem(ERS_HERE, m_path, std::strerror(errno));
+  }
+
+  ManifestHeader header;
+  if (pread(m_fd, &header, sizeof(header), 0) != sizeof(header) ||
+      std::memcmp(header.magic, s_magic, sizeof(s_magic)) != 0 || header.entries_offset < sizeof(header)) {
+    close(m_fd);
+    throw TriggerManifestProblem(ERS_HERE, m_path, "not a trigger manifest");
+  }
+
+  std::vector<char> table(header.entries_offset - sizeof(header));
+  if (pread(m_fd, table.data(), table.size(), sizeof(header)) != static_cast<ssize_t>(table.size())) {
+    close(m_fd);
+    throw TriggerManifestProblem(ERS_HERE, m_path, "the file table is truncated");
+  }
+  size_t position = 0;
+  for (uint32_t i = 0; i < header.file_count; ++i) { // NOLINT(build/unsigned)
+    uint32_t length;                                  // NOLINT(build/unsigned)
+    if (position + sizeof(length) > table.size()) {
+      break;
+    }
+    std::memcpy(&length, &table[position], sizeof(length));
+    position += sizeof(length);
+    if (position + length > table.size()) {
+      break;
+    }
+    m_file_names.emplace_back(&table[position], length);
+    position += length;
+  }
+  if (m_file_names.size() != header.file_count) {
+    close(m_fd);
+    throw TriggerManifestProblem(ERS_HERE, m_path, "the file table is corrupted");
+  }
+
+  m_entry_count = header.entry_count;
+  m_entries_offset = header.entries_offset;
+}
+
+TriggerManifest::~TriggerManifest()
+{
+  close(m_fd);
+}
+
+TriggerManifestEntry
+TriggerManifest::read_entry(size_t index) const
+{
+  TriggerManifestEntry entry;
+  auto position = m_entries_offset + index * sizeof(TriggerManifestEntry);
+  if (pread(m_fd, &entry, sizeof(entry), position) != sizeof(entry) || entry.file_id >= m_file_names.size()) {
+    throw TriggerManifestProblem(ERS_HERE, m_path, "the entries are truncated or corrupted");
+  }
+  return entry;
+}
+
+std::vector<TriggerManifest::Location>
+TriggerManifest::find(uint64_t trigger_number) const // NOLINT(build/unsigned)
+{
+  // lower bound of the first sequence of the trigger
+  size_t first = 0, count = m_entry_count;
+  while (count > 0) {
+    size_t step = count / 2;
+    if (read_entry(first + step).trigger_number < trigger_number) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+
+  std::vector<Location> locations;
+  for (size_t i = first; i < m_entry_count; ++i) {
+    auto entry = read_entry(i);
+    if (entry.trigger_number != trigger_number) {
+      break;
+    }
+    locations.push_back(Location{ m_file_names[entry.file_id], entry.sequence_number, entry.offset });
+  }
+  return locations;
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
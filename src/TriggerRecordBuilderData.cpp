@@ -37,13 +37,18 @@ TriggerRecordBuilderData::TriggerRecordBuilderData(std::string connection_name,
 
 TriggerRecordBuilderData::TriggerRecordBuilderData(std::string connection_name,
                                                    size_t busy_threshold,
-                                                   size_t free_threshold)
+                                                   size_t free_threshold,
+                                                   const std::string& lock_owner)
   : m_busy_threshold(busy_threshold)
   , m_free_threshold(busy_threshold)
   , m_is_busy(false)
   , m_in_error(false)
   , m_connection_name(connection_name)
+  , m_lock_owner(lock_owner)
 {
+  m_assigned_trigger_decisions_mutex.set_owner(m_lock_owner);
+  m_latency_info_mutex.set_owner(m_lock_owner);
+
   if (busy_threshold < free_threshold)
     throw dfmodules::DFOThresholdsNotConsistent(ERS_HERE, busy_threshold, free_threshold);
 }
@@ -54,12 +59,19 @@ TriggerRecordBuilderData::TriggerRecordBuilderData(TriggerRecordBuilderData&& ot
   m_free_threshold = other.m_free_threshold.load();
   m_is_busy = other.m_is_busy.load();
   m_connection_name = std::move(other.m_connection_name);
+  m_lock_owner = other.m_lock_owner;
+  m_assigned_trigger_decisions_mutex.set_owner(m_lock_owner);
+  m_latency_info_mutex.set_owner(m_lock_owner);
 
   m_assigned_trigger_decisions = std::move(other.m_assigned_trigger_decisions);
+  m_assignment_pool = std::move(other.m_assignment_pool);
+  m_next_pool_entry = other.m_next_pool_entry;
 
   m_latency_info = std::move(other.m_latency_info);
+  m_latency_info_next = other.m_latency_info_next;
+  m_latency_info_count = other.m_latency_info_count;
 
-  m_metadata = std::move(other.m_metadata);
+  m_metadata = other.m_metadata;
   m_in_error = other.m_in_error.load();
 
   m_complete_counter = other.m_complete_counter.load();
@@ -73,12 +85,21 @@ TriggerRecordBuilderData::operator=(TriggerRecordBuilderData&& other)
   m_free_threshold = other.m_free_threshold.load();
   m_is_busy = other.m_is_busy.load();
   m_connection_name = std::move(other.m_connection_name);
+  if (m_lock_owner != other.m_lock_owner) {
+    m_lock_owner = other.m_lock_owner;
+    m_assigned_trigger_decisions_mutex.set_owner(m_lock_owner);
+    m_latency_info_mutex.set_owner(m_lock_owner);
+  }
 
   m_assigned_trigger_decisions = std::move(other.m_assigned_trigger_decisions);
+  m_assignment_pool = std::move(other.m_assignment_pool);
+  m_next_pool_entry = other.m_next_pool_entry;
 
   m_latency_info = std::move(other.m_latency_info);
+  m_latency_info_next = other.m_latency_info_next;
+  m_latency_info_count = other.m_latency_info_count;
 
-  m_metadata = std::move(other.m_metadata);
+  m_metadata = other.m_metadata;
   m_in_error = other.m_in_error.load();
 
   m_complete_counter = other.m_complete_counter.load();
@@ -91,7 +112,8 @@ std::shared_ptr<AssignedTriggerDecision>
 TriggerRecordBuilderData::extract_assignment(daqdataformats::trigger_number_t trigger_number)
 {
   std::shared_ptr<AssignedTriggerDecision> dec_ptr;
-  auto lk = std::lock_guard<std::mutex>(m_assigned_trigger_decisions_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
+  // the decisions are usually completed in the order they were assigned, so the search is short
   for (auto it = m_assigned_trigger_decisions.begin(); it != m_assigned_trigger_decisions.end(); ++it) {
     if ((*it)->decision.trigger_number == trigger_number) {
       dec_ptr = *it;
@@ -109,8 +131,8 @@ TriggerRecordBuilderData::extract_assignment(daqdataformats::trigger_number_t tr
 std::shared_ptr<AssignedTriggerDecision>
 TriggerRecordBuilderData::get_assignment(daqdataformats::trigger_number_t trigger_number) const
 {
-  auto lk = std::lock_guard<std::mutex>(m_assigned_trigger_decisions_mutex);
-  for (auto ptr : m_assigned_trigger_decisions) {
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
+  for (const auto& ptr : m_assigned_trigger_decisions) {
     if (ptr->decision.trigger_number == trigger_number) {
       return ptr;
     }
@@ -121,7 +143,7 @@ TriggerRecordBuilderData::get_assignment(daqdataformats::trigger_number_t trigge
 
 std::shared_ptr<AssignedTriggerDecision>
 TriggerRecordBuilderData::complete_assignment(daqdataformats::trigger_number_t trigger_number,
-                                              std::function<void(nlohmann::json&)> metadata_fun)
+                                              metadata_function_t metadata_fun)
 {
 
   auto dec_ptr = extract_assignment(trigger_number);
@@ -132,16 +154,21 @@ TriggerRecordBuilderData::complete_assignment(daqdataformats::trigger_number_t t
   auto now = std::chrono::steady_clock::now();
   auto time = std::chrono::duration_cast<std::chrono::microseconds>(now - dec_ptr->assigned_time);
   {
-    auto lk = std::lock_guard<std::mutex>(m_latency_info_mutex);
-    m_latency_info.emplace_back(now, time);
-
-    if (m_latency_info.size() > 1000)
-      m_latency_info.pop_front();
+    auto lk = std::lock_guard<InstrumentedMutex>(m_latency_info_mutex);
+    if (m_latency_info.size() < s_latency_info_size)
+      m_latency_info.resize(s_latency_info_size);
+    m_latency_info[m_latency_info_next] = std::make_pair(now, time);
+    m_latency_info_next = (m_latency_info_next + 1) % s_latency_info_size;
+    if (m_latency_info_count < s_latency_info_size)
+      ++m_latency_info_count;
+
+    m_metadata.last_completed_trigger_number = trigger_number;
+    m_metadata.last_completion_time = time;
+    ++m_metadata.completed_trigger_decisions;
+    if (metadata_fun)
+      metadata_fun(m_metadata, *dec_ptr);
   }
 
-  if (metadata_fun)
-    metadata_fun(m_metadata);
-
   ++m_complete_counter;
   auto completion_time =
     std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - dec_ptr->assigned_time);
@@ -158,39 +185,71 @@ std::list<std::shared_ptr<AssignedTriggerDecision>>
 TriggerRecordBuilderData::flush()
 {
 
-  auto lk = std::lock_guard<std::mutex>(m_assigned_trigger_decisions_mutex);
-  std::list<std::shared_ptr<AssignedTriggerDecision>> ret;
-
-  for (const auto& td : m_assigned_trigger_decisions) {
-    ret.push_back(td);
-  }
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
+  std::list<std::shared_ptr<AssignedTriggerDecision>> ret(m_assigned_trigger_decisions.begin(),
+                                                          m_assigned_trigger_decisions.end());
   m_assigned_trigger_decisions.clear();
 
-  auto stat_lock = std::lock_guard<std::mutex>(m_latency_info_mutex);
-  m_latency_info.clear();
+  auto stat_lock = std::lock_guard<InstrumentedMutex>(m_latency_info_mutex);
+  m_latency_info_next = 0;
+  m_latency_info_count = 0;
   m_is_busy = false;
 
   m_in_error = false;
-  m_metadata = nlohmann::json();
+  m_metadata = TriggerRecordBuilderMetadata();
 
   return ret;
 }
 
 std::shared_ptr<AssignedTriggerDecision>
-TriggerRecordBuilderData::make_assignment(dfmessages::TriggerDecision decision)
+TriggerRecordBuilderData::acquire_assignment()
 {
-  return std::make_shared<AssignedTriggerDecision>(decision, m_connection_name);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
+
+  // the assignments are released roughly in the order they were made, so the one after
+  // the last one handed out is usually free
+  for (size_t i = 0; i < m_assignment_pool.size(); ++i) {
+    auto& candidate = m_assignment_pool[m_next_pool_entry];
+    m_next_pool_entry = (m_next_pool_entry + 1) % m_assignment_pool.size();
+    if (candidate.use_count() == 1) {
+      // pairs with the release of the last other reference, so that its accesses are complete
+      std::atomic_thread_fence(std::memory_order_acquire);
+      candidate->assigned_time = std::chrono::steady_clock::now();
+      return candidate;
+    }
+  }
+
+  m_assignment_pool.push_back(
+    std::make_shared<AssignedTriggerDecision>(dfmessages::TriggerDecision(), m_connection_name));
+  m_next_pool_entry = 0;
+  return m_assignment_pool.back();
+}
+
+std::shared_ptr<AssignedTriggerDecision>
+TriggerRecordBuilderData::make_assignment(dfmessages::TriggerDecision&& decision)
+{
+  auto assignment = acquire_assignment();
+  assignment->decision = std::move(decision);
+  return assignment;
+}
+
+std::shared_ptr<AssignedTriggerDecision>
+TriggerRecordBuilderData::make_assignment(const dfmessages::TriggerDecision& decision)
+{
+  auto assignment = acquire_assignment();
+  assignment->decision = decision;
+  return assignment;
 }
 
 void
 TriggerRecordBuilderData::add_assignment(std::shared_ptr<AssignedTriggerDecision> assignment)
 {
-  auto lk = std::lock_guard<std::mutex>(m_assigned_trigger_decisions_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
 
   if (is_in_error())
     throw NoSlotsAvailable(ERS_HERE, assignment->decision.trigger_number, m_connection_name);
 
-  m_assigned_trigger_decisions.push_back(assignment);
+  m_assigned_trigger_decisions.push_back(std::move(assignment));
   TLOG_DEBUG(13) << "Size of assigned_trigger_decision list is " << m_assigned_trigger_decisions.size();
 
   if (m_assigned_trigger_decisions.size() >= m_busy_threshold.load()) {
@@ -214,7 +273,7 @@ TriggerRecordBuilderData::get_info(opmonlib::InfoCollector& ci, int /*level*/)
   info.max_time_since_assignment = 0;
   info.total_time_since_assignment = 0;
 
-  auto lk = std::lock_guard<std::mutex>(m_assigned_trigger_decisions_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
 
   info.outstanding_decisions = m_assigned_trigger_decisions.size();
   auto current_time = std::chrono::steady_clock::now();
@@ -234,19 +293,34 @@ TriggerRecordBuilderData::get_info(opmonlib::InfoCollector& ci, int /*level*/)
 std::chrono::microseconds
 TriggerRecordBuilderData::average_latency(std::chrono::steady_clock::time_point since) const
 {
-  auto lk = std::lock_guard<std::mutex>(m_latency_info_mutex);
+  auto lk = std::lock_guard<InstrumentedMutex>(m_latency_info_mutex);
   std::chrono::microseconds sum = std::chrono::microseconds(0);
   size_t count = 0;
-  for (auto it = m_latency_info.rbegin(); it != m_latency_info.rend(); ++it) {
-    if (it->first < since)
+  for (size_t i = 1; i <= m_latency_info_count; ++i) {
+    const auto& entry = m_latency_info[(m_latency_info_next + s_latency_info_size - i) % s_latency_info_size];
+    if (entry.first < since)
       break;
 
     count++;
-    sum += it->second;
+    sum += entry.second;
   }
 
   return sum / count;
 }
 
+TriggerRecordBuilderMetadata
+TriggerRecordBuilderData::get_metadata() const
+{
+  auto lk = std::lock_guard<InstrumentedMutex>(m_latency_info_mutex);
+  return m_metadata;
+}
+
+size_t
+TriggerRecordBuilderData::pool_size() const
+{
+  auto lk = std::lock_guard<InstrumentedMutex>(m_assigned_trigger_decisions_mutex);
+  return m_assignment_pool.size();
+}
+
 } // namespace dfmodules
 } // namespace dunedaq
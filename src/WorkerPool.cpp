@@ -0,0 +1,75 @@
+/**
+ * @file WorkerPool.cpp WorkerPool class implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/WorkerPool.hpp"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace dunedaq {
+namespace dfmodules {
+
+WorkerPool::WorkerPool(size_t thread_count, const std::string& name)
+{
+  thread_count = std::max<size_t>(thread_count, 1);
+  for (size_t i = 0; i < thread_count; ++i) {
+    m_threads.emplace_back(&WorkerPool::run, this);
+    // thread names are limited to 15 characters
+    std::string thread_name = name.substr(0, 12) + "-" + std::to_string(i);
+    pthread_setname_np(m_threads.back().native_handle(), thread_name.substr(0, 15).c_str());
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stopping = true;
+  }
+  m_cv.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+std::future<void>
+WorkerPool::submit(std::function<void()> task)
+{
+  std::packaged_task<void()> packaged_task(std::move(task));
+  auto future = packaged_task.get_future();
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_tasks.push_back(std::move(packaged_task));
+  }
+  m_cv.notify_one();
+  return future;
+}
+
+void
+WorkerPool::run()
+{
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_cv.wait(lk, [&]() { return m_stopping || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+} // namespace dfmodules
+} // namespace dunedaq
@@ -0,0 +1,50 @@
+/**
+ * @file CRC32C.hpp CRC32C checksum
+ *
+ * CRC32C (Castagnoli) checksum of a block of memory, computed with the CRC32
+ * instructions of the CPU when they are available, and with a table-driven
+ * software implementation otherwise.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_CRC32C_HPP_
+#define DFMODULES_SRC_DFMODULES_CRC32C_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief CRC32C checksum functions
+ *
+ * The checksums can be computed incrementally: the checksum of the concatenation
+ * of two blocks is compute(second, size2, compute(first, size1)).
+ */
+class CRC32C
+{
+public:
+  /**
+   * @brief Compute the checksum of a block, continuing from the checksum of the previous blocks
+   */
+  static uint32_t compute(const void* data, size_t size, uint32_t previous_crc = 0);
+
+  /**
+   * @brief Compute the checksum of a block with the software implementation
+   */
+  static uint32_t compute_software(const void* data, size_t size, uint32_t previous_crc = 0);
+
+  /**
+   * @brief Whether compute() uses the CRC32 instructions of the CPU
+   */
+  static bool has_hardware_support();
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_CRC32C_HPP_
@@ -78,6 +78,17 @@ ERS_DECLARE_ISSUE(dfmodules,            ///< Namespace
                   ((daqdataformats::sequence_number_t)seqno) ///< Message parameters
 )
 
+/**
+ * @brief Sender lookup failed during the warm-up at start
+ */
+ERS_DECLARE_ISSUE(dfmodules,              ///< Namespace
+                  ConnectionWarmUpFailed, ///< Issue class name
+                  "Unable to resolve the sender for connection \"" << conn_name << "\" (uid " << uid
+                  << ") at start. It will be looked up again when it is first used.",
+                  ((std::string)conn_name) ///< Message parameters
+                  ((std::string)uid)       ///< Message parameters
+)
+
 /**
  * @brief Invalid System Type
  */
@@ -0,0 +1,113 @@
+/**
+ * @file FileCacheController.hpp FileCacheController Class
+ *
+ * The FileCacheController class manages the disk space and the page cache of an
+ * output file that is written by someone else (e.g. the HDF5 library): it reserves
+ * the disk space of the file up front, starts the writeback of the data as the file
+ * grows, and drops the written data from the page cache.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_FILECACHECONTROLLER_HPP_
+#define DFMODULES_SRC_DFMODULES_FILECACHECONTROLLER_HPP_
+
+#include "dfmodules/filecache/Structs.hpp"
+
+#include "ers/Issue.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief A disk space or page cache operation failed on an output file
+ */
+ERS_DECLARE_ISSUE(dfmodules,               ///< Namespace
+                  FileCacheControlProblem, ///< Issue class name
+                  "Unable to " << operation << " for file " << file_name << ": " << reason,
+                  ((std::string)file_name) ///< Message parameters
+                  ((std::string)operation) ///< Message parameters
+                  ((std::string)reason)    ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief FileCacheController manages the disk space and page cache of one open file at a time.
+ *
+ * The controller uses its own file descriptor, so it works alongside any library
+ * writing the file, and follows the file if it is renamed before close() is called.
+ * - With preallocation, the expected size is reserved without changing the size of
+ *   the file, so that the file system can allocate large contiguous extents, and the
+ *   reservation beyond the real size is released when the file is closed.
+ * - With write-behind, the writeback of each window of write_behind_bytes is started
+ *   as soon as the window is complete, and waited for one window later, which keeps
+ *   the amount of dirty data bounded; with drop_cache, those windows are then dropped
+ *   from the page cache, and the whole file is flushed and dropped when it is closed.
+ * The operations that fail are reported with a FileCacheControlProblem warning and
+ * are not tried again on the same file; they never prevent the file from being written.
+ */
+class FileCacheController
+{
+public:
+  FileCacheController() = default;
+  explicit FileCacheController(const filecache::FileCacheControl& conf);
+  ~FileCacheController();
+
+  FileCacheController(const FileCacheController&) = delete;            ///< Not copy-constructible
+  FileCacheController& operator=(const FileCacheController&) = delete; ///< Not copy-assignable
+  FileCacheController(FileCacheController&&) = delete;                 ///< Not move-constructible
+  FileCacheController& operator=(FileCacheController&&) = delete;      ///< Not move-assignable
+
+  /**
+   * @brief Whether the controller has nothing to do, in which case files don't need to be opened
+   */
+  bool is_disabled() const { return !m_preallocate && m_write_behind_bytes == 0 && !m_drop_cache; }
+
+  /**
+   * @brief Start managing an existing file, closing the previous one if needed
+   * @param expected_size Size to reserve when preallocation_size_bytes is 0. 0 means no preallocation
+   */
+  void open(const std::string& file_name, size_t expected_size);
+
+  /**
+   * @brief Start or wait for the writeback of the data written since the last call
+   */
+  void update();
+
+  /**
+   * @brief Stop managing the file; to be called once the writer has closed it
+   */
+  void close();
+
+  bool is_open() const { return m_fd >= 0; }
+  size_t get_preallocated_bytes() const { return m_preallocated_bytes; }
+  size_t get_written_back_bytes() const { return m_written_back_offset; }
+
+private:
+  void report_problem(const std::string& operation, int error_number);
+
+  // Configuration
+  bool m_preallocate{ false };
+  size_t m_preallocation_size{ 0 };
+  size_t m_write_behind_bytes{ 0 };
+  bool m_drop_cache{ false };
+
+  // Current file
+  int m_fd{ -1 };
+  std::string m_file_name;
+  size_t m_preallocated_bytes{ 0 };
+  bool m_write_behind_failed{ false };
+  size_t m_write_started_offset{ 0 };
+  size_t m_written_back_offset{ 0 };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_FILECACHECONTROLLER_HPP_
@@ -0,0 +1,150 @@
+/**
+ * @file FlightRecorder.hpp FlightRecorder Class
+ *
+ * The FlightRecorder class samples a few gauges of a module at high frequency
+ * into a fixed-size in-memory history, and writes that history to a file when
+ * an anomaly is signalled, so that the sub-second behaviour of the module
+ * around the anomaly can be inspected after the fact.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_FLIGHTRECORDER_HPP_
+#define DFMODULES_SRC_DFMODULES_FLIGHTRECORDER_HPP_
+
+#include "dfmodules/flightrecorder/Structs.hpp"
+
+#include "daqdataformats/Types.hpp"
+#include "ers/Issue.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief The history of a flight recorder has been written to a file
+ */
+ERS_DECLARE_ISSUE(dfmodules,            ///< Namespace
+                  FlightRecorderDumped, ///< Issue class name
+                  "The flight recorder of " << owner << " dumped " << samples << " samples to " << file_name
+                                            << " after " << reason,
+                  ((std::string)owner)     ///< Message parameters
+                  ((size_t)samples)        ///< Message parameters
+                  ((std::string)file_name) ///< Message parameters
+                  ((std::string)reason)    ///< Message parameters
+)
+
+/**
+ * @brief The history of a flight recorder could not be written
+ */
+ERS_DECLARE_ISSUE(dfmodules,                ///< Namespace
+                  FlightRecorderDumpFailed, ///< Issue class name
+                  "The flight recorder of " << owner << " could not write " << file_name << ": " << reason,
+                  ((std::string)owner)     ///< Message parameters
+                  ((std::string)file_name) ///< Message parameters
+                  ((std::string)reason)    ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief FlightRecorder keeps the recent history of a set of gauges.
+ *
+ * The gauges are functions returning an integer, registered before the recorder
+ * is started; they are called from the recorder's own sampling thread, so they must
+ * only read values that are safe to access concurrently (typically atomics).
+ * The history is a ring that is written and dumped only by the sampling thread,
+ * which makes request_dump() the only call made from the dataflow threads: it
+ * costs a couple of atomic operations, allocates and locks nothing, and can be
+ * called on every occurrence of an anomaly. The dump is written once post_anomaly_ms have elapsed, and at most
+ * once every min_dump_interval_ms. Nothing is sampled when the recorder is disabled.
+ */
+class FlightRecorder
+{
+public:
+  using gauge_t = std::function<int64_t()>;
+  using clock_type = std::chrono::steady_clock;
+
+  explicit FlightRecorder(std::string owner_name);
+  ~FlightRecorder();
+
+  FlightRecorder(const FlightRecorder&) = delete;            ///< FlightRecorder is not copy-constructible
+  FlightRecorder& operator=(const FlightRecorder&) = delete; ///< FlightRecorder is not copy-assignable
+  FlightRecorder(FlightRecorder&&) = delete;                 ///< FlightRecorder is not move-constructible
+  FlightRecorder& operator=(FlightRecorder&&) = delete;      ///< FlightRecorder is not move-assignable
+
+  /**
+   * @brief Apply a configuration; only allowed while the recorder is stopped
+   */
+  void configure(const flightrecorder::FlightRecorder& conf);
+
+  /**
+   * @brief Register a gauge; only allowed while the recorder is stopped
+   */
+  void add_gauge(const std::string& name, gauge_t gauge);
+
+  void start(daqdataformats::run_number_t run_number);
+  void stop();
+
+  bool is_enabled() const { return m_enabled; }
+
+  /**
+   * @brief Signal an anomaly; the history around it will be dumped unless a dump has been made recently
+   *
+   * @param reason Description of the anomaly, which must outlive the recorder (typically a string literal)
+   */
+  void request_dump(const char* reason);
+
+  size_t get_dump_count() const { return m_dump_count.load(std::memory_order_relaxed); }
+  size_t get_anomaly_count() const { return m_anomaly_count.load(std::memory_order_relaxed); }
+
+private:
+  void do_work(std::atomic<bool>& running_flag);
+  void take_sample(clock_type::time_point now);
+  void dump(const std::string& reason);
+
+  const std::string m_owner_name;
+
+  // Configuration
+  bool m_enabled{ false };
+  std::chrono::milliseconds m_sample_interval{ 10 };
+  std::chrono::milliseconds m_post_anomaly{ 200 };
+  std::chrono::milliseconds m_min_dump_interval{ 30000 };
+  size_t m_capacity{ 0 };
+  std::string m_output_path{ "." };
+  daqdataformats::run_number_t m_run_number{ 0 };
+
+  std::vector<std::string> m_gauge_names;
+  std::vector<gauge_t> m_gauges;
+
+  // History, only accessed by the sampling thread: one row per sample, made of
+  // the sample time, in microseconds since the start, followed by the gauge values
+  std::vector<int64_t> m_history;
+  size_t m_row_size{ 1 };
+  uint64_t m_samples_taken{ 0 }; // NOLINT(build/unsigned)
+  clock_type::time_point m_start_time;
+
+  // Dump requests
+  std::atomic<bool> m_dump_requested{ false };
+  std::atomic<clock_type::rep> m_dump_due_time{ 0 };
+  std::atomic<clock_type::rep> m_next_dump_allowed{ 0 };
+  std::atomic<const char*> m_dump_reason{ "" };
+  std::atomic<size_t> m_anomaly_count{ 0 };
+  std::atomic<size_t> m_dump_count{ 0 };
+
+  dunedaq::utilities::WorkerThread m_thread;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_FLIGHTRECORDER_HPP_
@@ -0,0 +1,86 @@
+/**
+ * @file FragmentChecksums.hpp FragmentChecksums Class
+ *
+ * The FragmentChecksums class computes the CRC32C checksums of the Fragments of a
+ * record on a pool of threads, and stores and reads them as an HDF5 attribute of
+ * the group of the record, so that the integrity of the data between the
+ * TriggerRecordBuilder and the disk can be checked after the fact.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_FRAGMENTCHECKSUMS_HPP_
+#define DFMODULES_SRC_DFMODULES_FRAGMENTCHECKSUMS_HPP_
+
+#include "dfmodules/WorkerPool.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+
+#include "hdf5.h"
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief Checksum of one Fragment, as it is stored in the output files
+ */
+struct FragmentChecksum
+{
+  uint32_t subsystem; // NOLINT(build/unsigned)
+  uint32_t source_id; // NOLINT(build/unsigned)
+  uint32_t crc32c;    // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief FragmentChecksums computes the checksums of the Fragments of one record at a time.
+ *
+ * start() splits the Fragments between the threads of the pool and returns right away,
+ * so that the checksums are computed while the caller writes the record; finish()
+ * waits for them. The checksum of a Fragment covers all its bytes, header included,
+ * which is what is written to the Fragment's dataset. The Fragments must not be
+ * modified or destroyed between the two calls.
+ */
+class FragmentChecksums
+{
+public:
+  using fragments_t = std::vector<std::unique_ptr<daqdataformats::Fragment>>;
+
+  static constexpr const char* s_attribute_name = "fragment_checksums";
+
+  explicit FragmentChecksums(size_t thread_count);
+
+  void start(const fragments_t& fragments);
+  std::vector<FragmentChecksum> finish();
+
+  /**
+   * @brief Store the checksums as an attribute of an HDF5 object (typically the group of the record)
+   * @return An empty string on success, the reason of the failure otherwise
+   */
+  static std::string write_attribute(hid_t object_id, const std::vector<FragmentChecksum>& checksums);
+
+  /**
+   * @brief Read the checksums stored as an attribute of an HDF5 object
+   * @return false if the object has no checksums attribute, or if it could not be read
+   */
+  static bool read_attribute(hid_t object_id, std::vector<FragmentChecksum>& checksums);
+
+private:
+  static hid_t create_h5_type();
+
+  WorkerPool m_pool;
+  std::vector<FragmentChecksum> m_checksums;
+  std::vector<std::future<void>> m_futures;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_FRAGMENTCHECKSUMS_HPP_
@@ -0,0 +1,128 @@
+/**
+ * @file FragmentLatencyTracker.hpp FragmentLatencyTracker Class
+ *
+ * The FragmentLatencyTracker class learns online the distribution of the time
+ * it takes for the fragments of each SourceID to arrive after their data request,
+ * and derives from it the timeout of a trigger record given its components.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_FRAGMENTLATENCYTRACKER_HPP_
+#define DFMODULES_SRC_DFMODULES_FRAGMENTLATENCYTRACKER_HPP_
+
+#include "dfmodules/adaptivetimeout/Structs.hpp"
+
+#include "daqdataformats/ComponentRequest.hpp"
+#include "daqdataformats/SourceID.hpp"
+#include "ers/Issue.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief The configuration of the adaptive timeouts is inconsistent
+ */
+ERS_DECLARE_ISSUE(dfmodules,              ///< Namespace
+                  InvalidAdaptiveTimeout, ///< Issue class name
+                  "Invalid adaptive timeout configuration: " << reason,
+                  ((std::string)reason) ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief FragmentLatencyTracker keeps a histogram of the fragment latencies of each SourceID.
+ *
+ * The histograms have four logarithmic bins per power of two of microseconds, so a
+ * quantile is known within 19%, which the safety factor is expected to absorb. The
+ * weight of the older latencies is halved every history_samples fragments of a SourceID,
+ * so that the estimates follow the changes of the readout conditions. The quantile of each
+ * SourceID is recomputed every few samples and cached, so that get_timeout() only costs a
+ * lookup per component. The tracker is meant to be used from a single thread.
+ */
+class FragmentLatencyTracker
+{
+public:
+  using duration_type = std::chrono::microseconds;
+
+  /**
+   * @brief Apply the configuration and forget the latencies learned so far
+   * @param conf The adaptive timeout configuration
+   * @param max_timeout The upper bound of the timeouts, also used when latencies are missing
+   * @throws InvalidAdaptiveTimeout if the configuration is inconsistent
+   */
+  void configure(const adaptivetimeout::AdaptiveTimeout& conf, std::chrono::milliseconds max_timeout);
+
+  bool is_enabled() const { return m_enabled; }
+
+  /**
+   * @brief Forget the latencies learned so far
+   */
+  void reset() { m_sources.clear(); }
+
+  /**
+   * @brief Account for a fragment from source_id that arrived latency after its request
+   */
+  void add_sample(const daqdataformats::SourceID& source_id, duration_type latency);
+
+  /**
+   * @brief The configured quantile of the latencies of source_id, if enough of them are known
+   */
+  std::optional<duration_type> get_latency_quantile(const daqdataformats::SourceID& source_id) const;
+
+  /**
+   * @brief Timeout of a trigger record: the latency quantile of its slowest component times the
+   * safety factor, within the bounds. The upper bound is used if any component has too few samples.
+   */
+  duration_type get_timeout(const std::vector<daqdataformats::ComponentRequest>& components) const;
+
+  duration_type get_min_timeout() const { return m_min_timeout; }
+  duration_type get_max_timeout() const { return m_max_timeout; }
+
+private:
+  static constexpr size_t s_bins_per_octave = 4;
+  static constexpr size_t s_octaves = 40;
+  static constexpr size_t s_bin_count = 1 + s_bins_per_octave * s_octaves;
+  static constexpr uint32_t s_refresh_interval = 16; // NOLINT(build/unsigned)
+
+  static size_t bin_of(duration_type latency);
+  static duration_type upper_edge_of(size_t bin);
+
+  struct Histogram
+  {
+    std::array<double, s_bin_count> weights{};
+    double total_weight = 0;
+    uint64_t samples = 0;                // NOLINT(build/unsigned)
+    uint32_t samples_since_decay = 0;    // NOLINT(build/unsigned)
+    uint32_t samples_since_refresh = 0;  // NOLINT(build/unsigned)
+    std::optional<duration_type> quantile;
+  };
+
+  void refresh_quantile(Histogram& histogram) const;
+
+  std::map<daqdataformats::SourceID, Histogram> m_sources;
+
+  bool m_enabled = false;
+  double m_quantile = 0.99;
+  double m_safety_factor = 2.0;
+  uint32_t m_min_samples = 100;       // NOLINT(build/unsigned)
+  uint32_t m_history_samples = 10000; // NOLINT(build/unsigned)
+  duration_type m_min_timeout{ 0 };
+  duration_type m_max_timeout{ 0 };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_FRAGMENTLATENCYTRACKER_HPP_
@@ -0,0 +1,183 @@
+/**
+ * @file InstrumentedMutex.hpp InstrumentedMutex and LockProfiler Classes
+ *
+ * The InstrumentedMutex class is a mutex that, in builds with lock profiling
+ * (DFMODULES_LOCK_PROFILING, set by the CMake option of the same name), records
+ * how often it is acquired, how often it had to be waited for, and how long it
+ * was waited for and held. The statistics are kept per owner (the module that
+ * reports them) and lock name, so that the instances of a class in a module share
+ * theirs, and those of two modules are kept apart; they are reported to opmon by
+ * the LockProfiler. Without lock profiling, it is a plain std::mutex.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_INSTRUMENTEDMUTEX_HPP_
+#define DFMODULES_SRC_DFMODULES_INSTRUMENTEDMUTEX_HPP_
+
+#include "opmonlib/InfoCollector.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief Statistics of the acquisitions of the locks of a given owner and name
+ *
+ * The wait and hold times are histogrammed in powers of two of nanoseconds, and the
+ * quantiles reported to opmon are the upper edges of their bins.
+ */
+class LockStats
+{
+public:
+  static constexpr size_t s_bin_count = 40; ///< Up to about 9 minutes
+
+  void record_acquisition(bool contended, uint64_t wait_ns); // NOLINT(build/unsigned)
+  void record_release(uint64_t hold_ns);                     // NOLINT(build/unsigned)
+
+  /**
+   * @brief Adds the statistics since the last call, and resets them
+   */
+  void get_info(opmonlib::InfoCollector& ci);
+
+  uint64_t get_acquisitions() const { return m_acquisitions.load(std::memory_order_relaxed); } // NOLINT
+  uint64_t get_contended() const { return m_contended.load(std::memory_order_relaxed); }       // NOLINT
+
+private:
+  using histogram_t = std::array<std::atomic<uint64_t>, s_bin_count>; // NOLINT(build/unsigned)
+
+  static size_t bin_of(uint64_t ns); // NOLINT(build/unsigned)
+
+  std::atomic<uint64_t> m_acquisitions{ 0 }; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_contended{ 0 };    // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_wait_ns{ 0 };      // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_hold_ns{ 0 };      // NOLINT(build/unsigned)
+  histogram_t m_wait_histogram{};
+  histogram_t m_hold_histogram{};
+};
+
+/**
+ * @brief LockProfiler keeps the statistics of all the named locks of the process
+ */
+class LockProfiler
+{
+public:
+  /**
+   * @brief The statistics of the locks of owner named name, which live as long as the process.
+   * An empty owner is for the locks that no module reports
+   */
+  static LockStats& get_stats(const std::string& owner, const std::string& name);
+
+  /**
+   * @brief Adds the statistics of the locks of owner, as children named "lock_" followed by
+   * the last part of their name, e.g. "lock_bundle_map" for "TPBundleHandler.bundle_map".
+   * Nothing is added without lock profiling
+   */
+  static void get_info(opmonlib::InfoCollector& ci, const std::string& owner);
+};
+
+#ifdef DFMODULES_LOCK_PROFILING
+
+/**
+ * @brief A mutex that records its contention in the LockStats of its owner and name
+ */
+class InstrumentedMutex
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  /// A lock without owner, until set_owner() is called
+  explicit InstrumentedMutex(const char* name)
+    : InstrumentedMutex(std::string(), name)
+  {}
+
+  InstrumentedMutex(const std::string& owner, const char* name)
+    : m_name(name)
+    , m_stats(&LockProfiler::get_stats(owner, name))
+  {}
+
+  /**
+   * @brief Count the next acquisitions for owner; only while the lock is not in use
+   */
+  void set_owner(const std::string& owner) { m_stats = &LockProfiler::get_stats(owner, m_name); }
+
+  InstrumentedMutex(const InstrumentedMutex&) = delete;            ///< Not copy-constructible
+  InstrumentedMutex& operator=(const InstrumentedMutex&) = delete; ///< Not copy-assignable
+
+  void lock()
+  {
+    if (m_mutex.try_lock()) {
+      m_locked_at = clock_type::now();
+      m_stats->record_acquisition(false, 0);
+      return;
+    }
+    auto start = clock_type::now();
+    m_mutex.lock();
+    m_locked_at = clock_type::now();
+    auto waited = m_locked_at - start;
+    m_stats->record_acquisition(true, std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+  }
+
+  bool try_lock()
+  {
+    if (!m_mutex.try_lock()) {
+      return false;
+    }
+    m_locked_at = clock_type::now();
+    m_stats->record_acquisition(false, 0);
+    return true;
+  }
+
+  void unlock()
+  {
+    auto held = clock_type::now() - m_locked_at;
+    m_mutex.unlock();
+    m_stats->record_release(std::chrono::duration_cast<std::chrono::nanoseconds>(held).count());
+  }
+
+private:
+  std::mutex m_mutex;
+  const char* m_name;
+  LockStats* m_stats;
+  clock_type::time_point m_locked_at; ///< Only accessed by the thread holding the lock
+};
+
+#else
+
+/**
+ * @brief Without lock profiling, the owner and name are ignored and the mutex is a std::mutex
+ */
+class InstrumentedMutex
+{
+public:
+  explicit InstrumentedMutex(const char* /*name*/) {}
+  InstrumentedMutex(const std::string& /*owner*/, const char* /*name*/) {}
+
+  void set_owner(const std::string& /*owner*/) {}
+
+  InstrumentedMutex(const InstrumentedMutex&) = delete;            ///< Not copy-constructible
+  InstrumentedMutex& operator=(const InstrumentedMutex&) = delete; ///< Not copy-assignable
+
+  void lock() { m_mutex.lock(); }
+  bool try_lock() { return m_mutex.try_lock(); }
+  void unlock() { m_mutex.unlock(); }
+
+private:
+  std::mutex m_mutex;
+};
+
+#endif // DFMODULES_LOCK_PROFILING
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_INSTRUMENTEDMUTEX_HPP_
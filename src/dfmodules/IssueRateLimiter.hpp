@@ -0,0 +1,126 @@
+/**
+ * @file IssueRateLimiter.hpp IssueRateLimiter Class
+ *
+ * The IssueRateLimiter class decides whether an occurrence of a frequently-reported
+ * ERS issue should be reported in full, or counted and folded into a periodic summary.
+ * It is meant to protect the dataflow hot paths from issue storms under fault conditions.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_ISSUERATELIMITER_HPP_
+#define DFMODULES_SRC_DFMODULES_ISSUERATELIMITER_HPP_
+
+#include "ers/Issue.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief Summary of the occurrences of an issue that were not reported individually
+ */
+ERS_DECLARE_ISSUE(dfmodules,               ///< Namespace
+                  SuppressedIssuesSummary, ///< Issue class name
+                  count << " further occurrences of " << issue_name << " were not reported individually in the last "
+                        << interval_ms << " ms (sample IDs: " << samples << ")",
+                  ((std::string)issue_name) ///< Message parameters
+                  ((uint64_t)count)         ///< Message parameters
+                  ((int64_t)interval_ms)    ///< Message parameters
+                  ((std::string)samples)    ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief IssueRateLimiter lets the first N occurrences of an issue in each summary interval
+ * through, and collects counts and a few sample IDs (e.g. trigger numbers) of the others.
+ *
+ * Callers keep constructing and reporting the issue themselves, but only when should_report()
+ * returns true, so that suppressed occurrences cost a few atomic operations and no string
+ * formatting. The summary of the suppressed occurrences is reported when the interval has
+ * elapsed, either from the next call to should_report() or from check_summary(), which is
+ * cheap enough to be called from get_info().
+ */
+class IssueRateLimiter
+{
+public:
+  enum class Severity
+  {
+    kWarning,
+    kError
+  };
+
+  static constexpr size_t s_max_samples = 8;
+
+  /**
+   * @param issue_name Name of the limited issue, used in the summaries
+   * @param max_full_reports Occurrences reported in full in each interval; 0 disables the limiting
+   * @param summary_interval Length of the interval after which suppressed occurrences are summarized
+   * @param severity Severity used to report the summaries
+   */
+  explicit IssueRateLimiter(std::string issue_name,
+                            size_t max_full_reports = 10,
+                            std::chrono::milliseconds summary_interval = std::chrono::milliseconds(10000),
+                            Severity severity = Severity::kError);
+
+  IssueRateLimiter(const IssueRateLimiter&) = delete;            ///< IssueRateLimiter is not copy-constructible
+  IssueRateLimiter& operator=(const IssueRateLimiter&) = delete; ///< IssueRateLimiter is not copy-assignable
+  IssueRateLimiter(IssueRateLimiter&&) = delete;                 ///< IssueRateLimiter is not move-constructible
+  IssueRateLimiter& operator=(IssueRateLimiter&&) = delete;      ///< IssueRateLimiter is not move-assignable
+
+  void configure(size_t max_full_reports, std::chrono::milliseconds summary_interval);
+
+  /**
+   * @brief Account for one occurrence of the issue
+   * @param sample_id Identifier of the occurrence, kept as a sample if the occurrence is suppressed
+   * @return true if the caller should report this occurrence in full
+   */
+  bool should_report(uint64_t sample_id);
+
+  /**
+   * @brief Report the summary of the current interval if the interval has elapsed
+   */
+  void check_summary();
+
+  /**
+   * @brief Report the summary of the current interval, if anything was suppressed, and start a new interval
+   */
+  void flush();
+
+  uint64_t get_total_count() const { return m_total_count.load(std::memory_order_relaxed); }
+  uint64_t get_suppressed_count() const { return m_total_suppressed.load(std::memory_order_relaxed); }
+
+private:
+  using clock_type = std::chrono::steady_clock;
+
+  void roll_interval(clock_type::time_point now, bool force);
+
+  const std::string m_issue_name;
+  const Severity m_severity;
+
+  std::atomic<size_t> m_max_full_reports;
+  std::atomic<clock_type::duration::rep> m_summary_interval;
+
+  std::atomic<clock_type::duration::rep> m_interval_start;
+  std::atomic<uint64_t> m_interval_count{ 0 };
+  std::atomic<uint64_t> m_interval_suppressed{ 0 };
+  std::array<std::atomic<uint64_t>, s_max_samples> m_samples;
+  std::mutex m_summary_mutex;
+
+  std::atomic<uint64_t> m_total_count{ 0 };
+  std::atomic<uint64_t> m_total_suppressed{ 0 };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_ISSUERATELIMITER_HPP_
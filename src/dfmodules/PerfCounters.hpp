@@ -0,0 +1,174 @@
+/**
+ * @file PerfCounters.hpp PerfSection and PerfScope Classes
+ *
+ * The PerfSection class accumulates the hardware performance counters (cycles,
+ * instructions, last-level cache misses and branch misses) of the invocations of
+ * a section of code, e.g. the intake of a Fragment, measured by a PerfScope that
+ * is created on entry to the section. The counters of each thread are read with
+ * perf_event_open, and nothing is measured, beyond the test of a flag, when the
+ * section is disabled.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_PERFCOUNTERS_HPP_
+#define DFMODULES_SRC_DFMODULES_PERFCOUNTERS_HPP_
+
+#include "ers/Issue.hpp"
+#include "opmonlib/InfoCollector.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief The hardware performance counters cannot be read, e.g. because perf events are not permitted
+ */
+ERS_DECLARE_ISSUE(dfmodules,               ///< Namespace
+                  PerfCountersUnavailable, ///< Issue class name
+                  "Hardware performance counters are not available (" << reason << "), only the invocations of "
+                                                                      << section << " are counted",
+                  ((std::string)section) ///< Message parameters
+                  ((std::string)reason)  ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief Values of the counters of a thread, and the times during which they were enabled and
+ * running, which differ when the kernel multiplexes more events than the CPU has counters
+ */
+struct PerfCounterValues
+{
+  uint64_t cycles = 0;          // NOLINT(build/unsigned)
+  uint64_t instructions = 0;    // NOLINT(build/unsigned)
+  uint64_t llc_misses = 0;      // NOLINT(build/unsigned)
+  uint64_t branch_misses = 0;   // NOLINT(build/unsigned)
+  uint64_t time_enabled_ns = 0; // NOLINT(build/unsigned)
+  uint64_t time_running_ns = 0; // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief PerfSection accumulates the counters of the invocations of a section of code.
+ *
+ * The counters are opened for each thread the first time that it enters an enabled
+ * section, and are read on entry and exit, with one system call each. When they
+ * cannot be opened, a PerfCountersUnavailable warning is reported once per section
+ * and the invocations are still counted. The counts include the sections nested in
+ * the section, but not the events that occur in the kernel. When the counters were
+ * only scheduled for part of an invocation, its counts are scaled up to the whole of
+ * it, and an invocation during which they were not scheduled at all is not counted.
+ */
+class PerfSection
+{
+public:
+  explicit PerfSection(const std::string& name)
+    : m_name(name)
+  {}
+
+  PerfSection(const PerfSection&) = delete;            ///< Not copy-constructible
+  PerfSection& operator=(const PerfSection&) = delete; ///< Not copy-assignable
+  PerfSection(PerfSection&&) = delete;                 ///< Not move-constructible
+  PerfSection& operator=(PerfSection&&) = delete;      ///< Not move-assignable
+
+  void set_enabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+  bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+  const std::string& get_name() const { return m_name; }
+
+  /// Invocations since the last get_info(), and those for which the counters were read
+  uint64_t get_invocations() const { return m_invocations.load(std::memory_order_relaxed); } // NOLINT
+  uint64_t get_counted_invocations() const { return m_counted_invocations.load(std::memory_order_relaxed); } // NOLINT
+
+  /**
+   * @brief Read the counters of the calling thread
+   * @param reason Set to the reason when the counters are not available
+   * @return false if the counters are not available
+   */
+  static bool read_thread_counters(PerfCounterValues& values, std::string& reason);
+
+  /**
+   * @brief Account one invocation, whose counters were read if counted is true, scaling them by the
+   * ratio of the enabled and running times
+   */
+  void add(const PerfCounterValues& start, const PerfCounterValues& end, bool counted);
+
+  /**
+   * @brief Report that the counters are not available, the first time only
+   */
+  void report_unavailable(const std::string& reason);
+
+  /**
+   * @brief Adds the counters since the last call, as a child named after the section, if it is enabled
+   */
+  void get_info(opmonlib::InfoCollector& ci);
+
+private:
+  std::string m_name;
+  std::atomic<bool> m_enabled{ false };
+  std::atomic<bool> m_reported{ false };
+
+  std::atomic<uint64_t> m_invocations{ 0 };         // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_counted_invocations{ 0 }; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_cycles{ 0 };              // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_instructions{ 0 };        // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_llc_misses{ 0 };          // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_branch_misses{ 0 };       // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_time_enabled_ns{ 0 };     // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_time_running_ns{ 0 };     // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief PerfScope measures one invocation of a section, from its construction to its destruction
+ */
+class PerfScope
+{
+public:
+  explicit PerfScope(PerfSection& section)
+    : m_section(section.is_enabled() ? &section : nullptr)
+  {
+    if (m_section != nullptr) {
+      start();
+    }
+  }
+
+  /**
+   * @brief Measure nothing when section is null
+   */
+  explicit PerfScope(PerfSection* section)
+    : m_section(section != nullptr && section->is_enabled() ? section : nullptr)
+  {
+    if (m_section != nullptr) {
+      start();
+    }
+  }
+
+  ~PerfScope()
+  {
+    if (m_section != nullptr) {
+      stop();
+    }
+  }
+
+  PerfScope(const PerfScope&) = delete;            ///< Not copy-constructible
+  PerfScope& operator=(const PerfScope&) = delete; ///< Not copy-assignable
+  PerfScope(PerfScope&&) = delete;                 ///< Not move-constructible
+  PerfScope& operator=(PerfScope&&) = delete;      ///< Not move-assignable
+
+private:
+  void start();
+  void stop();
+
+  PerfSection* m_section;
+  PerfCounterValues m_start;
+  bool m_counted = false;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_PERFCOUNTERS_HPP_
@@ -0,0 +1,148 @@
+/**
+ * @file RecordProcessingChain.hpp RecordProcessingChain Class
+ *
+ * The RecordProcessingChain class runs the RecordProcessors configured in a
+ * DataWriter on the TriggerRecords before they are written, on a pool of
+ * threads so that several records are processed at once, and hands the
+ * records back in the order in which they were submitted.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_RECORDPROCESSINGCHAIN_HPP_
+#define DFMODULES_SRC_DFMODULES_RECORDPROCESSINGCHAIN_HPP_
+
+#include "dfmodules/RecordProcessor.hpp"
+#include "dfmodules/WorkerPool.hpp"
+
+#include "daqdataformats/TriggerRecord.hpp"
+#include "daqdataformats/Types.hpp"
+#include "opmonlib/InfoCollector.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief A RecordProcessor threw an exception
+ */
+ERS_DECLARE_ISSUE(dfmodules,              ///< Namespace
+                  RecordProcessingFailed, ///< Issue class name
+                  "RecordProcessor " << processor << " failed to process TriggerRecord " << trnum << "." << seqnum
+                                     << ", the record is written as it is",
+                  ((std::string)processor)                    ///< Message parameters
+                  ((daqdataformats::trigger_number_t)trnum)   ///< Message parameters
+                  ((daqdataformats::sequence_number_t)seqnum) ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief RecordProcessingChain applies its RecordProcessors, in order, to each record.
+ *
+ * Each record goes through all the processors on one of the threads of the pool, so
+ * different records are processed concurrently. A processor that drops a record ends
+ * its processing, and so does a processor that throws, in which case the record is
+ * kept as it is. At most max_in_flight records are being processed at any time:
+ * submit() then waits for the oldest one.
+ * submit(), collect() and drain() must be called from a single thread; get_info()
+ * can be called from any thread.
+ */
+class RecordProcessingChain
+{
+public:
+  using record_ptr_t = std::unique_ptr<daqdataformats::TriggerRecord>;
+
+  /**
+   * @brief A record whose processing is complete
+   */
+  struct ProcessedRecord
+  {
+    record_ptr_t record;
+    bool keep; ///< false if a processor dropped the record
+  };
+
+  /**
+   * @param processors The processors, in the order in which they are applied
+   * @param thread_count Number of processing threads, at least one
+   * @param max_in_flight Maximum number of records being processed, at least one
+   */
+  RecordProcessingChain(std::vector<std::unique_ptr<RecordProcessor>> processors,
+                        size_t thread_count,
+                        size_t max_in_flight);
+  ~RecordProcessingChain();
+
+  RecordProcessingChain(const RecordProcessingChain&) = delete;            ///< Not copy-constructible
+  RecordProcessingChain& operator=(const RecordProcessingChain&) = delete; ///< Not copy-assignable
+  RecordProcessingChain(RecordProcessingChain&&) = delete;                 ///< Not move-constructible
+  RecordProcessingChain& operator=(RecordProcessingChain&&) = delete;      ///< Not move-assignable
+
+  void prepare_for_run(daqdataformats::run_number_t run_number);
+
+  /**
+   * @brief Start the processing of a record, and append the records that are done to done, in order
+   */
+  void submit(record_ptr_t record, std::vector<ProcessedRecord>& done);
+
+  /**
+   * @brief Append the records that are done to done, in order, without waiting
+   */
+  void collect(std::vector<ProcessedRecord>& done);
+
+  /**
+   * @brief Wait for all the records and append them to done, in order
+   */
+  void drain(std::vector<ProcessedRecord>& done);
+
+  size_t get_processor_count() const { return m_processors.size(); }
+  size_t get_records_in_processing() const { return m_in_flight.size(); }
+
+  /**
+   * @brief Adds the timing and data reduction of each processor, as a child named after it
+   */
+  void get_info(opmonlib::InfoCollector& ci, int level);
+
+private:
+  struct ProcessorStats
+  {
+    std::atomic<uint64_t> records_processed{ 0 };  // NOLINT(build/unsigned)
+    std::atomic<uint64_t> records_dropped{ 0 };    // NOLINT(build/unsigned)
+    std::atomic<uint64_t> failures{ 0 };           // NOLINT(build/unsigned)
+    std::atomic<uint64_t> processing_time_us{ 0 }; // NOLINT(build/unsigned)
+    std::atomic<uint64_t> bytes_in{ 0 };           // NOLINT(build/unsigned)
+    std::atomic<uint64_t> bytes_out{ 0 };          // NOLINT(build/unsigned)
+  };
+
+  struct InFlight
+  {
+    record_ptr_t record;
+    bool keep = true;
+    std::future<void> done;
+  };
+
+  bool process(daqdataformats::TriggerRecord& record);
+  void pop_front(std::vector<ProcessedRecord>& done);
+
+  std::vector<std::unique_ptr<RecordProcessor>> m_processors;
+  std::unique_ptr<ProcessorStats[]> m_stats;
+  size_t m_max_in_flight;
+  std::deque<InFlight> m_in_flight; ///< Its elements are not moved by push_back and pop_front
+
+  // declared last so that its threads are joined before the members that they use are destroyed
+  WorkerPool m_pool;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_RECORDPROCESSINGCHAIN_HPP_
@@ -0,0 +1,111 @@
+/**
+ * @file RecordReorderBuffer.hpp RecordReorderBuffer Class
+ *
+ * The RecordReorderBuffer class holds the TriggerRecords received by a writer for a
+ * short time, and releases them in trigger and sequence number order, so that the
+ * records are laid out in that order in the output files rather than in the order in
+ * which they were completed.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_RECORDREORDERBUFFER_HPP_
+#define DFMODULES_SRC_DFMODULES_RECORDREORDERBUFFER_HPP_
+
+#include "daqdataformats/TriggerRecord.hpp"
+#include "daqdataformats/Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief RecordReorderBuffer releases the records it holds in ascending (trigger, sequence) order.
+ *
+ * The oldest records are released when more than max_records records or max_bytes bytes
+ * are held, and when a record has been held for max_hold, together with all the records
+ * before it. A record that arrives after a record that comes after it has been released
+ * can no longer be ordered: it is counted as late and released straight away.
+ * The buffer is meant to be used from a single thread, but its counters can be read
+ * from any thread.
+ */
+class RecordReorderBuffer
+{
+public:
+  using record_ptr_t = std::unique_ptr<daqdataformats::TriggerRecord>;
+  using clock_type = std::chrono::steady_clock;
+
+  /**
+   * @param max_records Maximum number of records held. 0 disables the buffer
+   * @param max_bytes Maximum size of the records held. 0 means no limit
+   * @param max_hold Maximum time for which a record is held
+   */
+  void configure(size_t max_records, size_t max_bytes, std::chrono::milliseconds max_hold);
+
+  bool is_enabled() const { return m_max_records > 0; }
+
+  /**
+   * @brief Forget the order of the previous run and reset the counters. The buffer must be empty
+   */
+  void reset();
+
+  /**
+   * @brief Add a record, and append the records that are due to be released, in order
+   */
+  void push(record_ptr_t record, clock_type::time_point now, std::vector<record_ptr_t>& released);
+
+  /**
+   * @brief Append the records that have been held for too long to released, in order
+   */
+  void release_expired(clock_type::time_point now, std::vector<record_ptr_t>& released);
+
+  /**
+   * @brief Append all the records to released, in order
+   */
+  void flush(std::vector<record_ptr_t>& released);
+
+  size_t get_held_records() const { return m_held_records.load(std::memory_order_relaxed); }
+  size_t get_held_bytes() const { return m_held_bytes.load(std::memory_order_relaxed); }
+  uint64_t get_late_records() const { return m_late_records.load(std::memory_order_relaxed); } // NOLINT
+
+private:
+  using key_t = std::pair<daqdataformats::trigger_number_t, daqdataformats::sequence_number_t>;
+
+  struct HeldRecord
+  {
+    record_ptr_t record;
+    size_t size;
+  };
+
+  static key_t key_of(daqdataformats::TriggerRecord& record);
+  void release_front(std::vector<record_ptr_t>& released);
+
+  size_t m_max_records = 0;
+  size_t m_max_bytes = 0;
+  clock_type::duration m_max_hold{ 0 };
+
+  std::map<key_t, HeldRecord> m_records;
+  std::deque<std::pair<clock_type::time_point, key_t>> m_arrivals; ///< In arrival order, may refer to released records
+  std::optional<key_t> m_last_released;
+
+  std::atomic<size_t> m_held_records{ 0 };
+  std::atomic<size_t> m_held_bytes{ 0 };
+  std::atomic<uint64_t> m_late_records{ 0 }; // NOLINT(build/unsigned)
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_RECORDREORDERBUFFER_HPP_
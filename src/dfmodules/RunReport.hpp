@@ -0,0 +1,220 @@
+/**
+ * @file RunReport.hpp RunReport Class
+ *
+ * The RunReport class accumulates the run-level performance figures of a module
+ * (totals, latency distributions, peak occupancies and the time spent in states
+ * such as busy), which, unlike the opmon counters, are not reset while the run is
+ * going on, and writes them as a JSON file at the end of the run, so that the
+ * performance of two runs, e.g. with two software versions, can be compared.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_RUNREPORT_HPP_
+#define DFMODULES_SRC_DFMODULES_RUNREPORT_HPP_
+
+#include "dfmodules/runreport/Structs.hpp"
+
+#include "daqdataformats/Types.hpp"
+#include "ers/Issue.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief The end-of-run report of a module has been written to a file
+ */
+ERS_DECLARE_ISSUE(dfmodules,             ///< Namespace
+                  RunReportWritten,      ///< Issue class name
+                  "The end-of-run report of " << owner << " for run " << run_number << " was written to " << file_name,
+                  ((std::string)owner)     ///< Message parameters
+                  ((uint64_t)run_number)   ///< Message parameters
+                  ((std::string)file_name) ///< Message parameters
+)
+
+/**
+ * @brief The end-of-run report of a module could not be written
+ */
+ERS_DECLARE_ISSUE(dfmodules,            ///< Namespace
+                  RunReportWriteFailed, ///< Issue class name
+                  "The end-of-run report of " << owner << " could not be written to " << file_name << ": " << reason,
+                  ((std::string)owner)     ///< Message parameters
+                  ((std::string)file_name) ///< Message parameters
+                  ((std::string)reason)    ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief RunReport keeps the performance figures of a module over a run.
+ *
+ * The figures are registered before the report is started, typically in the constructor
+ * of the module, and are updated from the dataflow threads with a few relaxed atomic
+ * operations each, whether or not the report is enabled. They are reset by start(), and
+ * stop() writes them, with the peak resident memory of the process, to
+ * runreport_<module>_run<run number>.json in the output path, if the report is enabled.
+ */
+class RunReport
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  /**
+   * @brief A run total; its rate over the run is also reported
+   */
+  class Counter
+  {
+  public:
+    void add(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); } // NOLINT(build/unsigned)
+    uint64_t get() const { return m_value.load(std::memory_order_relaxed); }      // NOLINT(build/unsigned)
+    void reset() { m_value.store(0); }
+
+  private:
+    std::atomic<uint64_t> m_value{ 0 }; // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief The highest value observed of a gauge, e.g. the occupancy of a queue
+   */
+  class Peak
+  {
+  public:
+    void observe(int64_t value)
+    {
+      auto peak = m_value.load(std::memory_order_relaxed);
+      while (value > peak && !m_value.compare_exchange_weak(peak, value, std::memory_order_relaxed)) {
+      }
+    }
+    int64_t get() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { m_value.store(0); }
+
+  private:
+    std::atomic<int64_t> m_value{ 0 };
+  };
+
+  /**
+   * @brief The distribution of a latency, in powers of two of microseconds.
+   * The quantiles are reported as the upper edges of their bins, and the maximum exactly
+   */
+  class Latency
+  {
+  public:
+    static constexpr size_t s_bin_count = 36; ///< Up to about 9 hours
+
+    void record(std::chrono::microseconds latency);
+    uint64_t get_count() const { return m_count.load(std::memory_order_relaxed); } // NOLINT(build/unsigned)
+    uint64_t get_quantile(double fraction) const;                                  // NOLINT(build/unsigned)
+    uint64_t get_max() const { return m_max.load(std::memory_order_relaxed); }     // NOLINT(build/unsigned)
+    double get_mean() const;
+    void reset();
+
+  private:
+    std::array<std::atomic<uint64_t>, s_bin_count> m_bins{}; // NOLINT(build/unsigned)
+    std::atomic<uint64_t> m_count{ 0 };                      // NOLINT(build/unsigned)
+    std::atomic<uint64_t> m_sum{ 0 };                        // NOLINT(build/unsigned)
+    std::atomic<uint64_t> m_max{ 0 };                        // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief The time spent in a state, e.g. busy; meant for states that change far less
+   * often than they are set, since each change takes a lock
+   */
+  class StateTimer
+  {
+  public:
+    void set(bool active);
+    bool is_active() const { return m_active.load(std::memory_order_relaxed); }
+
+    /// Time spent in the state up to now, including the current stay
+    std::chrono::microseconds get_time(clock_type::time_point now) const;
+    void reset(clock_type::time_point now);
+
+  private:
+    mutable std::mutex m_mutex;
+    std::atomic<bool> m_active{ false };
+    clock_type::time_point m_since;
+    clock_type::duration m_total{ 0 };
+  };
+
+  RunReport(std::string owner_name, std::string module_class);
+
+  RunReport(const RunReport&) = delete;            ///< RunReport is not copy-constructible
+  RunReport& operator=(const RunReport&) = delete; ///< RunReport is not copy-assignable
+  RunReport(RunReport&&) = delete;                 ///< RunReport is not move-constructible
+  RunReport& operator=(RunReport&&) = delete;      ///< RunReport is not move-assignable
+
+  void configure(const runreport::RunReport& conf);
+
+  bool is_enabled() const { return m_enabled; }
+
+  /// Registration; only allowed while the report is stopped
+  Counter& add_counter(const std::string& name);
+  Peak& add_peak(const std::string& name);
+  Latency& add_latency(const std::string& name);
+  StateTimer& add_state(const std::string& name);
+
+  /**
+   * @brief Set a figure that is only known at the end of the run, e.g. an inferred clock frequency
+   */
+  void set_value(const std::string& name, double value);
+
+  void start(daqdataformats::run_number_t run_number);
+
+  /**
+   * @brief Write the report, if it is enabled
+   */
+  void stop();
+
+  /**
+   * @brief Write the report of the run so far as JSON
+   */
+  void write(std::ostream& os) const;
+
+  /**
+   * @brief Peak resident memory of the process, in kB
+   */
+  static int64_t get_peak_rss_kb();
+
+private:
+  template<typename T>
+  using named_t = std::vector<std::pair<std::string, std::unique_ptr<T>>>;
+
+  const std::string m_owner_name;
+  const std::string m_module_class;
+
+  // Configuration
+  bool m_enabled{ false };
+  std::string m_output_path{ "." };
+
+  named_t<Counter> m_counters;
+  named_t<Peak> m_peaks;
+  named_t<Latency> m_latencies;
+  named_t<StateTimer> m_states;
+
+  mutable std::mutex m_values_mutex;
+  std::map<std::string, double> m_values;
+
+  daqdataformats::run_number_t m_run_number{ 0 };
+  clock_type::time_point m_start_time;
+  std::time_t m_start_wall_time{ 0 };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_RUNREPORT_HPP_
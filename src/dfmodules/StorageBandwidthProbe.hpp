@@ -0,0 +1,104 @@
+/**
+ * @file StorageBandwidthProbe.hpp StorageBandwidthProbe Class
+ *
+ * The StorageBandwidthProbe class measures the sustained sequential write
+ * bandwidth, and the latency of the individual writes, of a directory by
+ * writing a temporary file in it, so that a directory that cannot keep up
+ * with the expected data rate is noticed before the run rather than by the
+ * write retries during the run.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_STORAGEBANDWIDTHPROBE_HPP_
+#define DFMODULES_SRC_DFMODULES_STORAGEBANDWIDTHPROBE_HPP_
+
+#include "dfmodules/storageprobe/Structs.hpp"
+
+#include "ers/Issue.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief The bandwidth of a directory could not be measured
+ */
+ERS_DECLARE_ISSUE(dfmodules,                   ///< Namespace
+                  StorageBandwidthProbeFailed, ///< Issue class name
+                  "Unable to measure the write bandwidth of " << path << ": " << reason,
+                  ((std::string)path)   ///< Message parameters
+                  ((std::string)reason) ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief StorageBandwidthProbe writes a temporary file in a directory, once for each block size.
+ *
+ * The file is written sequentially, one block at a time, and synced to the device
+ * every sync_interval_bytes and at the end, so that the measured bandwidth is the
+ * one that the device sustains rather than the one of the page cache. The latency
+ * of each block includes the sync that follows it, if any, which is where the tail
+ * of the latency distribution comes from when the device falls behind. A block size
+ * stops being measured when its share of max_duration_ms has elapsed, and the file
+ * is removed once it has been measured.
+ */
+class StorageBandwidthProbe
+{
+public:
+  /**
+   * @brief The measurement of one block size
+   */
+  struct Result
+  {
+    size_t block_size{ 0 };
+    size_t bytes_written{ 0 };
+    std::chrono::microseconds duration{ 0 };
+    double bandwidth_bytes_per_s{ 0 };
+    std::chrono::microseconds latency_p50{ 0 };
+    std::chrono::microseconds latency_p99{ 0 };
+    std::chrono::microseconds latency_max{ 0 };
+  };
+
+  static constexpr size_t s_default_block_size = 1048576;
+
+  explicit StorageBandwidthProbe(const storageprobe::BandwidthProbe& conf);
+
+  bool is_enabled() const { return m_conf.enabled; }
+
+  /**
+   * @brief Whether a measurement is below the expected rate, if there is one
+   */
+  bool is_below_expected_rate(const Result& result) const
+  {
+    return m_conf.expected_rate_bytes_per_s > 0 && result.bandwidth_bytes_per_s < m_conf.expected_rate_bytes_per_s;
+  }
+  uint64_t get_expected_rate() const { return m_conf.expected_rate_bytes_per_s; } // NOLINT(build/unsigned)
+
+  /**
+   * @brief Measure each configured block size in turn
+   * @throws StorageBandwidthProbeFailed if the directory does not have enough free space for the
+   * temporary file, or if the file cannot be written
+   */
+  std::vector<Result> run(const std::string& directory) const;
+
+private:
+  Result measure(const std::string& file_name,
+                 size_t block_size,
+                 std::chrono::steady_clock::duration max_duration) const;
+
+  storageprobe::BandwidthProbe m_conf;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_STORAGEBANDWIDTHPROBE_HPP_
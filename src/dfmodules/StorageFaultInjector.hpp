@@ -0,0 +1,139 @@
+/**
+ * @file StorageFaultInjector.hpp StorageFaultInjector Class
+ *
+ * The StorageFaultInjector class degrades the writes of a data store on
+ * purpose: it delays them according to a latency distribution and a throughput
+ * cap, blocks them during periodic stalls, and makes them fail during periodic
+ * full storage episodes, so that the response of the dataflow to slow or full
+ * storage can be measured without real disks.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_STORAGEFAULTINJECTOR_HPP_
+#define DFMODULES_SRC_DFMODULES_STORAGEFAULTINJECTOR_HPP_
+
+#include "dfmodules/storagefaults/Structs.hpp"
+
+#include "ers/Issue.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief The configuration of the injected storage faults is inconsistent
+ */
+ERS_DECLARE_ISSUE(dfmodules,           ///< Namespace
+                  InvalidStorageFaults, ///< Issue class name
+                  "Invalid storage faults: " << reason,
+                  ((std::string)reason) ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief StorageFaultInjector decides the fate of each write of a data store.
+ *
+ * Each write first asks is_full() whether it has to fail, which is the case during
+ * the first full_duration_ms of every full_period_ms, and otherwise with probability
+ * full_probability. A write that goes ahead then calls delay_write(), which waits for
+ * the end of the stall in progress, if any (the first stall_duration_ms of every
+ * stall_period_ms), then for a latency drawn from the configured distribution, and
+ * finally for the time it takes to write the data at the throughput cap. The cap
+ * models a single device: the writes are serialized at that rate, and a write that
+ * arrives while the device is idle does not benefit from the idle time.
+ * The periods are counted from the last call to start(). The injector is meant to
+ * be used from the single thread that writes to the data store.
+ */
+class StorageFaultInjector
+{
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  /**
+   * @throws InvalidStorageFaults if the latency distribution is unknown, or an episode is longer than its period
+   */
+  explicit StorageFaultInjector(const storagefaults::StorageFaults& conf);
+
+  StorageFaultInjector(const StorageFaultInjector&) = delete;            ///< Not copy-constructible
+  StorageFaultInjector& operator=(const StorageFaultInjector&) = delete; ///< Not copy-assignable
+  StorageFaultInjector(StorageFaultInjector&&) = delete;                 ///< Not move-constructible
+  StorageFaultInjector& operator=(StorageFaultInjector&&) = delete;      ///< Not move-assignable
+
+  /**
+   * @brief Restart the stall and full storage periods, and reset the counters
+   */
+  void start();
+
+  /**
+   * @brief Whether the current write has to fail because the storage is full
+   */
+  bool is_full();
+
+  /**
+   * @brief Block the current write for the injected stall, latency and throughput cap
+   * @param bytes Size of the data written
+   */
+  void delay_write(size_t bytes);
+
+  size_t get_write_count() const { return m_write_count; }
+  size_t get_failed_write_count() const { return m_failed_write_count; }
+  size_t get_stalled_write_count() const { return m_stalled_write_count; }
+  std::chrono::microseconds get_injected_delay() const
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(m_injected_delay);
+  }
+
+private:
+  clock_type::duration draw_latency();
+  static bool in_episode(clock_type::duration elapsed,
+                         std::chrono::milliseconds period,
+                         std::chrono::milliseconds duration,
+                         clock_type::duration& remaining);
+
+  enum class Distribution
+  {
+    kNone,
+    kConstant,
+    kUniform,
+    kExponential,
+    kLognormal
+  };
+
+  // Configuration
+  Distribution m_distribution{ Distribution::kNone };
+  double m_latency_mean_us{ 0 };
+  double m_latency_spread_us{ 0 };
+  uint64_t m_throughput_cap{ 0 }; // NOLINT(build/unsigned)
+  std::chrono::milliseconds m_stall_period{ 0 };
+  std::chrono::milliseconds m_stall_duration{ 0 };
+  std::chrono::milliseconds m_full_period{ 0 };
+  std::chrono::milliseconds m_full_duration{ 0 };
+  double m_full_probability{ 0 };
+
+  std::mt19937_64 m_random_engine;
+  std::uniform_real_distribution<double> m_uniform{ 0., 1. };
+  std::lognormal_distribution<double> m_lognormal;
+
+  clock_type::time_point m_start_time;
+  clock_type::time_point m_device_free_time;
+
+  // Counters
+  size_t m_write_count{ 0 };
+  size_t m_failed_write_count{ 0 };
+  size_t m_stalled_write_count{ 0 };
+  clock_type::duration m_injected_delay{ 0 };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_STORAGEFAULTINJECTOR_HPP_
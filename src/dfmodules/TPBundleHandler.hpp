@@ -12,6 +12,9 @@
 #ifndef DFMODULES_SRC_DFMODULES_TPBUNDLEHANDLER_HPP_
 #define DFMODULES_SRC_DFMODULES_TPBUNDLEHANDLER_HPP_
 
+#include "dfmodules/InstrumentedMutex.hpp"
+#include "dfmodules/PerfCounters.hpp"
+
 #include "daqdataformats/TimeSlice.hpp"
 #include "daqdataformats/Types.hpp"
 #include "trgdataformats/TriggerPrimitive.hpp"
@@ -22,6 +25,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 namespace dunedaq {
@@ -52,21 +56,28 @@ public:
   TimeSliceAccumulator(daqdataformats::timestamp_t begin_time,
                        daqdataformats::timestamp_t end_time,
                        daqdataformats::timeslice_number_t slice_number,
-                       daqdataformats::run_number_t run_number)
+                       daqdataformats::run_number_t run_number,
+                       const std::string& lock_owner = "")
     : m_begin_time(begin_time)
     , m_end_time(end_time)
     , m_slice_number(slice_number)
     , m_run_number(run_number)
     , m_update_time(std::chrono::steady_clock::now())
+    , m_lock_owner(lock_owner)
+    , m_bundle_map_mutex(lock_owner, "TPBundleHandler.bundle_map")
   {
   }
 
   TimeSliceAccumulator& operator=(const TimeSliceAccumulator& other)
   {
     if (this != &other) {
+      if (m_lock_owner != other.m_lock_owner) {
+        m_lock_owner = other.m_lock_owner;
+        m_bundle_map_mutex.set_owner(m_lock_owner);
+      }
       std::lock(m_bundle_map_mutex, other.m_bundle_map_mutex);
-      std::lock_guard<std::mutex> lhs_lk(m_bundle_map_mutex, std::adopt_lock);
-      std::lock_guard<std::mutex> rhs_lk(other.m_bundle_map_mutex, std::adopt_lock);
+      std::lock_guard<InstrumentedMutex> lhs_lk(m_bundle_map_mutex, std::adopt_lock);
+      std::lock_guard<InstrumentedMutex> rhs_lk(other.m_bundle_map_mutex, std::adopt_lock);
       m_begin_time = other.m_begin_time;
       m_end_time = other.m_end_time;
       m_slice_number = other.m_slice_number;
@@ -83,7 +94,7 @@ public:
 
   std::chrono::steady_clock::time_point get_update_time() const
   {
-    auto lk = std::lock_guard<std::mutex>(m_bundle_map_mutex);
+    auto lk = std::lock_guard<InstrumentedMutex>(m_bundle_map_mutex);
     return m_update_time;
   }
 
@@ -96,19 +107,29 @@ private:
   typedef std::map<daqdataformats::timestamp_t, trigger::TPSet> tpbundles_by_start_time_t;
   typedef std::map<daqdataformats::SourceID, tpbundles_by_start_time_t> bundles_by_sourceid_t;
   bundles_by_sourceid_t m_tpbundles_by_sourceid_and_start_time;
-  mutable std::mutex m_bundle_map_mutex;
+  std::string m_lock_owner;
+  mutable InstrumentedMutex m_bundle_map_mutex{ "TPBundleHandler.bundle_map" };
 };
 
 class TPBundleHandler
 {
 public:
+  /**
+   * @param get_timeslice_perf Optional section that measures the assembly of each TimeSlice
+   * @param lock_owner Module that reports the profiles of the locks, if any
+   */
   TPBundleHandler(daqdataformats::timestamp_t slice_interval,
                   daqdataformats::run_number_t run_number,
-                  std::chrono::steady_clock::duration cooling_off_time)
+                  std::chrono::steady_clock::duration cooling_off_time,
+                  PerfSection* get_timeslice_perf = nullptr,
+                  const std::string& lock_owner = "")
     : m_slice_interval(slice_interval)
     , m_run_number(run_number)
     , m_cooling_off_time(cooling_off_time)
     , m_slice_index_offset(0)
+    , m_get_timeslice_perf(get_timeslice_perf)
+    , m_lock_owner(lock_owner)
+    , m_accumulator_map_mutex(lock_owner, "TPBundleHandler.accumulator_map")
   {
   }
 
@@ -126,8 +147,10 @@ private:
   daqdataformats::run_number_t m_run_number;
   std::chrono::steady_clock::duration m_cooling_off_time;
   size_t m_slice_index_offset;
+  PerfSection* m_get_timeslice_perf;
   std::map<daqdataformats::timestamp_t, TimeSliceAccumulator> m_timeslice_accumulators;
-  mutable std::mutex m_accumulator_map_mutex;
+  std::string m_lock_owner;
+  mutable InstrumentedMutex m_accumulator_map_mutex;
 };
 } // namespace dfmodules
 } // namespace dunedaq
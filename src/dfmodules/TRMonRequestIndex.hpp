@@ -0,0 +1,86 @@
+/**
+ * @file TRMonRequestIndex.hpp TRMonRequestIndex Class
+ *
+ * The TRMonRequestIndex class keeps the pending TriggerRecord monitoring requests
+ * indexed by trigger type, so that the TriggerRecordBuilder finds the requests that a
+ * record serves with a single lookup, and without taking a lock when there are none.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_TRMONREQUESTINDEX_HPP_
+#define DFMODULES_SRC_DFMODULES_TRMONREQUESTINDEX_HPP_
+
+#include "dfmodules/InstrumentedMutex.hpp"
+
+#include "dfmessages/TRMonRequest.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief TRMonRequestIndex holds the monitoring requests that have not been served yet.
+ *
+ * Requests are added from the receiver callback and taken by the thread that sends
+ * the records; each request is served by a single record of its trigger type. The
+ * number of pending requests of each group of trigger types is kept in an atomic, so
+ * that take() returns without locking for the records that no one asked for, which
+ * are most of them.
+ */
+class TRMonRequestIndex
+{
+public:
+  using trigger_type_t = decltype(dfmessages::TRMonRequest::trigger_type);
+
+  /**
+   * @param lock_owner, lock_name Owner and name of the lock of the index, for the lock profiling
+   */
+  TRMonRequestIndex(const std::string& lock_owner, const char* lock_name);
+
+  TRMonRequestIndex(const TRMonRequestIndex&) = delete;            ///< TRMonRequestIndex is not copy-constructible
+  TRMonRequestIndex& operator=(const TRMonRequestIndex&) = delete; ///< TRMonRequestIndex is not copy-assignable
+  TRMonRequestIndex(TRMonRequestIndex&&) = delete;                 ///< TRMonRequestIndex is not move-constructible
+  TRMonRequestIndex& operator=(TRMonRequestIndex&&) = delete;      ///< TRMonRequestIndex is not move-assignable
+
+  void add(const dfmessages::TRMonRequest& request);
+
+  /**
+   * @brief Remove and return the pending requests of a trigger type, in the order in which they were added
+   */
+  std::vector<dfmessages::TRMonRequest> take(trigger_type_t trigger_type);
+
+  /// Whether requests of the trigger type may be pending; lock-free
+  bool may_have(trigger_type_t trigger_type) const
+  {
+    return m_pending_in_bucket[get_bucket(trigger_type)].load(std::memory_order_acquire) > 0;
+  }
+
+  size_t size() const { return m_pending.load(std::memory_order_relaxed); }
+
+  void clear();
+
+private:
+  static constexpr size_t s_bucket_count = 64;
+  static size_t get_bucket(trigger_type_t trigger_type) { return trigger_type % s_bucket_count; }
+
+  std::array<std::atomic<uint32_t>, s_bucket_count> m_pending_in_bucket{}; // NOLINT(build/unsigned)
+  std::atomic<size_t> m_pending{ 0 };
+
+  InstrumentedMutex m_mutex;
+  std::unordered_map<trigger_type_t, std::vector<dfmessages::TRMonRequest>> m_requests;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_TRMONREQUESTINDEX_HPP_
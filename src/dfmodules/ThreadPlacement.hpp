@@ -0,0 +1,110 @@
+/**
+ * @file ThreadPlacement.hpp ThreadPlacement Class
+ *
+ * The ThreadPlacement class applies a configured CPU affinity and NUMA memory
+ * policy to the calling thread, and checks that they have been applied.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_THREADPLACEMENT_HPP_
+#define DFMODULES_SRC_DFMODULES_THREADPLACEMENT_HPP_
+
+#include "dfmodules/threadplacement/Structs.hpp"
+
+#include "ers/Issue.hpp"
+
+#include <set>
+#include <string>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief Invalid thread placement configuration
+ */
+ERS_DECLARE_ISSUE(dfmodules,              ///< Namespace
+                  InvalidThreadPlacement, ///< Issue class name
+                  "Invalid thread placement configuration: " << reason,
+                  ((std::string)reason) ///< Message parameters
+)
+
+/**
+ * @brief The thread placement could not be applied
+ */
+ERS_DECLARE_ISSUE(dfmodules,             ///< Namespace
+                  ThreadPlacementFailed, ///< Issue class name
+                  "Unable to apply the " << what << " of thread " << thread_name << ": " << reason,
+                  ((std::string)thread_name) ///< Message parameters
+                  ((std::string)what)        ///< Message parameters
+                  ((std::string)reason)      ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief ThreadPlacement holds a validated thread placement configuration.
+ *
+ * The placement is applied by the thread itself, at the beginning of its work
+ * function, so that the memory policy (which is a per-thread property) covers
+ * the allocations made by that thread. The outcome is checked by reading back
+ * the affinity and the memory policy, and reported with TLOG on success and with
+ * a ThreadPlacementFailed warning otherwise; the thread keeps running in both cases.
+ */
+class ThreadPlacement
+{
+public:
+  enum class MemoryPolicy
+  {
+    kDefault,
+    kLocal,
+    kBind,
+    kPreferred,
+    kInterleave
+  };
+
+  ThreadPlacement() = default;
+
+  /**
+   * @brief Validate a placement configuration
+   * @throws InvalidThreadPlacement if the CPU list or the memory policy cannot be parsed
+   */
+  explicit ThreadPlacement(const threadplacement::ThreadPlacement& conf);
+
+  bool is_empty() const { return m_cpus.empty() && m_memory_policy == MemoryPolicy::kDefault; }
+
+  const std::set<int>& get_cpus() const { return m_cpus; }
+  const std::set<int>& get_numa_nodes() const { return m_numa_nodes; }
+  MemoryPolicy get_memory_policy() const { return m_memory_policy; }
+
+  /**
+   * @brief Apply the placement to the calling thread
+   * @return true if everything that was configured has been applied and verified
+   */
+  bool apply_to_current_thread(const std::string& thread_name) const;
+
+  /**
+   * @brief Parse a CPU list in the taskset/cpuset format, e.g. "0-3,8"
+   */
+  static std::set<int> parse_cpu_list(const std::string& cpu_list);
+
+  /**
+   * @brief NUMA node of a CPU, or -1 if it cannot be determined
+   */
+  static int numa_node_of_cpu(int cpu);
+
+private:
+  bool apply_affinity(const std::string& thread_name) const;
+  bool apply_memory_policy(const std::string& thread_name) const;
+
+  std::set<int> m_cpus;
+  std::set<int> m_numa_nodes;
+  MemoryPolicy m_memory_policy{ MemoryPolicy::kDefault };
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_THREADPLACEMENT_HPP_
@@ -0,0 +1,178 @@
+/**
+ * @file TriggerManifest.hpp TriggerManifest and TriggerManifestWriter Classes
+ *
+ * A trigger manifest lists, for every record written in a run, the raw data file
+ * that holds it, so that a record can be located without opening the files. Each
+ * data store appends its entries to a journal of its own while the run goes on,
+ * and the journals of all the writers of the run are merged into a single sorted
+ * manifest, in which a trigger number is found with a binary search.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_TRIGGERMANIFEST_HPP_
+#define DFMODULES_SRC_DFMODULES_TRIGGERMANIFEST_HPP_
+
+#include "ers/Issue.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+// Disable coverage checking LCOV_EXCL_START
+/**
+ * @brief A trigger manifest or journal could not be written or read
+ */
+ERS_DECLARE_ISSUE(dfmodules,              ///< Namespace
+                  TriggerManifestProblem, ///< Issue class name
+                  "Trigger manifest " << path << ": " << reason,
+                  ((std::string)path)   ///< Message parameters
+                  ((std::string)reason) ///< Message parameters
+)
+// Re-enable coverage checking LCOV_EXCL_STOP
+
+namespace dfmodules {
+
+/**
+ * @brief Location of one record: the file is an index in the file table of the manifest
+ */
+struct TriggerManifestEntry
+{
+  uint64_t trigger_number;  // NOLINT(build/unsigned)
+  uint32_t sequence_number; // NOLINT(build/unsigned)
+  uint32_t file_id;         // NOLINT(build/unsigned)
+  uint64_t offset;          // NOLINT(build/unsigned)
+
+  bool operator<(const TriggerManifestEntry& other) const
+  {
+    return trigger_number != other.trigger_number ? trigger_number < other.trigger_number
+                                                  : sequence_number < other.sequence_number;
+  }
+};
+static_assert(sizeof(TriggerManifestEntry) == 24, "TriggerManifestEntry must be packed on 24 bytes");
+
+/**
+ * @brief TriggerManifestWriter appends the entries of one data store to its journal.
+ *
+ * The journal is a sequence of frames, each a 32-bit kind and a 32-bit payload size
+ * followed by the payload: a file name, which the following entries refer to, or a
+ * block of entries. The entries are buffered and appended every flush_entries entries,
+ * when the file changes and when the writer is closed, so a journal that is cut short
+ * by a crash loses at most the last block, which the merge ignores.
+ * The offset of an entry is an offset in its file (e.g. of the record header), or
+ * s_unknown_offset.
+ */
+class TriggerManifestWriter
+{
+public:
+  static constexpr uint64_t s_unknown_offset = UINT64_MAX; // NOLINT(build/unsigned)
+
+  /**
+   * @throws TriggerManifestProblem if the journal cannot be created
+   */
+  TriggerManifestWriter(const std::string& journal_path, size_t flush_entries);
+  ~TriggerManifestWriter();
+
+  TriggerManifestWriter(const TriggerManifestWriter&) = delete;            ///< Not copy-constructible
+  TriggerManifestWriter& operator=(const TriggerManifestWriter&) = delete; ///< Not copy-assignable
+  TriggerManifestWriter(TriggerManifestWriter&&) = delete;                 ///< Not move-constructible
+  TriggerManifestWriter& operator=(TriggerManifestWriter&&) = delete;      ///< Not move-assignable
+
+  /**
+   * @brief Make file_name the file of the next entries. Throws TriggerManifestProblem
+   */
+  void add_file(const std::string& file_name);
+
+  /**
+   * @brief Add the location of a record in the current file. Throws TriggerManifestProblem
+   */
+  void add_entry(uint64_t trigger_number, uint32_t sequence_number, uint64_t offset); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Append the buffered entries to the journal. Throws TriggerManifestProblem
+   */
+  void flush();
+
+  const std::string& get_journal_path() const { return m_journal_path; }
+
+private:
+  void write_frame(uint32_t kind, const void* payload, size_t size); // NOLINT(build/unsigned)
+
+  std::string m_journal_path;
+  std::ofstream m_journal;
+  size_t m_flush_entries;
+  uint32_t m_file_count = 0; // NOLINT(build/unsigned)
+  std::vector<TriggerManifestEntry> m_pending;
+};
+
+/**
+ * @brief TriggerManifest reads a merged manifest.
+ *
+ * A manifest starts with a 32-byte header: the magic "DFTRMAN1", the number of files
+ * and of entries, and the offset of the entries. The file table follows, each name as
+ * a 32-bit length and its characters, and then the entries sorted by trigger and
+ * sequence number. All numbers are in the byte order of the machine that wrote them.
+ * The header and file table are read when the manifest is opened, and the entries are
+ * read from the file on demand, a few dozen per lookup even in very long runs.
+ */
+class TriggerManifest
+{
+public:
+  /**
+   * @brief Location of a record, as returned by find()
+   */
+  struct Location
+  {
+    std::string file_name;
+    uint32_t sequence_number; // NOLINT(build/unsigned)
+    uint64_t offset;          // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief Merge journals into a manifest, which is replaced atomically, and delete them
+   *
+   * The entries of the manifest, if it exists, are kept. A journal must only be merged once
+   * its writer has been closed, since the entries that are added to it later are lost.
+   * @return The number of entries in the manifest
+   * @throws TriggerManifestProblem if a journal cannot be read or the manifest cannot be written
+   */
+  static size_t merge(const std::vector<std::string>& journal_paths, const std::string& manifest_path);
+
+  /**
+   * @throws TriggerManifestProblem if the manifest cannot be opened or is not a manifest
+   */
+  explicit TriggerManifest(const std::string& manifest_path);
+  ~TriggerManifest();
+
+  TriggerManifest(const TriggerManifest&) = delete;            ///< Not copy-constructible
+  TriggerManifest& operator=(const TriggerManifest&) = delete; ///< Not copy-assignable
+  TriggerManifest(TriggerManifest&&) = delete;                 ///< Not move-constructible
+  TriggerManifest& operator=(TriggerManifest&&) = delete;      ///< Not move-assignable
+
+  /**
+   * @brief Locations of all the sequences of a trigger, in sequence order. Throws TriggerManifestProblem
+   */
+  std::vector<Location> find(uint64_t trigger_number) const; // NOLINT(build/unsigned)
+
+  size_t get_entry_count() const { return m_entry_count; }
+  const std::vector<std::string>& get_file_names() const { return m_file_names; }
+
+private:
+  TriggerManifestEntry read_entry(size_t index) const;
+
+  std::string m_path;
+  int m_fd = -1;
+  size_t m_entry_count = 0;
+  uint64_t m_entries_offset = 0; // NOLINT(build/unsigned)
+  std::vector<std::string> m_file_names;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_TRIGGERMANIFEST_HPP_
@@ -12,22 +12,24 @@
 #ifndef DFMODULES_SRC_DFMODULES_TRIGGERRECORDBUILDERDATA_HPP_
 #define DFMODULES_SRC_DFMODULES_TRIGGERRECORDBUILDERDATA_HPP_
 
+#include "dfmodules/InstrumentedMutex.hpp"
+
 #include "daqdataformats/Types.hpp"
 #include "dfmessages/TriggerDecision.hpp"
 
 #include "ers/Issue.hpp"
-#include "nlohmann/json.hpp"
 #include "opmonlib/InfoCollector.hpp"
 
 #include <atomic>
 #include <chrono>
-#include <functional>
+#include <cstdint>
 #include <limits>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace dunedaq {
 // Disable coverage checking LCOV_EXCL_START
@@ -49,6 +51,13 @@ ERS_DECLARE_ISSUE(dfmodules,
 // Re-enable coverage checking LCOV_EXCL_STOP
 
 namespace dfmodules {
+/**
+ * @brief A TriggerDecision assigned to a dataflow application.
+ *
+ * The assignments are recycled by the TriggerRecordBuilderData that made them, once nobody
+ * else holds them. The DFO hands the decision over to the transport when it dispatches it,
+ * after which only its scalar fields (trigger and run numbers, timestamp...) are meaningful.
+ */
 struct AssignedTriggerDecision
 {
   dfmessages::TriggerDecision decision;
@@ -56,18 +65,40 @@ struct AssignedTriggerDecision
   std::string connection_name;
 
   AssignedTriggerDecision(dfmessages::TriggerDecision dec, std::string conn_name)
-    : decision(dec)
+    : decision(std::move(dec))
     , assigned_time(std::chrono::steady_clock::now())
-    , connection_name(conn_name)
+    , connection_name(std::move(conn_name))
   {}
 };
 
+/**
+ * @brief Values kept up to date for a dataflow application as its tokens are received
+ */
+struct TriggerRecordBuilderMetadata
+{
+  daqdataformats::trigger_number_t last_completed_trigger_number{ 0 };
+  std::chrono::microseconds last_completion_time{ 0 };
+  uint64_t completed_trigger_decisions{ 0 }; // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief Update of the metadata of an application when one of its assignments is completed;
+ * a plain function, so that nothing is allocated or copied for each token
+ */
+using metadata_function_t = void (*)(TriggerRecordBuilderMetadata&, const AssignedTriggerDecision&);
+
 class TriggerRecordBuilderData
 {
 public:
   TriggerRecordBuilderData() = default;
   TriggerRecordBuilderData(std::string connection_name, size_t busy_threshold);
-  TriggerRecordBuilderData(std::string connection_name, size_t busy_threshold, size_t free_threshold);
+  /**
+   * @param lock_owner Module that reports the profiles of the locks, if any
+   */
+  TriggerRecordBuilderData(std::string connection_name,
+                           size_t busy_threshold,
+                           size_t free_threshold,
+                           const std::string& lock_owner = "");
 
   TriggerRecordBuilderData(TriggerRecordBuilderData const&) = delete;
   TriggerRecordBuilderData(TriggerRecordBuilderData&&);
@@ -82,13 +113,22 @@ public:
 
   std::shared_ptr<AssignedTriggerDecision> get_assignment(daqdataformats::trigger_number_t trigger_number) const;
   std::shared_ptr<AssignedTriggerDecision> extract_assignment(daqdataformats::trigger_number_t trigger_number);
-  std::shared_ptr<AssignedTriggerDecision> make_assignment(dfmessages::TriggerDecision decision);
+  /**
+   * @brief Make an assignment from the pool, taking over the decision
+   */
+  std::shared_ptr<AssignedTriggerDecision> make_assignment(dfmessages::TriggerDecision&& decision);
+  /**
+   * @brief Make an assignment from the pool with a copy of the decision, which reuses the memory of the pooled one
+   */
+  std::shared_ptr<AssignedTriggerDecision> make_assignment(const dfmessages::TriggerDecision& decision);
   void add_assignment(std::shared_ptr<AssignedTriggerDecision> assignment);
-  std::shared_ptr<AssignedTriggerDecision> complete_assignment(
-    daqdataformats::trigger_number_t trigger_number,
-    std::function<void(nlohmann::json&)> metadata_fun = nullptr);
+  std::shared_ptr<AssignedTriggerDecision> complete_assignment(daqdataformats::trigger_number_t trigger_number,
+                                                               metadata_function_t metadata_fun = nullptr);
   std::list<std::shared_ptr<AssignedTriggerDecision>> flush();
 
+  TriggerRecordBuilderMetadata get_metadata() const;
+  size_t pool_size() const;
+
   void get_info(opmonlib::InfoCollector& ci, int level);
 
   std::chrono::microseconds average_latency(std::chrono::steady_clock::time_point since) const;
@@ -97,20 +137,31 @@ public:
   void set_in_error(bool err) { m_in_error = err; }
 
 private:
+  std::shared_ptr<AssignedTriggerDecision> acquire_assignment();
+
   std::atomic<size_t> m_busy_threshold{ 0 };
   std::atomic<size_t> m_free_threshold{ std::numeric_limits<size_t>::max() };
   std::atomic<bool> m_is_busy{ false };
-  std::list<std::shared_ptr<AssignedTriggerDecision>> m_assigned_trigger_decisions;
-  mutable std::mutex m_assigned_trigger_decisions_mutex;
+  std::vector<std::shared_ptr<AssignedTriggerDecision>> m_assigned_trigger_decisions; ///< In assignment order
+  mutable InstrumentedMutex m_assigned_trigger_decisions_mutex{ "TriggerRecordBuilderData.assigned_trigger_decisions" };
+
+  // Assignments made so far; an assignment is reused once the pool holds the only reference to it,
+  // so the pool only grows until it covers the largest number of assignments in flight
+  std::vector<std::shared_ptr<AssignedTriggerDecision>> m_assignment_pool;
+  size_t m_next_pool_entry{ 0 };
 
-  // TODO: Eric Flumerfelt <eflumerf@github.com> Dec-03-2021: Replace with circular buffer
-  std::list<std::pair<std::chrono::steady_clock::time_point, std::chrono::microseconds>> m_latency_info;
-  mutable std::mutex m_latency_info_mutex;
+  // Circular buffer of the latest completion latencies
+  static constexpr size_t s_latency_info_size = 1000;
+  std::vector<std::pair<std::chrono::steady_clock::time_point, std::chrono::microseconds>> m_latency_info;
+  size_t m_latency_info_next{ 0 };
+  size_t m_latency_info_count{ 0 };
+  mutable InstrumentedMutex m_latency_info_mutex{ "TriggerRecordBuilderData.latency_info" };
 
   std::atomic<bool> m_in_error{ true };
 
-  nlohmann::json m_metadata;
+  TriggerRecordBuilderMetadata m_metadata; ///< Protected by m_latency_info_mutex
   std::string m_connection_name{ "" };
+  std::string m_lock_owner;
 
   // monitoring
   std::atomic<uint64_t> m_complete_counter{ 0 }, m_complete_microsecond{ 0 };
@@ -0,0 +1,69 @@
+/**
+ * @file WorkerPool.hpp WorkerPool Class
+ *
+ * The WorkerPool class runs tasks on a fixed set of threads, so that work that
+ * can be split into independent pieces (e.g. per-Fragment checksums) is done in
+ * parallel, and alongside the thread that submitted it.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DFMODULES_SRC_DFMODULES_WORKERPOOL_HPP_
+#define DFMODULES_SRC_DFMODULES_WORKERPOOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+namespace dfmodules {
+
+/**
+ * @brief WorkerPool is a minimal fixed-size thread pool.
+ *
+ * Tasks are run in the order in which they are submitted; the future returned
+ * by submit() becomes ready when the task has run, and holds the exception that
+ * it may have thrown. The tasks that are still queued when the pool is destroyed
+ * are run before the threads are joined.
+ */
+class WorkerPool
+{
+public:
+  /**
+   * @param thread_count Number of threads, at least one
+   * @param name Name given to the threads, truncated to the system limit
+   */
+  WorkerPool(size_t thread_count, const std::string& name);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;            ///< WorkerPool is not copy-constructible
+  WorkerPool& operator=(const WorkerPool&) = delete; ///< WorkerPool is not copy-assignable
+  WorkerPool(WorkerPool&&) = delete;                 ///< WorkerPool is not move-constructible
+  WorkerPool& operator=(WorkerPool&&) = delete;      ///< WorkerPool is not move-assignable
+
+  std::future<void> submit(std::function<void()> task);
+
+  size_t get_thread_count() const { return m_threads.size(); }
+
+private:
+  void run();
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::packaged_task<void()>> m_tasks;
+  bool m_stopping{ false };
+  std::vector<std::thread> m_threads;
+};
+
+} // namespace dfmodules
+} // namespace dunedaq
+
+#endif // DFMODULES_SRC_DFMODULES_WORKERPOOL_HPP_
@@ -0,0 +1,494 @@
+/**
+ * @file dfmodules_microbench.cxx
+ *
+ * Microbenchmarks of the data structures on the dataflow hot paths: the TPBundleHandler
+ * of the TPStreamWriter, the TriggerRecordBuilderData of the DFO, the book of the
+ * TriggerRecordBuilder and the writes of the HDF5DataStore.
+ *
+ * Every benchmark is run for a fixed amount of work, without any randomness, once to
+ * warm up and then the requested number of times; the median, minimum and maximum
+ * time per operation are reported, so that runs on different commits of the same
+ * machine can be compared, for instance with python/dfmodules/compare_microbench.py.
+ *
+ * Usage: dfmodules_microbench [-o results.json] [-r repetitions] [-f filter] [-d hdf5 directory] [-l label]
+ * The results are printed as a table, and written as JSON to the -o file
+ * (dfmodules_microbench.json by default). Only the benchmarks whose name contains the
+ * -f filter are run. The label, typically the commit, is stored with the results.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TriggerRecordBuilder.hpp"
+
+#include "dfmodules/DataStore.hpp"
+#include "dfmodules/TPBundleHandler.hpp"
+#include "dfmodules/TriggerRecordBuilderData.hpp"
+#include "dfmodules/hdf5datastore/Nljs.hpp"
+#include "dfmodules/hdf5datastore/Structs.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+#include "daqdataformats/TriggerRecord.hpp"
+#include "detdataformats/DetID.hpp"
+#include "dfmessages/TriggerDecision.hpp"
+#include "hdf5libs/hdf5filelayout/Structs.hpp"
+#include "trigger/TPSet.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+/**
+ * @brief One run of a benchmark: the time spent in the measured code, and the number of operations it did
+ */
+struct Sample
+{
+  bench_clock::duration time{ 0 };
+  size_t operations{ 0 };
+  size_t bytes{ 0 };
+};
+
+class Runner
+{
+public:
+  Runner(int repetitions, std::string filter)
+    : m_repetitions(std::max(repetitions, 1))
+    , m_filter(std::move(filter))
+  {}
+
+  /**
+   * @brief Run a benchmark once to warm up, then the configured number of times
+   * @param body Does the work of one run, and returns the time spent in the measured part of it
+   */
+  void run(const std::string& name, const nlohmann::json& parameters, const std::function<Sample()>& body)
+  {
+    if (name.find(m_filter) == std::string::npos) {
+      return;
+    }
+    body();
+    std::vector<double> ns_per_op;
+    Sample sample;
+    for (int i = 0; i < m_repetitions; ++i) {
+      sample = body();
+      ns_per_op.push_back(std::chrono::duration<double, std::nano>(sample.time).count() /
+                          std::max<size_t>(sample.operations, 1));
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+    double median = ns_per_op[ns_per_op.size() / 2];
+
+    nlohmann::json result;
+    result["benchmark"] = name;
+    result["parameters"] = parameters;
+    result["operations"] = sample.operations;
+    result["repetitions"] = m_repetitions;
+    result["ns_per_op_median"] = median;
+    result["ns_per_op_min"] = ns_per_op.front();
+    result["ns_per_op_max"] = ns_per_op.back();
+    if (sample.bytes > 0) {
+      result["bytes_per_op"] = sample.bytes / std::max<size_t>(sample.operations, 1);
+      result["mb_per_s_median"] = sample.bytes / std::max<size_t>(sample.operations, 1) / median * 1.e3;
+    }
+    m_results.push_back(result);
+
+    std::cout << std::left << std::setw(32) << name << std::setw(56) << parameters.dump() << std::right << std::fixed
+              << std::setprecision(1) << std::setw(14) << median << std::setw(14) << ns_per_op.front()
+              << std::setw(14) << ns_per_op.back() << std::endl;
+  }
+
+  const nlohmann::json& get_results() const { return m_results; }
+
+private:
+  int m_repetitions;
+  std::string m_filter;
+  nlohmann::json m_results = nlohmann::json::array();
+};
+
+// TPBundleHandler
+
+trigger::TPSet
+create_tpset(daqdataformats::timestamp_t start_time,
+             daqdataformats::timestamp_t duration,
+             size_t tp_count,
+             uint32_t source_id, // NOLINT(build/unsigned)
+             uint64_t seqno)     // NOLINT(build/unsigned)
+{
+  trigger::TPSet tpset;
+  tpset.type = trigger::TPSet::Type::kPayload;
+  tpset.seqno = seqno;
+  tpset.origin = daqdataformats::SourceID(daqdataformats::SourceID::Subsystem::kTrigger, source_id);
+  tpset.run_number = 1;
+  tpset.start_time = start_time;
+  tpset.end_time = start_time + duration;
+  tpset.objects.resize(tp_count);
+  for (size_t i = 0; i < tp_count; ++i) {
+    tpset.objects[i].time_start = start_time + i * duration / tp_count;
+    tpset.objects[i].channel = i;
+  }
+  return tpset;
+}
+
+void
+benchmark_tpbundle_handler(Runner& runner)
+{
+  constexpr daqdataformats::timestamp_t tpset_duration = 5000;
+  constexpr uint32_t source_count = 4; // NOLINT(build/unsigned)
+  constexpr size_t tpsets_per_source = 500;
+
+  for (size_t tp_count : { 10, 100, 1000 }) {
+    for (daqdataformats::timestamp_t slice_interval : { 10000, 100000, 1000000 }) {
+      nlohmann::json parameters = { { "tps_per_set", tp_count },
+                                    { "slice_interval", slice_interval },
+                                    { "tpsets", source_count * tpsets_per_source } };
+
+      // the TPSets are built beforehand, and copied outside of the measured part
+      std::vector<trigger::TPSet> tpsets;
+      for (size_t i = 0; i < tpsets_per_source; ++i) {
+        for (uint32_t source = 0; source < source_count; ++source) { // NOLINT(build/unsigned)
+          tpsets.push_back(create_tpset(1000000 + i * tpset_duration, tpset_duration, tp_count, source, i));
+        }
+      }
+
+      runner.run("tpbundle_add_tpset", parameters, [&]() {
+        TPBundleHandler handler(slice_interval, 1, std::chrono::seconds(0));
+        auto copies = tpsets;
+        Sample sample;
+        auto start = bench_clock::now();
+        for (auto& tpset : copies) {
+          handler.add_tpset(std::move(tpset));
+        }
+        sample.time = bench_clock::now() - start;
+        sample.operations = copies.size();
+        return sample;
+      });
+
+      runner.run("tpbundle_get_aged_timeslices", parameters, [&]() {
+        TPBundleHandler handler(slice_interval, 1, std::chrono::seconds(0));
+        auto copies = tpsets;
+        for (auto& tpset : copies) {
+          handler.add_tpset(std::move(tpset));
+        }
+        Sample sample;
+        auto start = bench_clock::now();
+        auto timeslices = handler.get_properly_aged_timeslices();
+        sample.time = bench_clock::now() - start;
+        sample.operations = timeslices.size();
+        for (const auto& timeslice : timeslices) {
+          sample.bytes += timeslice->get_total_size_bytes();
+        }
+        return sample;
+      });
+    }
+  }
+}
+
+// TriggerRecordBuilderData
+
+void
+benchmark_trigger_record_builder_data(Runner& runner)
+{
+  constexpr size_t cycles = 100000;
+
+  for (size_t depth : { 1, 10, 100, 1000 }) {
+    nlohmann::json parameters = { { "in_flight", depth }, { "cycles", cycles } };
+
+    runner.run("trbd_assign_complete", parameters, [&]() {
+      TriggerRecordBuilderData trbd("a_dataflow_application_connection", 2 * depth);
+      dfmessages::TriggerDecision decision;
+      decision.run_number = 1;
+      decision.readout_type = dfmessages::ReadoutType::kLocalized;
+      decision.components.resize(10);
+
+      daqdataformats::trigger_number_t next_trigger = 1;
+      for (; next_trigger <= depth; ++next_trigger) {
+        decision.trigger_number = next_trigger;
+        trbd.add_assignment(trbd.make_assignment(decision));
+      }
+
+      // each cycle completes the oldest assignment and adds a new one, at constant depth
+      Sample sample;
+      auto start = bench_clock::now();
+      for (size_t i = 0; i < cycles; ++i, ++next_trigger) {
+        decision.trigger_number = next_trigger;
+        trbd.add_assignment(trbd.make_assignment(decision));
+        trbd.complete_assignment(next_trigger - depth);
+      }
+      sample.time = bench_clock::now() - start;
+      sample.operations = cycles;
+      return sample;
+    });
+  }
+}
+
+// TriggerRecordBuilder book
+
+std::unique_ptr<daqdataformats::TriggerRecord>
+create_empty_trigger_record(daqdataformats::trigger_number_t trigger_number, size_t fragment_count)
+{
+  daqdataformats::TriggerRecordHeaderData trh_data;
+  trh_data.trigger_number = trigger_number;
+  trh_data.trigger_timestamp = trigger_number * 1000;
+  trh_data.num_requested_components = fragment_count;
+  trh_data.run_number = 1;
+  trh_data.sequence_number = 0;
+  trh_data.max_sequence_number = 0;
+  trh_data.element_id = daqdataformats::SourceID(daqdataformats::SourceID::Subsystem::kTRBuilder, 0);
+  daqdataformats::TriggerRecordHeader trh(&trh_data);
+  return std::make_unique<daqdataformats::TriggerRecord>(trh);
+}
+
+std::unique_ptr<daqdataformats::Fragment>
+create_fragment(daqdataformats::trigger_number_t trigger_number, uint32_t element, size_t size) // NOLINT
+{
+  std::vector<char> dummy_data(size);
+  daqdataformats::FragmentHeader fh;
+  fh.trigger_number = trigger_number;
+  fh.trigger_timestamp = trigger_number * 1000;
+  fh.window_begin = fh.trigger_timestamp - 10;
+  fh.window_end = fh.trigger_timestamp;
+  fh.run_number = 1;
+  fh.sequence_number = 0;
+  fh.fragment_type = static_cast<daqdataformats::fragment_type_t>(daqdataformats::FragmentType::kWIB);
+  fh.detector_id = static_cast<uint16_t>(detdataformats::DetID::Subdetector::kHD_TPC);
+  fh.element_id = daqdataformats::SourceID(daqdataformats::SourceID::Subsystem::kDetectorReadout, element);
+  auto fragment = std::make_unique<daqdataformats::Fragment>(dummy_data.data(), dummy_data.size());
+  fragment->set_header_fields(fh);
+  return fragment;
+}
+
+void
+benchmark_trigger_record_book(Runner& runner)
+{
+  constexpr size_t fragment_count = 10;
+  constexpr size_t records = 20000;
+  constexpr size_t stale_check_interval = 100;
+
+  for (size_t depth : { 100, 1000, 5000, 20000 }) {
+    nlohmann::json parameters = {
+      { "in_flight", depth }, { "fragments_per_record", fragment_count }, { "records", records }
+    };
+
+    runner.run("trb_book_cycle", parameters, [&]() {
+      // the Fragments are built beforehand: the TRB receives them ready-made
+      std::vector<std::unique_ptr<daqdataformats::Fragment>> fragments;
+      fragments.reserve(records * fragment_count);
+      for (size_t trigger = 1; trigger <= records; ++trigger) {
+        for (uint32_t element = 0; element < fragment_count; ++element) { // NOLINT(build/unsigned)
+          fragments.push_back(create_fragment(trigger, element, 64));
+        }
+      }
+
+      TriggerRecordBuilder::trigger_record_book_t book;
+      auto make_id = [](daqdataformats::trigger_number_t trigger_number) {
+        TriggerId id;
+        id.trigger_number = trigger_number;
+        id.sequence_number = 0;
+        id.run_number = 1;
+        return id;
+      };
+      for (daqdataformats::trigger_number_t trigger = 1; trigger <= depth; ++trigger) {
+        book[make_id(trigger)] = std::make_pair(TriggerRecordBuilder::clock_type::now(),
+                                                create_empty_trigger_record(trigger, fragment_count));
+      }
+
+      // each cycle books a new record, fills the oldest one, extracts it, and sometimes
+      // scans the book for stale records, as the TRB does
+      size_t stale_count = 0;
+      Sample sample;
+      auto start = bench_clock::now();
+      for (size_t trigger = depth + 1; trigger <= records + depth; ++trigger) {
+        book[make_id(trigger)] = std::make_pair(TriggerRecordBuilder::clock_type::now(),
+                                                create_empty_trigger_record(trigger, fragment_count));
+
+        auto oldest = trigger - depth;
+        for (size_t element = 0; element < fragment_count; ++element) {
+          auto& fragment = fragments[(oldest - 1) * fragment_count + element];
+          auto it = book.find(make_id(fragment->get_trigger_number()));
+          it->second.second->add_fragment(std::move(fragment));
+        }
+        auto it = book.find(make_id(oldest));
+        auto record = std::move(it->second.second);
+        book.erase(it);
+
+        if (trigger % stale_check_interval == 0) {
+          auto now = TriggerRecordBuilder::clock_type::now();
+          for (const auto& [id, entry] : book) {
+            if (now - entry.first > std::chrono::hours(1)) {
+              ++stale_count;
+            }
+          }
+        }
+      }
+      sample.time = bench_clock::now() - start;
+      sample.operations = records;
+      if (stale_count > 0) {
+        std::cerr << "Unexpected stale records in the book" << std::endl;
+      }
+      return sample;
+    });
+  }
+}
+
+// HDF5DataStore
+
+hdf5libs::hdf5filelayout::FileLayoutParams
+create_file_layout_params()
+{
+  hdf5libs::hdf5filelayout::PathParams params;
+  params.detector_group_type = "Detector_Readout";
+  params.detector_group_name = "TPC";
+  params.element_name_prefix = "Link";
+  params.digits_for_element_number = 5;
+
+  hdf5libs::hdf5filelayout::FileLayoutParams layout_params;
+  layout_params.digits_for_record_number = 6;
+  layout_params.path_param_list.push_back(params);
+  return layout_params;
+}
+
+void
+benchmark_hdf5_data_store(Runner& runner, const std::string& output_path)
+{
+  constexpr size_t fragment_count = 10;
+  constexpr size_t bytes_per_run = 64 * 1024 * 1024;
+
+  for (std::string mode : { "all-per-file", "one-event-per-file" }) {
+    for (size_t fragment_size : { 1024, 102400, 1048576 }) {
+      size_t record_count = std::max<size_t>(bytes_per_run / (fragment_count * fragment_size), 10);
+      if (mode == "one-event-per-file") {
+        record_count = std::min<size_t>(record_count, 1000);
+      }
+      nlohmann::json parameters = { { "mode", mode },
+                                    { "fragments_per_record", fragment_count },
+                                    { "fragment_size", fragment_size },
+                                    { "records", record_count } };
+
+      runner.run("hdf5_write", parameters, [&]() {
+        std::string prefix = "microbench" + std::to_string(getpid());
+
+        hdf5datastore::ConfParams config_params;
+        config_params.name = "microbench";
+        config_params.directory_path = output_path;
+        config_params.mode = mode;
+        config_params.max_file_size_bytes = std::numeric_limits<uint64_t>::max() / 2; // NOLINT(build/unsigned)
+        config_params.disable_unique_filename_suffix = true;
+        config_params.filename_parameters.overall_prefix = prefix;
+        config_params.filename_parameters.writer_identifier = "microbench";
+        config_params.file_layout_parameters = create_file_layout_params();
+        hdf5datastore::data_t hdf5ds_json;
+        hdf5datastore::to_json(hdf5ds_json, config_params);
+
+        std::unique_ptr<DataStore> data_store = make_data_store(hdf5ds_json);
+        data_store->prepare_for_run(1);
+
+        Sample sample;
+        for (size_t trigger = 1; trigger <= record_count; ++trigger) {
+          auto record = create_empty_trigger_record(trigger, fragment_count);
+          for (uint32_t element = 0; element < fragment_count; ++element) { // NOLINT(build/unsigned)
+            record->add_fragment(create_fragment(trigger, element, fragment_size));
+          }
+          sample.bytes += record->get_total_size_bytes();
+          auto start = bench_clock::now();
+          data_store->write(*record);
+          sample.time += bench_clock::now() - start;
+        }
+        auto start = bench_clock::now();
+        data_store->finish_with_run(1);
+        data_store.reset();
+        sample.time += bench_clock::now() - start;
+        sample.operations = record_count;
+
+        for (const auto& entry : std::filesystem::directory_iterator(output_path)) {
+          if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+            std::filesystem::remove(entry.path());
+          }
+        }
+        return sample;
+      });
+    }
+  }
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  std::string output_file = "dfmodules_microbench.json";
+  int repetitions = 5;
+  std::string filter;
+  std::string hdf5_path = std::filesystem::temp_directory_path().string();
+  std::string label;
+
+  int option;
+  while ((option = getopt(argc, argv, "o:r:f:d:l:")) != -1) {
+    switch (option) {
+      case 'o':
+        output_file = optarg;
+        break;
+      case 'r':
+        repetitions = std::atoi(optarg);
+        break;
+      case 'f':
+        filter = optarg;
+        break;
+      case 'd':
+        hdf5_path = optarg;
+        break;
+      case 'l':
+        label = optarg;
+        break;
+      default:
+        std::cerr << "Usage: " << argv[0]
+                  << " [-o results.json] [-r repetitions] [-f filter] [-d hdf5 directory] [-l label]" << std::endl;
+        return 1;
+    }
+  }
+
+  std::cout << std::left << std::setw(32) << "benchmark" << std::setw(56) << "parameters" << std::right
+            << std::setw(14) << "median ns/op" << std::setw(14) << "min ns/op" << std::setw(14) << "max ns/op"
+            << std::endl;
+
+  Runner runner(repetitions, filter);
+  benchmark_tpbundle_handler(runner);
+  benchmark_trigger_record_builder_data(runner);
+  benchmark_trigger_record_book(runner);
+  benchmark_hdf5_data_store(runner, hdf5_path);
+
+  char host_name[256] = "";
+  gethostname(host_name, sizeof(host_name) - 1);
+  nlohmann::json output;
+  output["label"] = label;
+  output["host"] = host_name;
+  output["repetitions"] = repetitions;
+  output["results"] = runner.get_results();
+
+  std::ofstream ofs(output_file);
+  ofs << output.dump(2) << std::endl;
+  if (!ofs) {
+    std::cerr << "Unable to write the results to " << output_file << std::endl;
+    return 1;
+  }
+  return 0;
+}
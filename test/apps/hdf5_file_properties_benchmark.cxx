@@ -0,0 +1,217 @@
+/**
+ * @file hdf5_file_properties_benchmark.cxx
+ *
+ * Writes the same sequence of TriggerRecords with the HDF5DataStore once for each
+ * of a set of HDF5 file property configurations, and reports the write rate and the
+ * metadata overhead (file size beyond the TriggerRecord bytes) of each configuration.
+ *
+ * Usage: hdf5_file_properties_benchmark <output directory> [records] [fragments per record] [fragment size]
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/DataStore.hpp"
+#include "dfmodules/hdf5datastore/Nljs.hpp"
+#include "dfmodules/hdf5datastore/Structs.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+#include "daqdataformats/TriggerRecord.hpp"
+#include "detdataformats/DetID.hpp"
+#include "hdf5libs/hdf5filelayout/Structs.hpp"
+#include "hdf5libs/hdf5rawdatafile/Structs.hpp"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq;
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+struct BenchmarkConfig
+{
+  std::string name;
+  hdf5datastore::FileProperties properties;
+};
+
+std::vector<BenchmarkConfig>
+make_benchmark_configs()
+{
+  std::vector<BenchmarkConfig> configs;
+  hdf5datastore::FileProperties props;
+  configs.push_back({ "library_defaults", props });
+
+  props = hdf5datastore::FileProperties();
+  props.use_latest_format = true;
+  configs.push_back({ "latest_format", props });
+
+  props = hdf5datastore::FileProperties();
+  props.metadata_cache_size_bytes = 32 * 1024 * 1024;
+  configs.push_back({ "metadata_cache_32MiB", props });
+
+  props = hdf5datastore::FileProperties();
+  props.file_space_strategy = "page";
+  props.file_space_page_size = 1024 * 1024;
+  props.page_buffer_size = 16 * 1024 * 1024;
+  configs.push_back({ "paged_1MiB_buffer_16MiB", props });
+
+  props = hdf5datastore::FileProperties();
+  props.file_space_strategy = "aggr";
+  props.meta_block_size = 1024 * 1024;
+  configs.push_back({ "aggr_meta_block_1MiB", props });
+
+  props = hdf5datastore::FileProperties();
+  props.alignment = 1024 * 1024;
+  props.alignment_threshold = 64 * 1024;
+  configs.push_back({ "alignment_1MiB", props });
+
+  props = hdf5datastore::FileProperties();
+  props.sieve_buffer_size = 4 * 1024 * 1024;
+  configs.push_back({ "sieve_buffer_4MiB", props });
+
+  props = hdf5datastore::FileProperties();
+  props.use_latest_format = true;
+  props.metadata_cache_size_bytes = 32 * 1024 * 1024;
+  props.file_space_strategy = "page";
+  props.file_space_page_size = 1024 * 1024;
+  props.page_buffer_size = 16 * 1024 * 1024;
+  configs.push_back({ "combined", props });
+
+  return configs;
+}
+
+std::unique_ptr<daqdataformats::TriggerRecord>
+create_trigger_record(int trig_num, int fragment_size, int fragment_count)
+{
+  std::vector<char> dummy_data(fragment_size);
+
+  daqdataformats::TriggerRecordHeaderData trh_data;
+  trh_data.trigger_number = trig_num;
+  trh_data.trigger_timestamp = trig_num * 1000;
+  trh_data.num_requested_components = 0;
+  trh_data.run_number = 1;
+  trh_data.sequence_number = 0;
+  trh_data.max_sequence_number = 1;
+  trh_data.element_id = daqdataformats::SourceID(daqdataformats::SourceID::Subsystem::kTRBuilder, 0);
+  daqdataformats::TriggerRecordHeader trh(&trh_data);
+
+  auto tr = std::make_unique<daqdataformats::TriggerRecord>(trh);
+  for (int ele_num = 0; ele_num < fragment_count; ++ele_num) {
+    daqdataformats::FragmentHeader fh;
+    fh.trigger_number = trig_num;
+    fh.trigger_timestamp = trh_data.trigger_timestamp;
+    fh.window_begin = fh.trigger_timestamp - 10;
+    fh.window_end = fh.trigger_timestamp;
+    fh.run_number = 1;
+    fh.sequence_number = 0;
+    fh.fragment_type = static_cast<daqdataformats::fragment_type_t>(daqdataformats::FragmentType::kWIB);
+    fh.detector_id = static_cast<uint16_t>(detdataformats::DetID::Subdetector::kHD_TPC);
+    fh.element_id = daqdataformats::SourceID(daqdataformats::SourceID::Subsystem::kDetectorReadout, ele_num);
+    auto frag_ptr = std::make_unique<daqdataformats::Fragment>(dummy_data.data(), dummy_data.size());
+    frag_ptr->set_header_fields(fh);
+    tr->add_fragment(std::move(frag_ptr));
+  }
+  return tr;
+}
+
+hdf5libs::hdf5filelayout::FileLayoutParams
+create_file_layout_params()
+{
+  hdf5libs::hdf5filelayout::PathParams params;
+  params.detector_group_type = "Detector_Readout";
+  params.detector_group_name = "TPC";
+  params.element_name_prefix = "Link";
+  params.digits_for_element_number = 5;
+
+  hdf5libs::hdf5filelayout::FileLayoutParams layout_params;
+  layout_params.digits_for_record_number = 6;
+  layout_params.path_param_list.push_back(params);
+  return layout_params;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <output directory> [records] [fragments per record] [fragment size]"
+              << std::endl;
+    return 1;
+  }
+  std::string output_path = argv[1];
+  int record_count = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int fragment_count = argc > 3 ? std::atoi(argv[3]) : 10;
+  int fragment_size = argc > 4 ? std::atoi(argv[4]) : 100000;
+
+  std::cout << "Writing " << record_count << " records of " << fragment_count << " fragments of " << fragment_size
+            << " bytes to " << output_path << std::endl;
+  std::cout << std::left << std::setw(28) << "configuration" << std::right << std::setw(12) << "records/s"
+            << std::setw(12) << "MB/s" << std::setw(16) << "file bytes" << std::setw(16) << "overhead bytes"
+            << std::setw(12) << "overhead %" << std::endl;
+
+  for (const auto& config : make_benchmark_configs()) {
+    std::string prefix = "hdf5props" + std::to_string(getpid()) + "_" + config.name;
+
+    hdf5datastore::ConfParams config_params;
+    config_params.name = "benchmark";
+    config_params.directory_path = output_path;
+    config_params.mode = "all-per-file";
+    config_params.max_file_size_bytes = std::numeric_limits<uint64_t>::max() / 2; // NOLINT(build/unsigned)
+    config_params.disable_unique_filename_suffix = true;
+    config_params.open_file_at_start = true;
+    config_params.filename_parameters.overall_prefix = prefix;
+    config_params.filename_parameters.writer_identifier = "benchmark";
+    config_params.file_layout_parameters = create_file_layout_params();
+    config_params.file_properties = config.properties;
+
+    hdf5datastore::data_t hdf5ds_json;
+    hdf5datastore::to_json(hdf5ds_json, config_params);
+
+    std::unique_ptr<DataStore> data_store = make_data_store(hdf5ds_json);
+    data_store->prepare_for_run(1);
+
+    size_t record_bytes = 0;
+    std::chrono::steady_clock::duration write_time{ 0 };
+    for (int trig_num = 1; trig_num <= record_count; ++trig_num) {
+      auto tr = create_trigger_record(trig_num, fragment_size, fragment_count);
+      record_bytes += tr->get_total_size_bytes();
+      auto start = std::chrono::steady_clock::now();
+      data_store->write(*tr);
+      write_time += std::chrono::steady_clock::now() - start;
+    }
+    auto start = std::chrono::steady_clock::now();
+    data_store->finish_with_run(1);
+    write_time += std::chrono::steady_clock::now() - start;
+    data_store.reset();
+
+    size_t file_bytes = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(output_path)) {
+      if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+        file_bytes += entry.file_size();
+        std::filesystem::remove(entry.path());
+      }
+    }
+
+    double seconds = std::chrono::duration<double>(write_time).count();
+    int64_t overhead = static_cast<int64_t>(file_bytes) - static_cast<int64_t>(record_bytes);
+    std::cout << std::left << std::setw(28) << config.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << record_count / seconds << std::setw(12) << record_bytes / seconds / 1.e6
+              << std::setw(16) << file_bytes << std::setw(16) << overhead << std::setw(12)
+              << 100. * overhead / record_bytes << std::endl;
+  }
+
+  return 0;
+}
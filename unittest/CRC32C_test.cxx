@@ -0,0 +1,69 @@
+/**
+ * @file CRC32C_test.cxx Test application that tests and demonstrates
+ * the functionality of the CRC32C class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/CRC32C.hpp"
+
+#define BOOST_TEST_MODULE CRC32C_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+BOOST_AUTO_TEST_SUITE(CRC32C_test)
+
+BOOST_AUTO_TEST_CASE(KnownValues)
+{
+  std::string check = "123456789";
+  BOOST_REQUIRE_EQUAL(CRC32C::compute(check.data(), check.size()), 0xe3069283);
+  BOOST_REQUIRE_EQUAL(CRC32C::compute_software(check.data(), check.size()), 0xe3069283);
+
+  std::vector<uint8_t> zeros(32, 0); // NOLINT(build/unsigned)
+  BOOST_REQUIRE_EQUAL(CRC32C::compute(zeros.data(), zeros.size()), 0x8a9136aa);
+  BOOST_REQUIRE_EQUAL(CRC32C::compute(nullptr, 0), 0);
+
+  BOOST_TEST_MESSAGE("Hardware support: " << CRC32C::has_hardware_support());
+}
+
+BOOST_AUTO_TEST_CASE(HardwareMatchesSoftware)
+{
+  std::mt19937 generator(12345);
+  std::vector<char> data(10000);
+  for (auto& c : data) {
+    c = static_cast<char>(generator());
+  }
+
+  // every alignment and a range of sizes, including the tails that are not a multiple of 8
+  for (size_t offset = 0; offset < 8; ++offset) {
+    for (size_t size = 0; size < 100; ++size) {
+      BOOST_REQUIRE_EQUAL(CRC32C::compute(data.data() + offset, size),
+                          CRC32C::compute_software(data.data() + offset, size));
+    }
+  }
+  BOOST_REQUIRE_EQUAL(CRC32C::compute(data.data(), data.size()), CRC32C::compute_software(data.data(), data.size()));
+}
+
+BOOST_AUTO_TEST_CASE(Incremental)
+{
+  std::string text = "The quick brown fox jumps over the lazy dog";
+  uint32_t whole = CRC32C::compute(text.data(), text.size());
+  for (size_t split = 0; split <= text.size(); ++split) {
+    uint32_t first = CRC32C::compute(text.data(), split);
+    BOOST_REQUIRE_EQUAL(CRC32C::compute(text.data() + split, text.size() - split, first), whole);
+  }
+
+  text[10] ^= 1;
+  BOOST_REQUIRE_NE(CRC32C::compute(text.data(), text.size()), whole);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/**
+ * @file FileCacheController_test.cxx Test application that tests and demonstrates
+ * the functionality of the FileCacheController class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FileCacheController.hpp"
+
+#define BOOST_TEST_MODULE FileCacheController_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+constexpr size_t s_mib = 1024 * 1024;
+
+struct TempFileFixture
+{
+  TempFileFixture()
+    : path(std::filesystem::temp_directory_path() / ("FileCacheController_test_" + std::to_string(getpid())))
+  {
+    fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  }
+  ~TempFileFixture()
+  {
+    ::close(fd);
+    std::filesystem::remove(path);
+  }
+
+  void append(size_t bytes)
+  {
+    std::vector<char> buffer(bytes, 'x');
+    BOOST_REQUIRE_EQUAL(::write(fd, buffer.data(), buffer.size()), static_cast<ssize_t>(bytes));
+  }
+
+  struct stat get_stat() const
+  {
+    struct stat file_stat;
+    BOOST_REQUIRE_EQUAL(::stat(path.c_str(), &file_stat), 0);
+    return file_stat;
+  }
+
+  std::filesystem::path path;
+  int fd;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(FileCacheController_test, TempFileFixture)
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  FileCacheController controller(filecache::FileCacheControl{});
+  BOOST_REQUIRE(controller.is_disabled());
+  controller.open(path.string(), 16 * s_mib);
+  BOOST_REQUIRE(!controller.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(PreallocateAndRelease)
+{
+  filecache::FileCacheControl conf;
+  conf.preallocate = true;
+  FileCacheController controller(conf);
+  controller.open(path.string(), 16 * s_mib);
+  BOOST_REQUIRE(controller.is_open());
+
+  if (controller.get_preallocated_bytes() == 0) {
+    BOOST_TEST_MESSAGE("fallocate is not supported by the file system of " << path << ", skipping the checks");
+    return;
+  }
+  BOOST_REQUIRE_EQUAL(get_stat().st_size, 0);
+  BOOST_REQUIRE_GE(static_cast<size_t>(get_stat().st_blocks) * 512, 16 * s_mib);
+
+  append(s_mib);
+  controller.close();
+  BOOST_REQUIRE_EQUAL(get_stat().st_size, static_cast<off_t>(s_mib));
+  BOOST_REQUIRE_LT(static_cast<size_t>(get_stat().st_blocks) * 512, 2 * s_mib);
+}
+
+BOOST_AUTO_TEST_CASE(WriteBehind)
+{
+  filecache::FileCacheControl conf;
+  conf.write_behind_bytes = s_mib;
+  conf.drop_cache = true;
+  FileCacheController controller(conf);
+  controller.open(path.string(), 0);
+
+  append(s_mib / 2);
+  controller.update();
+  BOOST_REQUIRE_EQUAL(controller.get_written_back_bytes(), 0);
+
+  // the writeback of a window is waited for once the next one is complete
+  append(s_mib);
+  controller.update();
+  BOOST_REQUIRE_EQUAL(controller.get_written_back_bytes(), 0);
+  append(5 * s_mib / 2);
+  controller.update();
+  BOOST_REQUIRE_EQUAL(controller.get_written_back_bytes(), 3 * s_mib);
+
+  controller.close();
+  BOOST_REQUIRE(!controller.is_open());
+  BOOST_REQUIRE_EQUAL(get_stat().st_size, static_cast<off_t>(4 * s_mib));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
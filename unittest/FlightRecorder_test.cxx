@@ -0,0 +1,134 @@
+/**
+ * @file FlightRecorder_test.cxx Test application that tests and demonstrates
+ * the functionality of the FlightRecorder class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FlightRecorder.hpp"
+
+#define BOOST_TEST_MODULE FlightRecorder_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+struct TempDirFixture
+{
+  TempDirFixture()
+    : path(std::filesystem::temp_directory_path() / ("FlightRecorder_test_" + std::to_string(getpid())))
+  {
+    std::filesystem::create_directories(path);
+  }
+  ~TempDirFixture() { std::filesystem::remove_all(path); }
+
+  std::vector<std::filesystem::path> dumps() const
+  {
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(path)) {
+      if (entry.path().extension() == ".json") {
+        files.push_back(entry.path());
+      }
+    }
+    return files;
+  }
+
+  flightrecorder::FlightRecorder make_conf(bool enabled) const
+  {
+    flightrecorder::FlightRecorder conf;
+    conf.enabled = enabled;
+    conf.sample_interval_ms = 1;
+    conf.history_ms = 50;
+    conf.post_anomaly_ms = 10;
+    conf.min_dump_interval_ms = 60000;
+    conf.output_path = path.string();
+    return conf;
+  }
+
+  std::filesystem::path path;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(FlightRecorder_test, TempDirFixture)
+
+BOOST_AUTO_TEST_CASE(DumpOnAnomaly)
+{
+  std::atomic<int64_t> gauge{ 0 };
+  FlightRecorder recorder("test_module");
+  recorder.add_gauge("gauge", [&]() { return gauge.load(); });
+  recorder.configure(make_conf(true));
+  recorder.start(1234);
+
+  for (int i = 0; i < 100; ++i) {
+    ++gauge;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  recorder.request_dump("first anomaly");
+  recorder.request_dump("second anomaly");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  recorder.stop();
+
+  // the second anomaly is counted, but falls within the minimum dump interval
+  BOOST_REQUIRE_EQUAL(recorder.get_anomaly_count(), 2);
+  BOOST_REQUIRE_EQUAL(recorder.get_dump_count(), 1);
+
+  auto files = dumps();
+  BOOST_REQUIRE_EQUAL(files.size(), 1);
+  BOOST_REQUIRE(files[0].filename().string().find("flightrecorder_test_module_run001234_") == 0);
+
+  std::ifstream ifs(files[0]);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  BOOST_REQUIRE(content.find("\"reason\": \"first anomaly\"") != std::string::npos);
+  BOOST_REQUIRE(content.find("\"columns\": [\"time_us\", \"gauge\"]") != std::string::npos);
+  BOOST_REQUIRE(content.find("100]") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(DumpAtStop)
+{
+  FlightRecorder recorder("test_module");
+  recorder.add_gauge("constant", []() { return 42; });
+  auto conf = make_conf(true);
+  conf.post_anomaly_ms = 60000;
+  recorder.configure(conf);
+  recorder.start(1);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  recorder.request_dump("anomaly before stop");
+  recorder.stop();
+
+  BOOST_REQUIRE_EQUAL(recorder.get_dump_count(), 1);
+  BOOST_REQUIRE_EQUAL(dumps().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(Disabled)
+{
+  FlightRecorder recorder("test_module");
+  recorder.add_gauge("constant", []() { return 42; });
+  recorder.configure(make_conf(false));
+  recorder.start(1);
+
+  recorder.request_dump("ignored");
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  recorder.stop();
+
+  BOOST_REQUIRE_EQUAL(recorder.get_anomaly_count(), 0);
+  BOOST_REQUIRE_EQUAL(recorder.get_dump_count(), 0);
+  BOOST_REQUIRE(dumps().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+/**
+ * @file FragmentLatencyTracker_test.cxx Test application that tests and demonstrates
+ * the functionality of the FragmentLatencyTracker class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/FragmentLatencyTracker.hpp"
+
+#define BOOST_TEST_MODULE FragmentLatencyTracker_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+using dunedaq::daqdataformats::ComponentRequest;
+using dunedaq::daqdataformats::SourceID;
+
+namespace {
+
+adaptivetimeout::AdaptiveTimeout
+make_conf()
+{
+  adaptivetimeout::AdaptiveTimeout conf;
+  conf.enabled = true;
+  conf.quantile = 0.9;
+  conf.safety_factor = 2.0;
+  conf.min_timeout_ms = 10;
+  conf.min_samples = 50;
+  conf.history_samples = 1000;
+  return conf;
+}
+
+const SourceID fast_source(SourceID::Subsystem::kDetectorReadout, 1);
+const SourceID slow_source(SourceID::Subsystem::kDetectorReadout, 2);
+
+std::vector<ComponentRequest>
+components_of(const std::vector<SourceID>& sources)
+{
+  std::vector<ComponentRequest> components;
+  for (const auto& source : sources) {
+    components.emplace_back(source, 0, 1);
+  }
+  return components;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(FragmentLatencyTracker_test)
+
+BOOST_AUTO_TEST_CASE(UpperBoundUntilEnoughSamples)
+{
+  FragmentLatencyTracker tracker;
+  tracker.configure(make_conf(), std::chrono::milliseconds(1000));
+  BOOST_REQUIRE(tracker.is_enabled());
+
+  for (int i = 0; i < 49; ++i) {
+    tracker.add_sample(fast_source, std::chrono::milliseconds(1));
+  }
+  BOOST_REQUIRE(!tracker.get_latency_quantile(fast_source));
+  BOOST_REQUIRE(tracker.get_timeout(components_of({ fast_source })) == std::chrono::milliseconds(1000));
+
+  tracker.add_sample(fast_source, std::chrono::milliseconds(1));
+  BOOST_REQUIRE(tracker.get_latency_quantile(fast_source));
+
+  // a component that was never seen keeps the record at the upper bound
+  BOOST_REQUIRE(tracker.get_timeout(components_of({ fast_source, slow_source })) == std::chrono::milliseconds(1000));
+}
+
+BOOST_AUTO_TEST_CASE(SlowestComponentTimesSafetyFactor)
+{
+  FragmentLatencyTracker tracker;
+  tracker.configure(make_conf(), std::chrono::milliseconds(1000));
+
+  for (int i = 0; i < 100; ++i) {
+    tracker.add_sample(fast_source, std::chrono::milliseconds(2));
+    tracker.add_sample(slow_source, std::chrono::milliseconds(i < 95 ? 40 : 500));
+  }
+
+  // the quantile is the upper edge of its bin, within 19% of the latency
+  auto slow_quantile = tracker.get_latency_quantile(slow_source);
+  BOOST_REQUIRE(slow_quantile);
+  BOOST_REQUIRE(*slow_quantile >= std::chrono::milliseconds(40));
+  BOOST_REQUIRE(*slow_quantile <= std::chrono::microseconds(47600));
+
+  auto timeout = tracker.get_timeout(components_of({ fast_source, slow_source }));
+  BOOST_REQUIRE(timeout == std::chrono::microseconds(2 * slow_quantile->count()));
+
+  // the fast source alone is bounded from below
+  BOOST_REQUIRE(tracker.get_timeout(components_of({ fast_source })) == std::chrono::milliseconds(10));
+}
+
+BOOST_AUTO_TEST_CASE(FollowsLatencyChanges)
+{
+  FragmentLatencyTracker tracker;
+  tracker.configure(make_conf(), std::chrono::milliseconds(1000));
+
+  for (int i = 0; i < 1000; ++i) {
+    tracker.add_sample(slow_source, std::chrono::milliseconds(20));
+  }
+  auto before = tracker.get_timeout(components_of({ slow_source }));
+
+  for (int i = 0; i < 1000; ++i) {
+    tracker.add_sample(slow_source, std::chrono::milliseconds(200));
+  }
+  auto after = tracker.get_timeout(components_of({ slow_source }));
+  BOOST_REQUIRE(before < std::chrono::milliseconds(50));
+
+  // the weight of the first latencies has been halved, so they are out of the quantile
+  BOOST_REQUIRE(after >= std::chrono::milliseconds(400));
+  BOOST_REQUIRE(after < std::chrono::milliseconds(1000));
+
+  tracker.reset();
+  BOOST_REQUIRE(!tracker.get_latency_quantile(slow_source));
+}
+
+BOOST_AUTO_TEST_CASE(InvalidConfiguration)
+{
+  FragmentLatencyTracker tracker;
+  BOOST_REQUIRE_THROW(tracker.configure(make_conf(), std::chrono::milliseconds(0)), InvalidAdaptiveTimeout);
+
+  auto conf = make_conf();
+  conf.quantile = 1.5;
+  BOOST_REQUIRE_THROW(tracker.configure(conf, std::chrono::milliseconds(1000)), InvalidAdaptiveTimeout);
+
+  conf = make_conf();
+  conf.safety_factor = 0.5;
+  BOOST_REQUIRE_THROW(tracker.configure(conf, std::chrono::milliseconds(1000)), InvalidAdaptiveTimeout);
+
+  conf = make_conf();
+  conf.min_timeout_ms = 2000;
+  BOOST_REQUIRE_THROW(tracker.configure(conf, std::chrono::milliseconds(1000)), InvalidAdaptiveTimeout);
+
+  conf.enabled = false;
+  BOOST_REQUIRE_NO_THROW(tracker.configure(conf, std::chrono::milliseconds(0)));
+  BOOST_REQUIRE(!tracker.is_enabled());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
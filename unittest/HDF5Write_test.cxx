@@ -8,6 +8,8 @@
  */
 
 #include "dfmodules/DataStore.hpp"
+#include "dfmodules/FragmentChecksums.hpp"
+#include "dfmodules/TriggerManifest.hpp"
 #include "dfmodules/hdf5datastore/Nljs.hpp"
 #include "dfmodules/hdf5datastore/Structs.hpp"
 
@@ -20,6 +22,10 @@
 
 #include "boost/test/unit_test.hpp"
 
+#include "hdf5.h"
+
+#include <sys/stat.h>
+
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
@@ -368,6 +374,61 @@ BOOST_AUTO_TEST_CASE(FileSizeLimitResultsInMultipleFiles)
   BOOST_REQUIRE_EQUAL(file_list.size(), 3);
 }
 
+BOOST_AUTO_TEST_CASE(BackgroundFinalization)
+{
+  std::string file_path(std::filesystem::temp_directory_path());
+  std::string file_prefix = "demo" + std::to_string(getpid()) + "_" + std::string(getenv("USER"));
+
+  const int trigger_count = 15;
+  const int apa_count = 5;
+  const int link_count = 10;
+  const int fragment_size = 10000;
+
+  // Make a hardware map
+  auto srcid_geoid_map = make_srcgeoid_map(apa_count, link_count);
+
+  // delete any pre-existing files so that we start with a clean slate
+  std::string delete_pattern = file_prefix + ".*\\.hdf5.*";
+  delete_files_matching_pattern(file_path, delete_pattern);
+
+  // create the DataStore
+  hdf5datastore::ConfParams config_params;
+  config_params.name = "tempWriter";
+  config_params.directory_path = file_path;
+  config_params.mode = "all-per-file";
+  config_params.max_file_size_bytes = 3000000; // goal is 6 events per file
+  config_params.filename_parameters.overall_prefix = file_prefix;
+  config_params.filename_parameters.writer_identifier = "HDF5Write_test";
+  config_params.file_layout_parameters = create_file_layout_params();
+  config_params.srcid_geoid_map = srcid_geoid_map;
+  config_params.background_finalization = true;
+
+  hdf5datastore::data_t hdf5ds_json;
+  hdf5datastore::to_json(hdf5ds_json, config_params);
+
+  std::unique_ptr<DataStore> data_store_ptr;
+  data_store_ptr = make_data_store(hdf5ds_json);
+
+  // write several events, each with several fragments; the full files are finalized in the background
+  data_store_ptr->prepare_for_run(1);
+  for (int trigger_number = 1; trigger_number <= trigger_count; ++trigger_number)
+    data_store_ptr->write(create_trigger_record(trigger_number, fragment_size, apa_count * link_count));
+  data_store_ptr->finish_with_run(1);
+
+  data_store_ptr.reset(); // explicit destruction, which waits for the finalizations
+
+  // check that the expected number of files was created, and that all of them were renamed
+  std::vector<std::string> file_list = get_files_matching_pattern(file_path, file_prefix + ".*\\.hdf5");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 3);
+  file_list = get_files_matching_pattern(file_path, file_prefix + ".*\\.writing");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 0);
+
+  // clean up the files that were created
+  file_list = delete_files_matching_pattern(file_path, delete_pattern);
+  delete_files_matching_pattern(file_path, "HardwareMap.*\\.txt");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 3);
+}
+
 BOOST_AUTO_TEST_CASE(SmallFileSizeLimitDataBlockListWrite)
 {
   std::string file_path(std::filesystem::temp_directory_path());
@@ -422,4 +483,283 @@ BOOST_AUTO_TEST_CASE(SmallFileSizeLimitDataBlockListWrite)
   BOOST_REQUIRE_EQUAL(file_list.size(), 5);
 }
 
+BOOST_AUTO_TEST_CASE(WriteOneFileWithFileProperties)
+{
+  std::string file_path(std::filesystem::temp_directory_path());
+  std::string file_prefix = "demo" + std::to_string(getpid()) + "_" + std::string(getenv("USER"));
+
+  const int trigger_count = 5;
+  const int apa_count = 3;
+  const int link_count = 1;
+  const int fragment_size = 10000;
+
+  // Make a hardware map
+  auto srcid_geoid_map = make_srcgeoid_map(apa_count, link_count);
+
+  // delete any pre-existing files so that we start with a clean slate
+  std::string delete_pattern = file_prefix + ".*\\.hdf5";
+  delete_files_matching_pattern(file_path, delete_pattern);
+
+  // create the DataStore
+  hdf5datastore::ConfParams config_params;
+  config_params.name = "tempWriter";
+  config_params.directory_path = file_path;
+  config_params.mode = "all-per-file";
+  config_params.max_file_size_bytes = 100000000; // much larger than what we expect, so no second file;
+  config_params.filename_parameters.overall_prefix = file_prefix;
+  config_params.filename_parameters.writer_identifier = "HDF5Write_test";
+  config_params.file_layout_parameters = create_file_layout_params();
+  config_params.srcid_geoid_map = srcid_geoid_map;
+  config_params.file_properties.file_space_strategy = "page";
+  config_params.file_properties.file_space_page_size = 65536;
+  config_params.file_properties.page_buffer_size = 1048576;
+  config_params.file_properties.metadata_cache_size_bytes = 8388608;
+  config_params.file_properties.use_latest_format = true;
+
+  hdf5datastore::data_t hdf5ds_json;
+  hdf5datastore::to_json(hdf5ds_json, config_params);
+
+  std::unique_ptr<DataStore> data_store_ptr;
+  data_store_ptr = make_data_store(hdf5ds_json);
+
+  // write several events, each with several fragments
+  for (int trigger_number = 1; trigger_number <= trigger_count; ++trigger_number)
+    data_store_ptr->write(create_trigger_record(trigger_number, fragment_size, apa_count * link_count));
+
+  data_store_ptr.reset(); // explicit destruction
+
+  // check that a single, complete file was created with the configured creation properties
+  std::string search_pattern = file_prefix + ".*\\.hdf5";
+  std::vector<std::string> file_list = get_files_matching_pattern(file_path, search_pattern);
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+  BOOST_REQUIRE_EQUAL(get_files_matching_pattern(file_path, file_prefix + ".*\\.writing").size(), 0);
+
+  hid_t file_id = H5Fopen(file_list[0].c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  BOOST_REQUIRE(file_id >= 0);
+  hid_t fcpl = H5Fget_create_plist(file_id);
+  H5F_fspace_strategy_t strategy;
+  hbool_t persist;
+  hsize_t threshold;
+  hsize_t page_size;
+  H5Pget_file_space_strategy(fcpl, &strategy, &persist, &threshold);
+  H5Pget_file_space_page_size(fcpl, &page_size);
+  H5Pclose(fcpl);
+  H5Fclose(file_id);
+  BOOST_REQUIRE_EQUAL(strategy, H5F_FSPACE_STRATEGY_PAGE);
+  BOOST_REQUIRE_EQUAL(page_size, 65536);
+
+  // clean up the files that were created
+  file_list = delete_files_matching_pattern(file_path, delete_pattern);
+  delete_files_matching_pattern(file_path, "HardwareMap.*\\.txt");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(WriteOneFileWithFileCacheControl)
+{
+  std::string file_path(std::filesystem::temp_directory_path());
+  std::string file_prefix = "demo" + std::to_string(getpid()) + "_" + std::string(getenv("USER"));
+
+  const int trigger_count = 5;
+  const int apa_count = 3;
+  const int link_count = 1;
+  const int fragment_size = 10000;
+
+  // Make a hardware map
+  auto srcid_geoid_map = make_srcgeoid_map(apa_count, link_count);
+
+  // delete any pre-existing files so that we start with a clean slate
+  std::string delete_pattern = file_prefix + ".*\\.hdf5";
+  delete_files_matching_pattern(file_path, delete_pattern);
+
+  // create the DataStore
+  hdf5datastore::ConfParams config_params;
+  config_params.name = "tempWriter";
+  config_params.directory_path = file_path;
+  config_params.mode = "all-per-file";
+  config_params.max_file_size_bytes = 100000000; // much larger than what we expect, so no second file;
+  config_params.filename_parameters.overall_prefix = file_prefix;
+  config_params.filename_parameters.writer_identifier = "HDF5Write_test";
+  config_params.file_layout_parameters = create_file_layout_params();
+  config_params.srcid_geoid_map = srcid_geoid_map;
+  config_params.file_cache.preallocate = true;
+  config_params.file_cache.write_behind_bytes = 32768;
+  config_params.file_cache.drop_cache = true;
+
+  hdf5datastore::data_t hdf5ds_json;
+  hdf5datastore::to_json(hdf5ds_json, config_params);
+
+  std::unique_ptr<DataStore> data_store_ptr;
+  data_store_ptr = make_data_store(hdf5ds_json);
+
+  // write several events, each with several fragments
+  for (int trigger_number = 1; trigger_number <= trigger_count; ++trigger_number)
+    data_store_ptr->write(create_trigger_record(trigger_number, fragment_size, apa_count * link_count));
+
+  data_store_ptr.reset(); // explicit destruction
+
+  // check that a single file was created, and that the space reserved for it has been released
+  std::string search_pattern = file_prefix + ".*\\.hdf5";
+  std::vector<std::string> file_list = get_files_matching_pattern(file_path, search_pattern);
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+
+  struct stat file_stat;
+  BOOST_REQUIRE_EQUAL(stat(file_list[0].c_str(), &file_stat), 0);
+  BOOST_REQUIRE_GT(file_stat.st_size, trigger_count * apa_count * link_count * fragment_size);
+  BOOST_REQUIRE_LT(static_cast<size_t>(file_stat.st_blocks) * 512, 2 * static_cast<size_t>(file_stat.st_size) + 65536);
+
+  // clean up the files that were created
+  file_list = delete_files_matching_pattern(file_path, delete_pattern);
+  delete_files_matching_pattern(file_path, "HardwareMap.*\\.txt");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(WriteOneFileWithFragmentChecksums)
+{
+  std::string file_path(std::filesystem::temp_directory_path());
+  std::string file_prefix = "demo" + std::to_string(getpid()) + "_" + std::string(getenv("USER"));
+
+  const int trigger_count = 5;
+  const int apa_count = 3;
+  const int link_count = 1;
+  const int fragment_size = 10000;
+
+  // Make a hardware map
+  auto srcid_geoid_map = make_srcgeoid_map(apa_count, link_count);
+
+  // delete any pre-existing files so that we start with a clean slate
+  std::string delete_pattern = file_prefix + ".*\\.hdf5";
+  delete_files_matching_pattern(file_path, delete_pattern);
+
+  // create the DataStore
+  hdf5datastore::ConfParams config_params;
+  config_params.name = "tempWriter";
+  config_params.directory_path = file_path;
+  config_params.mode = "all-per-file";
+  config_params.max_file_size_bytes = 100000000; // much larger than what we expect, so no second file;
+  config_params.filename_parameters.overall_prefix = file_prefix;
+  config_params.filename_parameters.writer_identifier = "HDF5Write_test";
+  config_params.file_layout_parameters = create_file_layout_params();
+  config_params.srcid_geoid_map = srcid_geoid_map;
+  config_params.fragment_checksum_threads = 2;
+
+  hdf5datastore::data_t hdf5ds_json;
+  hdf5datastore::to_json(hdf5ds_json, config_params);
+
+  std::unique_ptr<DataStore> data_store_ptr;
+  data_store_ptr = make_data_store(hdf5ds_json);
+
+  // write several events, each with several fragments
+  for (int trigger_number = 1; trigger_number <= trigger_count; ++trigger_number)
+    data_store_ptr->write(create_trigger_record(trigger_number, fragment_size, apa_count * link_count));
+
+  data_store_ptr.reset(); // explicit destruction
+
+  // check that each record of the file has the checksums of its fragments
+  std::string search_pattern = file_prefix + ".*\\.hdf5";
+  std::vector<std::string> file_list = get_files_matching_pattern(file_path, search_pattern);
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+
+  hid_t file_id = H5Fopen(file_list[0].c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  BOOST_REQUIRE(file_id >= 0);
+  std::vector<std::string> record_names;
+  H5Literate(
+    file_id,
+    H5_INDEX_NAME,
+    H5_ITER_INC,
+    nullptr,
+    [](hid_t, const char* name, const H5L_info_t*, void* data) -> herr_t {
+      static_cast<std::vector<std::string>*>(data)->push_back(name);
+      return 0;
+    },
+    &record_names);
+  BOOST_REQUIRE_EQUAL(record_names.size(), trigger_count);
+  for (const auto& record_name : record_names) {
+    hid_t group_id = H5Gopen2(file_id, record_name.c_str(), H5P_DEFAULT);
+    std::vector<FragmentChecksum> checksums;
+    BOOST_REQUIRE(FragmentChecksums::read_attribute(group_id, checksums));
+    BOOST_REQUIRE_EQUAL(checksums.size(), apa_count * link_count);
+    H5Gclose(group_id);
+  }
+  H5Fclose(file_id);
+
+  // clean up the files that were created
+  file_list = delete_files_matching_pattern(file_path, delete_pattern);
+  delete_files_matching_pattern(file_path, "HardwareMap.*\\.txt");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(WriteTriggerManifest)
+{
+  std::string file_path(std::filesystem::temp_directory_path());
+  std::string file_prefix = "demo" + std::to_string(getpid()) + "_" + std::string(getenv("USER"));
+
+  const int trigger_count = 5;
+  const int apa_count = 3;
+  const int link_count = 1;
+  const int fragment_size = 10000;
+
+  // Make a hardware map
+  auto srcid_geoid_map = make_srcgeoid_map(apa_count, link_count);
+
+  // delete any pre-existing files so that we start with a clean slate
+  std::string delete_pattern = file_prefix + ".*\\.(hdf5|manifest|manifest\\.part)";
+  delete_files_matching_pattern(file_path, delete_pattern);
+
+  // create the DataStore, with the default (empty) writer identifier
+  hdf5datastore::ConfParams config_params;
+  config_params.name = "tempWriter";
+  config_params.directory_path = file_path;
+  config_params.mode = "all-per-file";
+  config_params.max_file_size_bytes = 100000000; // much larger than what we expect, so no second file;
+  config_params.filename_parameters.overall_prefix = file_prefix;
+  config_params.file_layout_parameters = create_file_layout_params();
+  config_params.srcid_geoid_map = srcid_geoid_map;
+  config_params.trigger_manifest = true;
+
+  hdf5datastore::data_t hdf5ds_json;
+  hdf5datastore::to_json(hdf5ds_json, config_params);
+
+  std::unique_ptr<DataStore> data_store_ptr;
+  data_store_ptr = make_data_store(hdf5ds_json);
+
+  // write several events, each with several fragments
+  data_store_ptr->prepare_for_run(1);
+  for (int trigger_number = 1; trigger_number <= trigger_count; ++trigger_number)
+    data_store_ptr->write(create_trigger_record(trigger_number, fragment_size, apa_count * link_count));
+  data_store_ptr->finish_with_run(1);
+
+  data_store_ptr.reset(); // explicit destruction
+
+  // check that the journal was merged into the manifest of the run, and deleted
+  std::vector<std::string> file_list = get_files_matching_pattern(file_path, file_prefix + ".*\\.manifest\\.part");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 0);
+  file_list = get_files_matching_pattern(file_path, file_prefix + "_run000001\\.manifest");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 1);
+
+  TriggerManifest manifest(file_list[0]);
+  BOOST_REQUIRE_EQUAL(manifest.get_entry_count(), trigger_count);
+  auto locations = manifest.find(3);
+  BOOST_REQUIRE_EQUAL(locations.size(), 1);
+  BOOST_REQUIRE_EQUAL(get_files_matching_pattern(file_path, locations[0].file_name).size(), 1);
+
+  // clean up the files that were created
+  file_list = delete_files_matching_pattern(file_path, delete_pattern);
+  delete_files_matching_pattern(file_path, "HardwareMap.*\\.txt");
+  BOOST_REQUIRE_EQUAL(file_list.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidFileProperties)
+{
+  hdf5datastore::ConfParams config_params;
+  config_params.name = "tempWriter";
+  config_params.directory_path = std::filesystem::temp_directory_path();
+  config_params.file_layout_parameters = create_file_layout_params();
+  config_params.file_properties.page_buffer_size = 1048576; // needs the "page" strategy
+
+  hdf5datastore::data_t hdf5ds_json;
+  hdf5datastore::to_json(hdf5ds_json, config_params);
+
+  BOOST_REQUIRE_THROW(make_data_store(hdf5ds_json), ers::Issue);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
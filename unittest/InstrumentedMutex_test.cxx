@@ -0,0 +1,178 @@
+/**
+ * @file InstrumentedMutex_test.cxx Test application that tests and demonstrates
+ * the functionality of the InstrumentedMutex, LockStats and LockProfiler classes.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/InstrumentedMutex.hpp"
+#include "dfmodules/lockprofileinfo/InfoNljs.hpp"
+
+#define BOOST_TEST_MODULE InstrumentedMutex_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace dunedaq;
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+lockprofileinfo::Info
+get_lock_info(LockStats& stats)
+{
+  opmonlib::InfoCollector ci;
+  stats.get_info(ci);
+
+  auto json = ci.get_collected_infos();
+  auto info_json = json[opmonlib::JSONTags::properties][lockprofileinfo::Info::info_type];
+  lockprofileinfo::Info info;
+  lockprofileinfo::from_json(info_json[opmonlib::JSONTags::data], info);
+  return info;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(InstrumentedMutex_test)
+
+BOOST_AUTO_TEST_CASE(StatsAndQuantiles)
+{
+  LockStats stats;
+  for (int i = 0; i < 98; ++i) {
+    stats.record_acquisition(false, 0);
+    stats.record_release(100);
+  }
+  stats.record_acquisition(true, 1000);
+  stats.record_release(100);
+  stats.record_acquisition(true, 1000000);
+  stats.record_release(5000);
+
+  BOOST_REQUIRE_EQUAL(stats.get_acquisitions(), 100);
+  BOOST_REQUIRE_EQUAL(stats.get_contended(), 2);
+
+  auto info = get_lock_info(stats);
+  BOOST_REQUIRE_EQUAL(info.acquisitions, 100);
+  BOOST_REQUIRE_EQUAL(info.contended_acquisitions, 2);
+  BOOST_REQUIRE_EQUAL(info.wait_time_ns, 1001000);
+  BOOST_REQUIRE_EQUAL(info.hold_time_ns, 99 * 100 + 5000);
+  // the quantiles are the upper edges of the power-of-two bins
+  BOOST_REQUIRE_EQUAL(info.wait_p50_ns, 1);
+  BOOST_REQUIRE_EQUAL(info.wait_p99_ns, 1024);
+  BOOST_REQUIRE_EQUAL(info.wait_max_ns, 1 << 20);
+  BOOST_REQUIRE_EQUAL(info.hold_p50_ns, 128);
+  BOOST_REQUIRE_EQUAL(info.hold_p99_ns, 128);
+  BOOST_REQUIRE_EQUAL(info.hold_max_ns, 8192);
+
+  // the statistics are reset by each report
+  BOOST_REQUIRE_EQUAL(stats.get_acquisitions(), 0);
+  info = get_lock_info(stats);
+  BOOST_REQUIRE_EQUAL(info.acquisitions, 0);
+  BOOST_REQUIRE_EQUAL(info.wait_max_ns, 0);
+}
+
+BOOST_AUTO_TEST_CASE(StatsPerOwnerAndName)
+{
+  BOOST_REQUIRE_EQUAL(&LockProfiler::get_stats("trb1", "test.a"), &LockProfiler::get_stats("trb1", "test.a"));
+  BOOST_REQUIRE_NE(&LockProfiler::get_stats("trb1", "test.a"), &LockProfiler::get_stats("trb1", "test.b"));
+  BOOST_REQUIRE_NE(&LockProfiler::get_stats("trb1", "test.a"), &LockProfiler::get_stats("trb2", "test.a"));
+}
+
+BOOST_AUTO_TEST_CASE(ReportsPerOwner)
+{
+  InstrumentedMutex first_module_lock("module1", "InstrumentedMutex_test.owned");
+  InstrumentedMutex second_module_lock("module2", "InstrumentedMutex_test.owned");
+  InstrumentedMutex rebound_lock("InstrumentedMutex_test.owned");
+  rebound_lock.set_owner("module1");
+  {
+    std::lock_guard<InstrumentedMutex> lk(first_module_lock);
+  }
+  {
+    std::lock_guard<InstrumentedMutex> lk(rebound_lock);
+  }
+  {
+    std::lock_guard<InstrumentedMutex> lk(second_module_lock);
+  }
+
+  // the report of one module neither includes nor resets the statistics of the other
+  opmonlib::InfoCollector first_ci;
+  LockProfiler::get_info(first_ci, "module1");
+  auto& second_stats = LockProfiler::get_stats("module2", "InstrumentedMutex_test.owned");
+#ifdef DFMODULES_LOCK_PROFILING
+  auto json = first_ci.get_collected_infos();
+  BOOST_REQUIRE(json[opmonlib::JSONTags::children].contains("lock_owned"));
+  BOOST_REQUIRE_EQUAL(LockProfiler::get_stats("module1", "InstrumentedMutex_test.owned").get_acquisitions(), 0);
+  BOOST_REQUIRE_EQUAL(second_stats.get_acquisitions(), 1);
+#else
+  BOOST_REQUIRE(first_ci.is_empty());
+  BOOST_REQUIRE_EQUAL(second_stats.get_acquisitions(), 0);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(StandardLocks)
+{
+  InstrumentedMutex first("InstrumentedMutex_test.standard");
+  InstrumentedMutex second("InstrumentedMutex_test.standard");
+  {
+    std::lock_guard<InstrumentedMutex> lk(first);
+    BOOST_REQUIRE(!first.try_lock());
+  }
+  {
+    std::unique_lock<InstrumentedMutex> lk(first);
+    lk.unlock();
+    lk.lock();
+  }
+  {
+    std::lock(first, second);
+    std::lock_guard<InstrumentedMutex> first_lk(first, std::adopt_lock);
+    std::lock_guard<InstrumentedMutex> second_lk(second, std::adopt_lock);
+  }
+  {
+    std::scoped_lock lk(first);
+  }
+
+  auto& stats = LockProfiler::get_stats("", "InstrumentedMutex_test.standard");
+#ifdef DFMODULES_LOCK_PROFILING
+  // both instances are counted under their common owner and name
+  BOOST_REQUIRE_EQUAL(stats.get_acquisitions(), 6);
+  BOOST_REQUIRE_EQUAL(stats.get_contended(), 0);
+#else
+  BOOST_REQUIRE_EQUAL(stats.get_acquisitions(), 0);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(Contention)
+{
+  InstrumentedMutex mutex("InstrumentedMutex_test.contention");
+  std::atomic<bool> holding{ false };
+
+  std::unique_lock<InstrumentedMutex> lk(mutex);
+  std::thread waiter([&]() {
+    holding = true;
+    std::lock_guard<InstrumentedMutex> waiter_lk(mutex);
+  });
+  while (!holding) {
+    std::this_thread::yield();
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  lk.unlock();
+  waiter.join();
+
+  auto& stats = LockProfiler::get_stats("", "InstrumentedMutex_test.contention");
+#ifdef DFMODULES_LOCK_PROFILING
+  BOOST_REQUIRE_EQUAL(stats.get_acquisitions(), 2);
+  BOOST_REQUIRE_EQUAL(stats.get_contended(), 1);
+  auto info = get_lock_info(stats);
+  BOOST_REQUIRE_GE(info.wait_time_ns, 10000000);
+  BOOST_REQUIRE_GE(info.hold_time_ns, 10000000);
+#else
+  BOOST_REQUIRE_EQUAL(stats.get_acquisitions(), 0);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,98 @@
+/**
+ * @file IssueRateLimiter_test.cxx Test application that tests and demonstrates
+ * the functionality of the IssueRateLimiter class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/IssueRateLimiter.hpp"
+
+#define BOOST_TEST_MODULE IssueRateLimiter_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+BOOST_AUTO_TEST_SUITE(IssueRateLimiter_test)
+
+BOOST_AUTO_TEST_CASE(FirstOccurrencesAreReported)
+{
+  IssueRateLimiter limiter("TestIssue", 3, std::chrono::milliseconds(60000));
+
+  size_t reported = 0;
+  for (uint64_t i = 0; i < 10; ++i) {
+    if (limiter.should_report(i)) {
+      ++reported;
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(reported, 3);
+  BOOST_REQUIRE_EQUAL(limiter.get_total_count(), 10);
+  BOOST_REQUIRE_EQUAL(limiter.get_suppressed_count(), 7);
+
+  // a flush starts a new interval
+  limiter.flush();
+  BOOST_REQUIRE(limiter.should_report(10));
+}
+
+BOOST_AUTO_TEST_CASE(IntervalRollover)
+{
+  IssueRateLimiter limiter("TestIssue", 1, std::chrono::milliseconds(50), IssueRateLimiter::Severity::kWarning);
+
+  BOOST_REQUIRE(limiter.should_report(1));
+  BOOST_REQUIRE(!limiter.should_report(2));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  BOOST_REQUIRE(limiter.should_report(3));
+  BOOST_REQUIRE(!limiter.should_report(4));
+  BOOST_REQUIRE_EQUAL(limiter.get_suppressed_count(), 2);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  limiter.check_summary();
+  BOOST_REQUIRE(limiter.should_report(5));
+}
+
+BOOST_AUTO_TEST_CASE(DisabledLimiting)
+{
+  IssueRateLimiter limiter("TestIssue");
+  limiter.configure(0, std::chrono::milliseconds(1000));
+
+  for (uint64_t i = 0; i < 100; ++i) {
+    BOOST_REQUIRE(limiter.should_report(i));
+  }
+  BOOST_REQUIRE_EQUAL(limiter.get_suppressed_count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentOccurrences)
+{
+  IssueRateLimiter limiter("TestIssue", 5, std::chrono::milliseconds(60000));
+
+  std::atomic<size_t> reported{ 0 };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (uint64_t i = 0; i < 1000; ++i) {
+        if (limiter.should_report(i)) {
+          ++reported;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BOOST_REQUIRE_EQUAL(reported.load(), 5);
+  BOOST_REQUIRE_EQUAL(limiter.get_total_count(), 4000);
+  BOOST_REQUIRE_EQUAL(limiter.get_suppressed_count(), 3995);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
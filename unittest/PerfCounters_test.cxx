@@ -0,0 +1,142 @@
+/**
+ * @file PerfCounters_test.cxx Test application that tests and demonstrates
+ * the functionality of the PerfSection and PerfScope classes.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/PerfCounters.hpp"
+#include "dfmodules/perfcountersinfo/InfoNljs.hpp"
+
+#define BOOST_TEST_MODULE PerfCounters_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <thread>
+
+using namespace dunedaq;
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+volatile double g_sink = 0; // NOLINT
+
+void
+busy_loop()
+{
+  double sum = 0;
+  for (int i = 0; i < 100000; ++i) {
+    sum += i * 0.5;
+  }
+  g_sink = sum;
+}
+
+perfcountersinfo::Info
+get_perf_info(PerfSection& section)
+{
+  opmonlib::InfoCollector ci;
+  section.get_info(ci);
+
+  auto json = ci.get_collected_infos();
+  auto info_json = json[opmonlib::JSONTags::children]["perf_" + section.get_name()][opmonlib::JSONTags::properties]
+                       [perfcountersinfo::Info::info_type];
+  perfcountersinfo::Info info;
+  perfcountersinfo::from_json(info_json[opmonlib::JSONTags::data], info);
+  return info;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PerfCounters_test)
+
+BOOST_AUTO_TEST_CASE(ThreadCounters)
+{
+  PerfCounterValues start, end;
+  std::string reason;
+  if (!PerfSection::read_thread_counters(start, reason)) {
+    // perf events are not permitted on this machine, which must not be an error
+    BOOST_TEST_MESSAGE("Hardware performance counters are not available: " << reason);
+    BOOST_REQUIRE(!reason.empty());
+    return;
+  }
+  busy_loop();
+  BOOST_REQUIRE(PerfSection::read_thread_counters(end, reason));
+  BOOST_REQUIRE(end.instructions - start.instructions >= 100000);
+  BOOST_REQUIRE(end.cycles > start.cycles);
+}
+
+BOOST_AUTO_TEST_CASE(DisabledByDefault)
+{
+  PerfSection section("test");
+  BOOST_REQUIRE(!section.is_enabled());
+  {
+    PerfScope scope(section);
+    busy_loop();
+  }
+  {
+    PerfScope null_scope(nullptr);
+  }
+  BOOST_REQUIRE_EQUAL(section.get_invocations(), 0);
+
+  section.set_enabled(true);
+  for (int i = 0; i < 3; ++i) {
+    PerfScope scope(section);
+    busy_loop();
+  }
+  // the invocations are counted whether or not the counters can be read, on any thread
+  std::thread other([&section]() {
+    PerfScope scope(section);
+    busy_loop();
+  });
+  other.join();
+
+  BOOST_REQUIRE_EQUAL(section.get_invocations(), 4);
+
+  PerfCounterValues values;
+  std::string reason;
+  bool available = PerfSection::read_thread_counters(values, reason);
+  BOOST_REQUIRE_EQUAL(section.get_counted_invocations(), available ? 4 : 0);
+}
+
+BOOST_AUTO_TEST_CASE(MultiplexedCounters)
+{
+  PerfSection section("test");
+  section.set_enabled(true);
+
+  PerfCounterValues start, end;
+  end.cycles = 1000;
+  end.instructions = 2000;
+  end.llc_misses = 10;
+  end.branch_misses = 20;
+  end.time_enabled_ns = 400;
+  end.time_running_ns = 400;
+  section.add(start, end, true);
+
+  // counters that were scheduled for a quarter of the invocation
+  start = end;
+  end.cycles += 250;
+  end.instructions += 500;
+  end.time_enabled_ns += 400;
+  end.time_running_ns += 100;
+  section.add(start, end, true);
+
+  // counters that were not scheduled at all
+  start = end;
+  end.time_enabled_ns += 400;
+  section.add(start, end, true);
+
+  auto info = get_perf_info(section);
+  BOOST_REQUIRE_EQUAL(info.invocations, 3);
+  BOOST_REQUIRE_EQUAL(info.counted_invocations, 2);
+  BOOST_REQUIRE_EQUAL(info.cycles, 2000);
+  BOOST_REQUIRE_EQUAL(info.instructions, 4000);
+  BOOST_REQUIRE_EQUAL(info.llc_misses, 10);
+  BOOST_REQUIRE_EQUAL(info.branch_misses, 20);
+  BOOST_REQUIRE_EQUAL(info.time_enabled_ns, 800);
+  BOOST_REQUIRE_EQUAL(info.time_running_ns, 500);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+/**
+ * @file RecordProcessingChain_test.cxx Test application that tests and demonstrates
+ * the functionality of the RecordProcessingChain class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/RecordProcessingChain.hpp"
+
+#define BOOST_TEST_MODULE RecordProcessingChain_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+using dunedaq::daqdataformats::ComponentRequest;
+using dunedaq::daqdataformats::Fragment;
+using dunedaq::daqdataformats::TriggerRecord;
+
+namespace {
+
+std::unique_ptr<TriggerRecord>
+make_record(uint64_t trigger_number) // NOLINT(build/unsigned)
+{
+  std::vector<ComponentRequest> components(1);
+  auto record = std::make_unique<TriggerRecord>(components);
+  record->get_header_ref().set_trigger_number(trigger_number);
+  std::vector<char> payload(100, 'x');
+  record->add_fragment(std::make_unique<Fragment>(payload.data(), payload.size()));
+  return record;
+}
+
+/**
+ * @brief Drops the odd trigger numbers, after a delay that makes the later records finish first
+ */
+class DropOdd : public RecordProcessor
+{
+public:
+  DropOdd()
+    : RecordProcessor("drop_odd")
+  {}
+
+  bool process(TriggerRecord& tr) override
+  {
+    auto trigger_number = tr.get_header_ref().get_trigger_number();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 - trigger_number % 10));
+    return trigger_number % 2 == 0;
+  }
+};
+
+/**
+ * @brief Removes all the Fragments, and fails on trigger number 4
+ */
+class StripFragments : public RecordProcessor
+{
+public:
+  StripFragments()
+    : RecordProcessor("strip_fragments")
+  {}
+
+  bool process(TriggerRecord& tr) override
+  {
+    if (tr.get_header_ref().get_trigger_number() == 4) {
+      throw std::runtime_error("failing on purpose");
+    }
+    tr.set_fragments(std::vector<std::unique_ptr<Fragment>>());
+    return true;
+  }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RecordProcessingChain_test)
+
+BOOST_AUTO_TEST_CASE(SubmissionOrder)
+{
+  std::vector<std::unique_ptr<RecordProcessor>> processors;
+  processors.push_back(std::make_unique<DropOdd>());
+  processors.push_back(std::make_unique<StripFragments>());
+  RecordProcessingChain chain(std::move(processors), 4, 8);
+  BOOST_REQUIRE_EQUAL(chain.get_processor_count(), 2);
+
+  std::vector<RecordProcessingChain::ProcessedRecord> done;
+  for (uint64_t i = 1; i <= 10; ++i) { // NOLINT(build/unsigned)
+    chain.submit(make_record(i), done);
+  }
+  // no more than max_in_flight records are being processed
+  BOOST_REQUIRE_GE(done.size(), 2);
+  chain.drain(done);
+
+  BOOST_REQUIRE_EQUAL(done.size(), 10);
+  for (size_t i = 0; i < done.size(); ++i) {
+    auto trigger_number = done[i].record->get_header_ref().get_trigger_number();
+    BOOST_REQUIRE_EQUAL(trigger_number, i + 1);
+    BOOST_REQUIRE_EQUAL(done[i].keep, trigger_number % 2 == 0);
+    if (done[i].keep) {
+      // the failure of the second processor leaves the record as it is
+      BOOST_REQUIRE_EQUAL(done[i].record->get_fragments_ref().size(), trigger_number == 4 ? 1 : 0);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CollectDoesNotWait)
+{
+  std::vector<std::unique_ptr<RecordProcessor>> processors;
+  processors.push_back(std::make_unique<DropOdd>());
+  RecordProcessingChain chain(std::move(processors), 1, 4);
+
+  std::vector<RecordProcessingChain::ProcessedRecord> done;
+  chain.submit(make_record(10), done);
+  chain.submit(make_record(11), done);
+  chain.collect(done);
+  BOOST_REQUIRE(done.size() < 2);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (done.size() < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    chain.collect(done);
+  }
+  BOOST_REQUIRE_EQUAL(done.size(), 2);
+  BOOST_REQUIRE(done[0].keep);
+  BOOST_REQUIRE(!done[1].keep);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidProcessor)
+{
+  BOOST_CHECK_THROW(make_record_processor("dummy", nlohmann::json{}), RecordProcessorCreationFailed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
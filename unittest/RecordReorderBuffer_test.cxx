@@ -0,0 +1,132 @@
+/**
+ * @file RecordReorderBuffer_test.cxx Test application that tests and demonstrates
+ * the functionality of the RecordReorderBuffer class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/RecordReorderBuffer.hpp"
+
+#define BOOST_TEST_MODULE RecordReorderBuffer_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+using dunedaq::daqdataformats::ComponentRequest;
+using dunedaq::daqdataformats::TriggerRecord;
+
+namespace {
+
+RecordReorderBuffer::record_ptr_t
+make_record(uint64_t trigger_number, uint16_t sequence_number = 0) // NOLINT(build/unsigned)
+{
+  auto record = std::make_unique<TriggerRecord>(std::vector<ComponentRequest>());
+  record->get_header_ref().set_trigger_number(trigger_number);
+  record->get_header_ref().set_sequence_number(sequence_number);
+  return record;
+}
+
+std::vector<uint64_t> // NOLINT(build/unsigned)
+trigger_numbers(const std::vector<RecordReorderBuffer::record_ptr_t>& records)
+{
+  std::vector<uint64_t> numbers; // NOLINT(build/unsigned)
+  for (const auto& record : records) {
+    numbers.push_back(record->get_header_ref().get_trigger_number());
+  }
+  return numbers;
+}
+
+const auto t0 = RecordReorderBuffer::clock_type::now();
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RecordReorderBuffer_test)
+
+BOOST_AUTO_TEST_CASE(CountLimit)
+{
+  RecordReorderBuffer buffer;
+  buffer.configure(3, 0, std::chrono::milliseconds(1000));
+  BOOST_REQUIRE(buffer.is_enabled());
+
+  std::vector<RecordReorderBuffer::record_ptr_t> released;
+  for (uint64_t trigger : { 5, 3, 4, 6, 1, 2, 8, 7 }) { // NOLINT(build/unsigned)
+    buffer.push(make_record(trigger), t0, released);
+  }
+  BOOST_REQUIRE_EQUAL(buffer.get_held_records(), 3);
+
+  buffer.flush(released);
+  // 3 is released to make room for 6, after which 1 and 2 can't be ordered any more
+  std::vector<uint64_t> expected = { 3, 1, 2, 4, 5, 6, 7, 8 }; // NOLINT(build/unsigned)
+  BOOST_REQUIRE(trigger_numbers(released) == expected);
+  BOOST_REQUIRE_EQUAL(buffer.get_late_records(), 2);
+  BOOST_REQUIRE_EQUAL(buffer.get_held_records(), 0);
+  BOOST_REQUIRE_EQUAL(buffer.get_held_bytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(OrderWithinWindow)
+{
+  RecordReorderBuffer buffer;
+  buffer.configure(4, 0, std::chrono::milliseconds(1000));
+
+  std::vector<RecordReorderBuffer::record_ptr_t> released;
+  buffer.push(make_record(2, 1), t0, released);
+  buffer.push(make_record(3), t0, released);
+  buffer.push(make_record(1), t0, released);
+  buffer.push(make_record(2, 0), t0, released);
+  BOOST_REQUIRE(released.empty());
+
+  buffer.push(make_record(4), t0, released);
+  BOOST_REQUIRE_EQUAL(released.size(), 1);
+  BOOST_REQUIRE_EQUAL(released[0]->get_header_ref().get_trigger_number(), 1);
+
+  buffer.flush(released);
+  std::vector<uint64_t> expected = { 1, 2, 2, 3, 4 }; // NOLINT(build/unsigned)
+  BOOST_REQUIRE(trigger_numbers(released) == expected);
+  BOOST_REQUIRE_EQUAL(released[1]->get_header_ref().get_sequence_number(), 0);
+  BOOST_REQUIRE_EQUAL(released[2]->get_header_ref().get_sequence_number(), 1);
+
+  // a record before the ones released can't be ordered
+  buffer.push(make_record(3, 1), t0, released);
+  BOOST_REQUIRE_EQUAL(buffer.get_late_records(), 1);
+  BOOST_REQUIRE_EQUAL(released.size(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(TimeAndByteLimits)
+{
+  RecordReorderBuffer buffer;
+  buffer.configure(100, 0, std::chrono::milliseconds(10));
+
+  std::vector<RecordReorderBuffer::record_ptr_t> released;
+  buffer.push(make_record(3), t0, released);
+  buffer.push(make_record(1), t0 + std::chrono::milliseconds(5), released);
+  buffer.push(make_record(5), t0 + std::chrono::milliseconds(8), released);
+
+  // 3 has expired, and 1 comes before it
+  buffer.release_expired(t0 + std::chrono::milliseconds(11), released);
+  std::vector<uint64_t> expected = { 1, 3 }; // NOLINT(build/unsigned)
+  BOOST_REQUIRE(trigger_numbers(released) == expected);
+
+  buffer.release_expired(t0 + std::chrono::milliseconds(20), released);
+  BOOST_REQUIRE_EQUAL(released.size(), 3);
+  BOOST_REQUIRE_EQUAL(buffer.get_held_records(), 0);
+
+  auto record_size = make_record(10)->get_total_size_bytes();
+  buffer.reset();
+  buffer.configure(100, 2 * record_size, std::chrono::milliseconds(1000));
+  released.clear();
+  buffer.push(make_record(12), t0, released);
+  buffer.push(make_record(11), t0, released);
+  BOOST_REQUIRE(released.empty());
+  buffer.push(make_record(10), t0, released);
+  BOOST_REQUIRE_EQUAL(released.size(), 1);
+  BOOST_REQUIRE_EQUAL(buffer.get_held_bytes(), 2 * record_size);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,170 @@
+/**
+ * @file RunReport_test.cxx Test application that tests and demonstrates
+ * the functionality of the RunReport class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/RunReport.hpp"
+
+#define BOOST_TEST_MODULE RunReport_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+struct TempDirFixture
+{
+  TempDirFixture()
+    : path(std::filesystem::temp_directory_path() / ("RunReport_test_" + std::to_string(getpid())))
+  {
+    std::filesystem::create_directories(path);
+  }
+  ~TempDirFixture() { std::filesystem::remove_all(path); }
+
+  runreport::RunReport make_conf(bool enabled) const
+  {
+    runreport::RunReport conf;
+    conf.enabled = enabled;
+    conf.output_path = path.string();
+    return conf;
+  }
+
+  std::filesystem::path path;
+};
+
+nlohmann::json
+to_json(const RunReport& report)
+{
+  std::ostringstream oss;
+  report.write(oss);
+  return nlohmann::json::parse(oss.str());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(RunReport_test)
+
+BOOST_AUTO_TEST_CASE(LatencyQuantiles)
+{
+  RunReport::Latency latency;
+  BOOST_REQUIRE_EQUAL(latency.get_quantile(0.5), 0);
+  for (int i = 0; i < 98; ++i) {
+    latency.record(std::chrono::microseconds(100));
+  }
+  latency.record(std::chrono::microseconds(3000));
+  latency.record(std::chrono::microseconds(50000));
+
+  BOOST_REQUIRE_EQUAL(latency.get_count(), 100);
+  BOOST_REQUIRE_EQUAL(latency.get_max(), 50000);
+  BOOST_REQUIRE_CLOSE(latency.get_mean(), (98 * 100 + 3000 + 50000) / 100., 1e-9);
+  // the quantiles are the upper edges of the power-of-two bins, at most the maximum
+  BOOST_REQUIRE_EQUAL(latency.get_quantile(0.5), 128);
+  BOOST_REQUIRE_EQUAL(latency.get_quantile(0.99), 4096);
+  BOOST_REQUIRE_EQUAL(latency.get_quantile(1.), 50000);
+
+  latency.reset();
+  BOOST_REQUIRE_EQUAL(latency.get_count(), 0);
+  BOOST_REQUIRE_EQUAL(latency.get_max(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(PeakAndState)
+{
+  RunReport::Peak peak;
+  peak.observe(3);
+  peak.observe(7);
+  peak.observe(5);
+  BOOST_REQUIRE_EQUAL(peak.get(), 7);
+
+  RunReport::StateTimer state;
+  auto start = RunReport::clock_type::now();
+  state.reset(start);
+  state.set(true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  state.set(true);
+  state.set(false);
+  auto busy = state.get_time(RunReport::clock_type::now());
+  BOOST_REQUIRE_GE(busy.count(), 20000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  // the time is not accumulated while the state is inactive
+  BOOST_REQUIRE_EQUAL(state.get_time(RunReport::clock_type::now()).count(), busy.count());
+}
+
+BOOST_FIXTURE_TEST_CASE(ReportContents, TempDirFixture)
+{
+  RunReport report("trb", "TriggerRecordBuilder");
+  auto& records = report.add_counter("trigger_records");
+  auto& latency = report.add_latency("trigger_record_building");
+  auto& book = report.add_peak("trigger_records_in_the_book");
+  auto& busy = report.add_state("busy");
+  report.configure(make_conf(true));
+
+  records.add(5);
+  report.start(42);
+  BOOST_REQUIRE_EQUAL(records.get(), 0);
+
+  records.add(10);
+  latency.record(std::chrono::microseconds(1000));
+  book.observe(4);
+  busy.set(true);
+  report.set_value("draining_time_s", 0.5);
+
+  auto json = to_json(report);
+  BOOST_REQUIRE_EQUAL(json["module"].get<std::string>(), "trb");
+  BOOST_REQUIRE_EQUAL(json["module_class"].get<std::string>(), "TriggerRecordBuilder");
+  BOOST_REQUIRE_EQUAL(json["run_number"].get<int>(), 42);
+  BOOST_REQUIRE_EQUAL(json["counters"]["trigger_records"]["total"].get<int>(), 10);
+  BOOST_REQUIRE(json["counters"]["trigger_records"]["rate_hz"].get<double>() > 0);
+  BOOST_REQUIRE_EQUAL(json["latencies_us"]["trigger_record_building"]["count"].get<int>(), 1);
+  BOOST_REQUIRE_EQUAL(json["latencies_us"]["trigger_record_building"]["max"].get<int>(), 1000);
+  BOOST_REQUIRE_EQUAL(json["peaks"]["trigger_records_in_the_book"].get<int>(), 4);
+  BOOST_REQUIRE(json["states"]["busy"]["fraction"].get<double>() <= 1.);
+  BOOST_REQUIRE_EQUAL(json["values"]["draining_time_s"].get<double>(), 0.5);
+  BOOST_REQUIRE(json["peak_rss_kb"].get<int64_t>() > 0);
+
+  report.stop();
+  auto file_path = path / "runreport_trb_run000042.json";
+  BOOST_REQUIRE(std::filesystem::exists(file_path));
+  std::ifstream ifs(file_path);
+  auto written = nlohmann::json::parse(ifs);
+  BOOST_REQUIRE_EQUAL(written["counters"]["trigger_records"]["total"].get<int>(), 10);
+}
+
+BOOST_FIXTURE_TEST_CASE(Disabled, TempDirFixture)
+{
+  RunReport report("dw", "DataWriter");
+  report.add_counter("records_written").add();
+  report.configure(make_conf(false));
+  report.start(1);
+  report.stop();
+  BOOST_REQUIRE(std::filesystem::is_empty(path));
+}
+
+BOOST_FIXTURE_TEST_CASE(UnwritableDirectory, TempDirFixture)
+{
+  RunReport report("dw", "DataWriter");
+  auto conf = make_conf(true);
+  conf.output_path = (path / "does_not_exist").string();
+  report.configure(conf);
+  report.start(1);
+  // a warning is reported, and the run stops normally
+  BOOST_REQUIRE_NO_THROW(report.stop());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
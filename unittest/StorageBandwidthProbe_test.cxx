@@ -0,0 +1,86 @@
+/**
+ * @file StorageBandwidthProbe_test.cxx Test application that tests and demonstrates
+ * the functionality of the StorageBandwidthProbe class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/StorageBandwidthProbe.hpp"
+
+#define BOOST_TEST_MODULE StorageBandwidthProbe_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+struct TempDirFixture
+{
+  TempDirFixture()
+    : path(std::filesystem::temp_directory_path() / ("StorageBandwidthProbe_test_" + std::to_string(getpid())))
+  {
+    std::filesystem::create_directories(path);
+  }
+  ~TempDirFixture() { std::filesystem::remove_all(path); }
+
+  std::filesystem::path path;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(StorageBandwidthProbe_test, TempDirFixture)
+
+BOOST_AUTO_TEST_CASE(MeasureBlockSizes)
+{
+  storageprobe::BandwidthProbe conf;
+  conf.enabled = true;
+  conf.block_sizes_bytes = { 65536, 1048576 };
+  conf.bytes_per_block_size = 4194304;
+  conf.sync_interval_bytes = 1048576;
+  conf.max_duration_ms = 60000;
+  StorageBandwidthProbe probe(conf);
+
+  auto results = probe.run(path.string());
+  BOOST_REQUIRE_EQUAL(results.size(), 2);
+  BOOST_REQUIRE_EQUAL(results[0].block_size, 65536);
+  BOOST_REQUIRE_EQUAL(results[1].block_size, 1048576);
+  for (const auto& result : results) {
+    BOOST_REQUIRE_EQUAL(result.bytes_written, conf.bytes_per_block_size);
+    BOOST_REQUIRE(result.bandwidth_bytes_per_s > 0);
+    BOOST_REQUIRE(result.latency_p50 <= result.latency_p99);
+    BOOST_REQUIRE(result.latency_p99 <= result.latency_max);
+    BOOST_REQUIRE(!probe.is_below_expected_rate(result));
+  }
+
+  // the temporary file is removed
+  BOOST_REQUIRE(std::filesystem::is_empty(path));
+}
+
+BOOST_AUTO_TEST_CASE(ExpectedRate)
+{
+  storageprobe::BandwidthProbe conf;
+  conf.bytes_per_block_size = 1048576;
+  conf.expected_rate_bytes_per_s = 1000000000000000;
+  StorageBandwidthProbe probe(conf);
+
+  auto results = probe.run(path.string());
+  BOOST_REQUIRE_EQUAL(results.size(), 1);
+  BOOST_REQUIRE_EQUAL(results[0].block_size, StorageBandwidthProbe::s_default_block_size);
+  BOOST_REQUIRE(probe.is_below_expected_rate(results[0]));
+}
+
+BOOST_AUTO_TEST_CASE(InvalidDirectory)
+{
+  StorageBandwidthProbe probe(storageprobe::BandwidthProbe{});
+  BOOST_REQUIRE_THROW(probe.run((path / "does_not_exist").string()), StorageBandwidthProbeFailed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+/**
+ * @file StorageFaultInjector_test.cxx Test application that tests and demonstrates
+ * the functionality of the StorageFaultInjector class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/StorageFaultInjector.hpp"
+
+#define BOOST_TEST_MODULE StorageFaultInjector_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace dunedaq::dfmodules;
+
+BOOST_AUTO_TEST_SUITE(StorageFaultInjector_test)
+
+BOOST_AUTO_TEST_CASE(NoFaults)
+{
+  StorageFaultInjector injector(storagefaults::StorageFaults{});
+  for (int i = 0; i < 100; ++i) {
+    BOOST_REQUIRE(!injector.is_full());
+    injector.delay_write(1000000);
+  }
+  BOOST_REQUIRE_EQUAL(injector.get_write_count(), 100);
+  BOOST_REQUIRE_EQUAL(injector.get_failed_write_count(), 0);
+  BOOST_REQUIRE_EQUAL(injector.get_stalled_write_count(), 0);
+  BOOST_REQUIRE_EQUAL(injector.get_injected_delay().count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(LatencyAndThroughput)
+{
+  storagefaults::StorageFaults conf;
+  conf.latency_distribution = "constant";
+  conf.latency_mean_us = 1000;
+  StorageFaultInjector latency(conf);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; ++i) {
+    latency.delay_write(100);
+  }
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10));
+  BOOST_REQUIRE(latency.get_injected_delay() >= std::chrono::milliseconds(10));
+
+  // 10 writes of 100 kB at 20 MB/s take 50 ms
+  conf.latency_distribution = "none";
+  conf.throughput_cap_bytes_per_s = 20000000;
+  StorageFaultInjector throughput(conf);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; ++i) {
+    throughput.delay_write(100000);
+  }
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+}
+
+BOOST_AUTO_TEST_CASE(Episodes)
+{
+  storagefaults::StorageFaults conf;
+  conf.full_period_ms = 200;
+  conf.full_duration_ms = 50;
+  conf.stall_period_ms = 200;
+  conf.stall_duration_ms = 20;
+  StorageFaultInjector injector(conf);
+
+  // both episodes start with the period
+  BOOST_REQUIRE(injector.is_full());
+  auto start = std::chrono::steady_clock::now();
+  injector.delay_write(0);
+  BOOST_REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10));
+  BOOST_REQUIRE_EQUAL(injector.get_stalled_write_count(), 1);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  BOOST_REQUIRE(!injector.is_full());
+  BOOST_REQUIRE_EQUAL(injector.get_failed_write_count(), 1);
+
+  injector.start();
+  BOOST_REQUIRE(injector.is_full());
+  BOOST_REQUIRE_EQUAL(injector.get_failed_write_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(RandomFailures)
+{
+  storagefaults::StorageFaults conf;
+  conf.full_probability = 0.25;
+  conf.random_seed = 42;
+  StorageFaultInjector injector(conf);
+  for (int i = 0; i < 10000; ++i) {
+    injector.is_full();
+  }
+  BOOST_REQUIRE(injector.get_failed_write_count() > 2000);
+  BOOST_REQUIRE(injector.get_failed_write_count() < 3000);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidConfiguration)
+{
+  storagefaults::StorageFaults conf;
+  conf.latency_distribution = "gaussian";
+  BOOST_REQUIRE_THROW(StorageFaultInjector{ conf }, dunedaq::dfmodules::InvalidStorageFaults);
+
+  conf.latency_distribution = "lognormal";
+  BOOST_REQUIRE_THROW(StorageFaultInjector{ conf }, dunedaq::dfmodules::InvalidStorageFaults);
+
+  conf.latency_distribution = "none";
+  conf.full_period_ms = 10;
+  conf.full_duration_ms = 20;
+  BOOST_REQUIRE_THROW(StorageFaultInjector{ conf }, dunedaq::dfmodules::InvalidStorageFaults);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+/**
+ * @file TRMonRequestIndex_test.cxx Test application that tests and demonstrates
+ * the functionality of the TRMonRequestIndex class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/TRMonRequestIndex.hpp"
+
+#define BOOST_TEST_MODULE TRMonRequestIndex_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+namespace {
+dunedaq::dfmessages::TRMonRequest
+make_request(TRMonRequestIndex::trigger_type_t trigger_type, const std::string& destination)
+{
+  dunedaq::dfmessages::TRMonRequest request;
+  request.run_number = 1;
+  request.trigger_type = trigger_type;
+  request.data_destination = destination;
+  return request;
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TRMonRequestIndex_test)
+
+BOOST_AUTO_TEST_CASE(TakeByTriggerType)
+{
+  TRMonRequestIndex index("test", "TRMonRequestIndex.requests");
+  BOOST_REQUIRE(!index.may_have(1));
+  BOOST_REQUIRE(index.take(1).empty());
+
+  index.add(make_request(1, "dqm_a"));
+  index.add(make_request(2, "dqm_b"));
+  index.add(make_request(1, "dqm_c"));
+  // a type that shares the bucket of type 1, but has no requests
+  index.add(make_request(65, "dqm_d"));
+  BOOST_REQUIRE_EQUAL(index.size(), 4);
+  BOOST_REQUIRE(index.may_have(1));
+  BOOST_REQUIRE(!index.may_have(3));
+
+  auto requests = index.take(1);
+  BOOST_REQUIRE_EQUAL(requests.size(), 2);
+  BOOST_REQUIRE_EQUAL(requests[0].data_destination, "dqm_a");
+  BOOST_REQUIRE_EQUAL(requests[1].data_destination, "dqm_c");
+  BOOST_REQUIRE_EQUAL(index.size(), 2);
+
+  // each request is served once
+  BOOST_REQUIRE(index.take(1).empty());
+  BOOST_REQUIRE_EQUAL(index.take(65).size(), 1);
+  BOOST_REQUIRE(!index.may_have(1));
+
+  index.clear();
+  BOOST_REQUIRE_EQUAL(index.size(), 0);
+  BOOST_REQUIRE(!index.may_have(2));
+  BOOST_REQUIRE(index.take(2).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentProducers)
+{
+  TRMonRequestIndex index("test", "TRMonRequestIndex.requests");
+  const int producer_count = 4;
+  const int requests_per_producer = 1000;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producer_count; ++p) {
+    producers.emplace_back([&index, p]() {
+      for (int i = 0; i < requests_per_producer; ++i) {
+        index.add(make_request(i % 8, "dqm_" + std::to_string(p)));
+      }
+    });
+  }
+
+  size_t taken = 0;
+  while (taken < producer_count * requests_per_producer) {
+    for (TRMonRequestIndex::trigger_type_t trigger_type = 0; trigger_type < 8; ++trigger_type) {
+      taken += index.take(trigger_type).size();
+    }
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  BOOST_REQUIRE_EQUAL(taken, producer_count * requests_per_producer);
+  BOOST_REQUIRE_EQUAL(index.size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
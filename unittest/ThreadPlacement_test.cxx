@@ -0,0 +1,74 @@
+/**
+ * @file ThreadPlacement_test.cxx Test application that tests and demonstrates
+ * the functionality of the ThreadPlacement class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/ThreadPlacement.hpp"
+
+#define BOOST_TEST_MODULE ThreadPlacement_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <sched.h>
+
+#include <set>
+#include <thread>
+
+using namespace dunedaq::dfmodules;
+
+BOOST_AUTO_TEST_SUITE(ThreadPlacement_test)
+
+BOOST_AUTO_TEST_CASE(ParseCPUList)
+{
+  BOOST_REQUIRE(ThreadPlacement::parse_cpu_list("").empty());
+  BOOST_REQUIRE(ThreadPlacement::parse_cpu_list("3") == std::set<int>({ 3 }));
+  BOOST_REQUIRE(ThreadPlacement::parse_cpu_list("0-3, 8") == std::set<int>({ 0, 1, 2, 3, 8 }));
+  BOOST_REQUIRE(ThreadPlacement::parse_cpu_list("2,1-2,") == std::set<int>({ 1, 2 }));
+
+  BOOST_REQUIRE_THROW(ThreadPlacement::parse_cpu_list("a"), dunedaq::dfmodules::InvalidThreadPlacement);
+  BOOST_REQUIRE_THROW(ThreadPlacement::parse_cpu_list("3-1"), dunedaq::dfmodules::InvalidThreadPlacement);
+  BOOST_REQUIRE_THROW(ThreadPlacement::parse_cpu_list("1-2x"), dunedaq::dfmodules::InvalidThreadPlacement);
+  BOOST_REQUIRE_THROW(ThreadPlacement::parse_cpu_list("-1"), dunedaq::dfmodules::InvalidThreadPlacement);
+}
+
+BOOST_AUTO_TEST_CASE(Configuration)
+{
+  dunedaq::dfmodules::threadplacement::ThreadPlacement conf;
+  BOOST_REQUIRE(ThreadPlacement(conf).is_empty());
+
+  conf.memory_policy = "local";
+  ThreadPlacement local(conf);
+  BOOST_REQUIRE(!local.is_empty());
+  BOOST_REQUIRE(local.get_memory_policy() == ThreadPlacement::MemoryPolicy::kLocal);
+
+  conf.memory_policy = "bind";
+  conf.numa_node = 0;
+  BOOST_REQUIRE(ThreadPlacement(conf).get_numa_nodes() == std::set<int>({ 0 }));
+
+  conf.memory_policy = "nearby";
+  BOOST_REQUIRE_THROW(ThreadPlacement{ conf }, dunedaq::dfmodules::InvalidThreadPlacement);
+}
+
+BOOST_AUTO_TEST_CASE(ApplyAffinity)
+{
+  dunedaq::dfmodules::threadplacement::ThreadPlacement conf;
+  conf.cpu_list = std::to_string(sched_getcpu());
+  ThreadPlacement placement(conf);
+
+  bool applied = false;
+  int cpu = -1;
+  std::thread thread([&]() {
+    applied = placement.apply_to_current_thread("ThreadPlacement_test");
+    cpu = sched_getcpu();
+  });
+  thread.join();
+
+  BOOST_REQUIRE(applied);
+  BOOST_REQUIRE(placement.get_cpus().count(cpu) == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
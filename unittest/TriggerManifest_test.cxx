@@ -0,0 +1,165 @@
+/**
+ * @file TriggerManifest_test.cxx Test application that tests and demonstrates
+ * the functionality of the TriggerManifest and TriggerManifestWriter classes.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/TriggerManifest.hpp"
+
+#define BOOST_TEST_MODULE TriggerManifest_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <memory>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+namespace {
+
+struct TempDirFixture
+{
+  TempDirFixture()
+    : path(std::filesystem::temp_directory_path() / ("TriggerManifest_test_" + std::to_string(getpid())))
+  {
+    std::filesystem::create_directories(path);
+  }
+  ~TempDirFixture() { std::filesystem::remove_all(path); }
+
+  std::string file(const std::string& name) const { return (path / name).string(); }
+
+  std::filesystem::path path;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(TriggerManifest_test, TempDirFixture)
+
+BOOST_AUTO_TEST_CASE(MergeAndFind)
+{
+  {
+    // two writers, each with two files, receiving every other trigger
+    TriggerManifestWriter first(file("run1_a.manifest.part"), 3);
+    TriggerManifestWriter second(file("run1_b.manifest.part"), 1000);
+    for (uint64_t trigger = 1; trigger <= 100; ++trigger) { // NOLINT(build/unsigned)
+      auto& writer = trigger % 2 ? first : second;
+      if (trigger == 1 || trigger == 2) {
+        writer.add_file(trigger == 1 ? "a_0000.hdf5" : "b_0000.hdf5");
+      } else if (trigger == 51 || trigger == 52) {
+        writer.add_file(trigger == 51 ? "a_0001.hdf5" : "b_0001.hdf5");
+      }
+      writer.add_entry(trigger, 0, trigger * 1000);
+      if (trigger == 42) {
+        writer.add_entry(trigger, 1, trigger * 1000 + 1);
+      }
+    }
+  }
+
+  auto count = TriggerManifest::merge({ file("run1_a.manifest.part"), file("run1_b.manifest.part") },
+                                      file("run1.manifest"));
+  BOOST_REQUIRE_EQUAL(count, 101);
+
+  TriggerManifest manifest(file("run1.manifest"));
+  BOOST_REQUIRE_EQUAL(manifest.get_entry_count(), 101);
+  BOOST_REQUIRE_EQUAL(manifest.get_file_names().size(), 4);
+
+  auto locations = manifest.find(77);
+  BOOST_REQUIRE_EQUAL(locations.size(), 1);
+  BOOST_REQUIRE_EQUAL(locations[0].file_name, "a_0001.hdf5");
+  BOOST_REQUIRE_EQUAL(locations[0].offset, 77000);
+
+  locations = manifest.find(42);
+  BOOST_REQUIRE_EQUAL(locations.size(), 2);
+  BOOST_REQUIRE_EQUAL(locations[0].file_name, "b_0000.hdf5");
+  BOOST_REQUIRE_EQUAL(locations[0].sequence_number, 0);
+  BOOST_REQUIRE_EQUAL(locations[1].sequence_number, 1);
+
+  BOOST_REQUIRE(manifest.find(0).empty());
+  BOOST_REQUIRE(manifest.find(101).empty());
+
+  // the merged journals are deleted
+  BOOST_REQUIRE(!std::filesystem::exists(file("run1_a.manifest.part")));
+  BOOST_REQUIRE(!std::filesystem::exists(file("run1_b.manifest.part")));
+}
+
+BOOST_AUTO_TEST_CASE(SuccessiveMerges)
+{
+  // each writer merges its own journal when it finishes, while the other one is still writing
+  auto first = std::make_unique<TriggerManifestWriter>(file("run4_a.manifest.part"), 10);
+  auto second = std::make_unique<TriggerManifestWriter>(file("run4_b.manifest.part"), 10);
+  first->add_file("a_0000.hdf5");
+  second->add_file("b_0000.hdf5");
+  for (uint64_t trigger = 1; trigger <= 10; ++trigger) { // NOLINT(build/unsigned)
+    first->add_entry(trigger, 0, trigger * 1000);
+    second->add_entry(trigger + 10, 0, trigger * 1000);
+  }
+  first.reset();
+  BOOST_REQUIRE_EQUAL(TriggerManifest::merge({ file("run4_a.manifest.part") }, file("run4.manifest")), 10);
+  BOOST_REQUIRE(std::filesystem::exists(file("run4_b.manifest.part")));
+
+  for (uint64_t trigger = 21; trigger <= 30; ++trigger) { // NOLINT(build/unsigned)
+    second->add_entry(trigger, 0, trigger * 1000);
+  }
+  second.reset();
+  BOOST_REQUIRE_EQUAL(TriggerManifest::merge({ file("run4_b.manifest.part") }, file("run4.manifest")), 30);
+
+  TriggerManifest manifest(file("run4.manifest"));
+  BOOST_REQUIRE_EQUAL(manifest.get_entry_count(), 30);
+  BOOST_REQUIRE_EQUAL(manifest.get_file_names().size(), 2);
+  BOOST_REQUIRE_EQUAL(manifest.find(5)[0].file_name, "a_0000.hdf5");
+  BOOST_REQUIRE_EQUAL(manifest.find(15)[0].file_name, "b_0000.hdf5");
+  BOOST_REQUIRE_EQUAL(manifest.find(25)[0].file_name, "b_0000.hdf5");
+
+  // a journal that is merged again, e.g. after a crash before its deletion, adds no entries
+  {
+    TriggerManifestWriter writer(file("run4_b.manifest.part"), 10);
+    writer.add_file("b_0000.hdf5");
+    writer.add_entry(11, 0, 1000);
+  }
+  BOOST_REQUIRE_EQUAL(TriggerManifest::merge({ file("run4_b.manifest.part") }, file("run4.manifest")), 30);
+}
+
+BOOST_AUTO_TEST_CASE(TruncatedJournal)
+{
+  {
+    TriggerManifestWriter writer(file("run2_a.manifest.part"), 10);
+    writer.add_file("a_0000.hdf5");
+    for (uint64_t trigger = 1; trigger <= 25; ++trigger) { // NOLINT(build/unsigned)
+      writer.add_entry(trigger, 0, TriggerManifestWriter::s_unknown_offset);
+    }
+  }
+  // a crash in the middle of the last block loses that block only
+  auto journal_size = std::filesystem::file_size(file("run2_a.manifest.part"));
+  std::filesystem::resize_file(file("run2_a.manifest.part"), journal_size - 4);
+
+  BOOST_REQUIRE_EQUAL(TriggerManifest::merge({ file("run2_a.manifest.part") }, file("run2.manifest")), 20);
+  TriggerManifest manifest(file("run2.manifest"));
+  BOOST_REQUIRE_EQUAL(manifest.find(20).size(), 1);
+  BOOST_REQUIRE(manifest.find(21).empty());
+}
+
+BOOST_AUTO_TEST_CASE(InvalidFiles)
+{
+  BOOST_REQUIRE_THROW(TriggerManifest(file("missing.manifest")), TriggerManifestProblem);
+
+  std::ofstream(file("bogus.manifest")) << "this is not a manifest, but it is long enough for a header";
+  BOOST_REQUIRE_THROW(TriggerManifest(file("bogus.manifest")), TriggerManifestProblem);
+
+  BOOST_REQUIRE_THROW(TriggerManifest::merge({ file("missing.manifest.part") }, file("run3.manifest")),
+                      TriggerManifestProblem);
+  BOOST_REQUIRE_THROW(TriggerManifest::merge({ file("run3_a.manifest.part") }, file("bogus.manifest")),
+                      TriggerManifestProblem);
+
+  TriggerManifestWriter writer(file("run3_a.manifest.part"), 10);
+  BOOST_REQUIRE_THROW(writer.add_entry(1, 0, 0), TriggerManifestProblem);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
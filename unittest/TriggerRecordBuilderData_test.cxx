@@ -13,12 +13,52 @@
 
 #include "boost/test/unit_test.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <new>
 #include <thread>
 #include <utility>
 
 using namespace dunedaq::dfmodules;
 
+namespace {
+
+// heap allocations made by this test while s_count_allocations is set
+std::atomic<bool> s_count_allocations{ false };
+std::atomic<size_t> s_allocations{ 0 };
+
+} // namespace
+
+void*
+operator new(std::size_t size)
+{
+  if (s_count_allocations.load(std::memory_order_relaxed)) {
+    ++s_allocations;
+  }
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// GCC does not know that the replaced operator new allocates with malloc
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
 BOOST_AUTO_TEST_SUITE(TriggerRecordBuilderData_Test)
 
 BOOST_AUTO_TEST_CASE(CopyAndMoveSemantics)
@@ -108,8 +148,12 @@ BOOST_AUTO_TEST_CASE(Assignments)
 
   std::this_thread::sleep_for(std::chrono::milliseconds(50));
 
-  trbd.complete_assignment(1, [](nlohmann::json&) {});
+  trbd.complete_assignment(1, [](TriggerRecordBuilderMetadata& metadata, const AssignedTriggerDecision&) {
+    metadata.completed_trigger_decisions += 10;
+  });
   BOOST_REQUIRE_EQUAL(trbd.used_slots(), 0);
+  BOOST_REQUIRE_EQUAL(trbd.get_metadata().last_completed_trigger_number, 1);
+  BOOST_REQUIRE_EQUAL(trbd.get_metadata().completed_trigger_decisions, 11);
 
   auto latency =
     std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - assignment->assigned_time)
@@ -127,7 +171,83 @@ BOOST_AUTO_TEST_CASE(Assignments)
   auto remnants = trbd.flush();
   BOOST_REQUIRE_EQUAL(trbd.used_slots(), 0);
   BOOST_REQUIRE_EQUAL(remnants.size(), 1);
-  
+  BOOST_REQUIRE_EQUAL(trbd.get_metadata().completed_trigger_decisions, 0);
+}
+
+BOOST_AUTO_TEST_CASE(PooledAssignments)
+{
+  dunedaq::dfmessages::TriggerDecision td;
+  td.run_number = 2;
+  td.readout_type = dunedaq::dfmessages::ReadoutType::kLocalized;
+  td.components.resize(3);
+
+  TriggerRecordBuilderData trbd("a_dataflow_application_connection", 10);
+
+  // assignments that are still referenced are not reused
+  td.trigger_number = 1;
+  auto first = trbd.make_assignment(td);
+  td.trigger_number = 2;
+  auto second = trbd.make_assignment(std::move(td));
+  BOOST_REQUIRE(first.get() != second.get());
+  BOOST_REQUIRE_EQUAL(first->decision.trigger_number, 1);
+  BOOST_REQUIRE_EQUAL(second->decision.trigger_number, 2);
+  BOOST_REQUIRE_EQUAL(second->decision.components.size(), 3);
+  BOOST_REQUIRE_EQUAL(trbd.pool_size(), 2);
+
+  // released assignments are
+  auto* first_address = first.get();
+  first.reset();
+  dunedaq::dfmessages::TriggerDecision another_td;
+  another_td.trigger_number = 3;
+  auto third = trbd.make_assignment(another_td);
+  BOOST_REQUIRE_EQUAL(third.get(), first_address);
+  BOOST_REQUIRE_EQUAL(third->decision.trigger_number, 3);
+  BOOST_REQUIRE_EQUAL(third->connection_name, "a_dataflow_application_connection");
+  BOOST_REQUIRE_EQUAL(trbd.pool_size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(SteadyStateAllocations)
+{
+  const size_t in_flight = 5;
+  dunedaq::dfmessages::TriggerDecision td;
+  td.run_number = 2;
+  td.readout_type = dunedaq::dfmessages::ReadoutType::kLocalized;
+  td.components.resize(4);
+
+  TriggerRecordBuilderData trbd("a_dataflow_application_connection", 2 * in_flight);
+  auto metadata_fun = [](TriggerRecordBuilderMetadata& metadata, const AssignedTriggerDecision& assignment) {
+    metadata.last_completed_trigger_number = assignment.decision.trigger_number;
+  };
+
+  // the same steps as the DFO: the decision is moved into the assignment, handed over to the
+  // transport (which gives the next decision back in the same memory here), and completed by a token
+  auto cycle = [&](dunedaq::daqdataformats::trigger_number_t trigger_number) {
+    td.trigger_number = trigger_number;
+    auto assignment = trbd.make_assignment(std::move(td));
+    td = std::move(assignment->decision);
+    trbd.add_assignment(assignment);
+    if (trigger_number > in_flight) {
+      trbd.complete_assignment(trigger_number - in_flight, metadata_fun);
+    }
+  };
+
+  dunedaq::daqdataformats::trigger_number_t trigger_number = 1;
+  for (; trigger_number <= 10 * in_flight; ++trigger_number) {
+    cycle(trigger_number);
+  }
+  auto pool_size = trbd.pool_size();
+
+  s_allocations = 0;
+  s_count_allocations = true;
+  for (size_t i = 0; i < 10000; ++i, ++trigger_number) {
+    cycle(trigger_number);
+  }
+  s_count_allocations = false;
+
+  BOOST_REQUIRE_EQUAL(s_allocations.load(), 0);
+  BOOST_REQUIRE_EQUAL(trbd.pool_size(), pool_size);
+  BOOST_REQUIRE_EQUAL(trbd.used_slots(), in_flight);
+  BOOST_REQUIRE_EQUAL(trbd.get_metadata().last_completed_trigger_number, trigger_number - 1 - in_flight);
 }
 
 BOOST_AUTO_TEST_CASE(Exceptions)
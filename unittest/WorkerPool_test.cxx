@@ -0,0 +1,60 @@
+/**
+ * @file WorkerPool_test.cxx Test application that tests and demonstrates
+ * the functionality of the WorkerPool class.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "dfmodules/WorkerPool.hpp"
+
+#define BOOST_TEST_MODULE WorkerPool_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq::dfmodules;
+
+BOOST_AUTO_TEST_SUITE(WorkerPool_test)
+
+BOOST_AUTO_TEST_CASE(RunTasks)
+{
+  WorkerPool pool(4, "test");
+  BOOST_REQUIRE_EQUAL(pool.get_thread_count(), 4);
+
+  std::atomic<int> sum{ 0 };
+  std::vector<std::future<void>> futures;
+  for (int i = 1; i <= 1000; ++i) {
+    futures.push_back(pool.submit([&sum, i]() { sum += i; }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+  BOOST_REQUIRE_EQUAL(sum.load(), 500500);
+}
+
+BOOST_AUTO_TEST_CASE(Exception)
+{
+  WorkerPool pool(1, "test");
+  auto future = pool.submit([]() { throw std::runtime_error("task failed"); });
+  BOOST_REQUIRE_THROW(future.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(DrainAtDestruction)
+{
+  std::atomic<int> count{ 0 };
+  {
+    WorkerPool pool(2, "test");
+    for (int i = 0; i < 100; ++i) {
+      pool.submit([&count]() { ++count; });
+    }
+  }
+  BOOST_REQUIRE_EQUAL(count.load(), 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()